@@ -0,0 +1,81 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/consensushash.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/sp.h>
+#include <counoscore/tally.h>
+#include <util/system.h>
+
+#include <tinyformat.h>
+#include <uint256.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+//! Property database created by the benchmark, if Counos Core isn't initialized
+static CMPSPInfo* pDbSpInfoOwned = nullptr;
+
+static void SetupConsensusHashState()
+{
+    if (!pDbSpInfo) pDbSpInfo = pDbSpInfoOwned = new CMPSPInfo(GetDataDir() / "COUNOS_spinfo", true);
+
+    LOCK(cs_tally);
+    for (int i = 0; i < 100000; ++i) {
+        const std::string address = strprintf("address%d", i);
+        update_tally_map(address, COUNOS_PROPERTY_MSC, 1000 + i, BALANCE);
+        update_tally_map(address, COUNOS_PROPERTY_TMSC, 1000 + i, BALANCE);
+    }
+}
+
+static void TeardownConsensusHashState()
+{
+    {
+        LOCK(cs_tally);
+        mp_tally_map.clear();
+        mp_property_holders.clear();
+        mp_property_totals.clear();
+        addressTable.Clear();
+        ClearStateHash(STATEHASH_BALANCES);
+    }
+    if (pDbSpInfoOwned) {
+        delete pDbSpInfoOwned;
+        pDbSpInfoOwned = nullptr;
+        pDbSpInfo = nullptr;
+    }
+}
+
+// Legacy consensus hash over 100k addresses, which sorts and formats the whole state
+static void CounosConsensusHashLegacy(benchmark::State& state)
+{
+    SetupConsensusHashState();
+
+    while (state.KeepRunning()) {
+        uint256 hash = GetConsensusHash();
+        assert(!hash.IsNull());
+    }
+
+    TeardownConsensusHashState();
+}
+
+// Incrementally maintained state hash over the same state
+static void CounosConsensusHashIncremental(benchmark::State& state)
+{
+    SetupConsensusHashState();
+
+    while (state.KeepRunning()) {
+        uint256 hash = GetStateHash();
+        assert(!hash.IsNull());
+    }
+
+    TeardownConsensusHashState();
+}
+
+BENCHMARK(CounosConsensusHashLegacy, 2);
+BENCHMARK(CounosConsensusHashIncremental, 200);
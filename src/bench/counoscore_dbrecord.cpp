@@ -0,0 +1,57 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/dbbase.h>
+#include <counoscore/dbtxlist.h>
+
+#include <streams.h>
+#include <tinyformat.h>
+
+#include <leveldb/slice.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+static const int RECORDS_PER_RUN = 1000;
+
+// Decodes transaction list records stored in the legacy "valid:block:type:value" format.
+static void CounosTxListRecordLegacy(benchmark::State& state)
+{
+    std::vector<std::string> values;
+    for (int i = 0; i < RECORDS_PER_RUN; ++i) {
+        values.push_back(strprintf("%u:%d:%u:%lu", 1, 500000 + i, 25, 1000000000000ULL + i));
+    }
+
+    while (state.KeepRunning()) {
+        for (const std::string& value : values) {
+            CMPTxListRecord record;
+            bool fDecoded = DecodeDBRecord(leveldb::Slice(value), record);
+            assert(fDecoded);
+        }
+    }
+}
+
+// Decodes transaction list records stored as serialized binary records.
+static void CounosTxListRecordBinary(benchmark::State& state)
+{
+    std::vector<std::string> values;
+    for (int i = 0; i < RECORDS_PER_RUN; ++i) {
+        const CDataStream ssValue = EncodeDBRecord(CMPTxListRecord(true, 500000 + i, 25, 1000000000000ULL + i));
+        values.push_back(ssValue.str());
+    }
+
+    while (state.KeepRunning()) {
+        for (const std::string& value : values) {
+            CMPTxListRecord record;
+            bool fDecoded = DecodeDBRecord(leveldb::Slice(value), record);
+            assert(fDecoded);
+        }
+    }
+}
+
+BENCHMARK(CounosTxListRecordLegacy, 500);
+BENCHMARK(CounosTxListRecordBinary, 500);
@@ -0,0 +1,126 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/addresstable.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/mdex.h>
+#include <counoscore/sp.h>
+#include <counoscore/tally.h>
+#include <arith_uint256.h>
+#include <util/system.h>
+
+#include <tinyformat.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mastercore;
+
+static const uint32_t MDEX_PROPERTY_FOR_SALE = 3;
+static const uint32_t MDEX_PAIR_COUNT = 20;
+static const int64_t MDEX_PRICE_LEVELS = 1000;
+
+// Matches one crossing order at a time against a book with 20 pairs of the
+// same property for sale, each with 1000 resting price levels. The offers of
+// the matched pair don't cross, while those of the other pairs are cheaper.
+static void CounosMetaDExMatch(benchmark::State& state)
+{
+    // the databases are only created here, if Counos Core isn't initialized
+    CMPSPInfo* pDbSpInfoOwned = nullptr;
+    CMPTradeList* pDbTradeListOwned = nullptr;
+    if (!pDbSpInfo) pDbSpInfo = pDbSpInfoOwned = new CMPSPInfo(GetDataDir() / "COUNOS_spinfo", true);
+    if (!pDbTradeList) pDbTradeList = pDbTradeListOwned = new CMPTradeList(GetDataDir() / "COUNOS_tradelist", true);
+
+    LOCK(cs_tally);
+    unsigned int idx = 0;
+    update_tally_map("seller", MDEX_PROPERTY_FOR_SALE, MDEX_PAIR_COUNT * MDEX_PRICE_LEVELS * MDEX_PRICE_LEVELS * 2, BALANCE);
+    for (uint32_t pair = 0; pair < MDEX_PAIR_COUNT; ++pair) {
+        for (int64_t level = 0; level < MDEX_PRICE_LEVELS; ++level) {
+            ++idx;
+            int rc;
+            if (pair == 0) {
+                rc = MetaDEx_ADD("seller", MDEX_PROPERTY_FOR_SALE, 2, 1, COUNOS_PROPERTY_MSC, 4 + level, ArithToUint256(arith_uint256(idx)), idx);
+            } else {
+                rc = MetaDEx_ADD("seller", MDEX_PROPERTY_FOR_SALE, MDEX_PRICE_LEVELS + level, 1, 4 + pair, pair, ArithToUint256(arith_uint256(idx)), idx);
+            }
+            assert(rc == 0);
+        }
+    }
+
+    while (state.KeepRunning()) {
+        // a resting offer at the best price, which is then taken entirely
+        ++idx;
+        update_tally_map("maker", MDEX_PROPERTY_FOR_SALE, 1, BALANCE);
+        MetaDEx_ADD("maker", MDEX_PROPERTY_FOR_SALE, 1, 2, COUNOS_PROPERTY_MSC, 1, ArithToUint256(arith_uint256(idx)), idx);
+        ++idx;
+        update_tally_map("taker", COUNOS_PROPERTY_MSC, 1, BALANCE);
+        MetaDEx_ADD("taker", COUNOS_PROPERTY_MSC, 1, 2, MDEX_PROPERTY_FOR_SALE, 1, ArithToUint256(arith_uint256(idx)), idx);
+    }
+    assert(get_Prices(MDEX_PROPERTY_FOR_SALE, COUNOS_PROPERTY_MSC)->size() == (size_t) MDEX_PRICE_LEVELS);
+
+    MetaDEx_CLEAR();
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    addressTable.Clear();
+    if (pDbTradeListOwned) {
+        delete pDbTradeListOwned;
+        pDbTradeList = nullptr;
+    }
+    if (pDbSpInfoOwned) {
+        delete pDbSpInfoOwned;
+        pDbSpInfo = nullptr;
+    }
+}
+
+//! Amounts of orders, as used to derive their prices
+static std::vector<std::pair<int64_t, int64_t> > PriceAmounts()
+{
+    std::vector<std::pair<int64_t, int64_t> > amounts;
+    for (int64_t i = 1; i <= 1000; ++i) {
+        amounts.push_back(std::make_pair(i * 7919 % 100000 + 1, i * 104729 % 100000000 + 1));
+    }
+    return amounts;
+}
+
+// Compares the prices of 1000 orders with the price of a new order, as done
+// while matching, with the fixed width prices.
+static void CounosMetaDExPriceCompare(benchmark::State& state)
+{
+    const std::vector<std::pair<int64_t, int64_t> > amounts = PriceAmounts();
+    const price_t inversePrice(50000, 50000000);
+    int64_t nCrossing = 0;
+
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < amounts.size(); ++i) {
+            if (price_t(amounts[i].first, amounts[i].second) <= inversePrice) ++nCrossing;
+        }
+    }
+    assert(nCrossing > 0);
+}
+
+// The same comparisons with the rational_t reference.
+static void CounosMetaDExPriceCompareRational(benchmark::State& state)
+{
+    const std::vector<std::pair<int64_t, int64_t> > amounts = PriceAmounts();
+    const rational_t inversePrice(50000, 50000000);
+    int64_t nCrossing = 0;
+
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < amounts.size(); ++i) {
+            if (rational_t(amounts[i].first, amounts[i].second) <= inversePrice) ++nCrossing;
+        }
+    }
+    assert(nCrossing > 0);
+}
+
+BENCHMARK(CounosMetaDExMatch, 500);
+BENCHMARK(CounosMetaDExPriceCompare, 1000);
+BENCHMARK(CounosMetaDExPriceCompareRational, 100);
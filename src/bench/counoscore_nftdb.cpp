@@ -0,0 +1,43 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/nftdb.h>
+#include <util/system.h>
+
+#include <tinyformat.h>
+
+#include <assert.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+static const uint32_t NFT_PROPERTY = 3;
+static const int64_t NFT_OWNERS = 1000;
+static const int64_t NFT_TOKENS = 20000;
+
+// Moves single tokens forth and back and looks up the tokens of an owner, in a collection,
+// which is fragmented into one range per token across many owners.
+static void CounosNonFungibleTokensMove(benchmark::State& state)
+{
+    std::unique_ptr<CMPNonFungibleTokensDB> db{new CMPNonFungibleTokensDB(GetDataDir() / "COUNOS_nftdb_bench", true)};
+    db->CreateNonFungibleTokens(NFT_PROPERTY, NFT_TOKENS, "owner0", "");
+    for (int64_t tokenId = 2; tokenId <= NFT_TOKENS; tokenId += 2) {
+        db->MoveNonFungibleTokens(NFT_PROPERTY, tokenId, tokenId, "owner0", strprintf("owner%d", tokenId % NFT_OWNERS));
+    }
+
+    int64_t tokenId = 2;
+    while (state.KeepRunning()) {
+        const std::string from = strprintf("owner%d", tokenId % NFT_OWNERS);
+        bool moved = db->MoveNonFungibleTokens(NFT_PROPERTY, tokenId, tokenId, from, "receiver");
+        moved &= db->MoveNonFungibleTokens(NFT_PROPERTY, tokenId, tokenId, "receiver", from);
+        assert(moved);
+        assert(!db->GetAddressNonFungibleTokens(NFT_PROPERTY, from).empty());
+        tokenId = (tokenId < NFT_TOKENS) ? tokenId + 2 : 2;
+    }
+}
+
+BENCHMARK(CounosNonFungibleTokensMove, 1000);
@@ -0,0 +1,57 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/sp.h>
+#include <counoscore/sto.h>
+#include <counoscore/tally.h>
+#include <util/system.h>
+
+#include <tinyformat.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+static const uint32_t STO_PROPERTY = 3;
+
+// Distributes tokens to the holders of one property, with 1M tallies in the
+// state, of which only every 1000th address holds the distributed property.
+static void CounosStoGetReceivers(benchmark::State& state)
+{
+    // the property database is only created here, if Counos Core isn't initialized
+    CMPSPInfo* pDbSpInfoOwned = nullptr;
+    if (!pDbSpInfo) pDbSpInfo = pDbSpInfoOwned = new CMPSPInfo(GetDataDir() / "COUNOS_spinfo", true);
+    {
+        LOCK(cs_tally);
+        for (int i = 0; i < 1000000; ++i) {
+            const std::string address = strprintf("address%d", i);
+            uint32_t propertyId = (i % 1000 == 0) ? STO_PROPERTY : COUNOS_PROPERTY_MSC;
+            update_tally_map(address, propertyId, 1000 + i, BALANCE);
+        }
+    }
+
+    while (state.KeepRunning()) {
+        OwnerAddrType receivers = STO_GetReceivers("address0", STO_PROPERTY, 100000);
+        assert(!receivers.empty());
+    }
+
+    {
+        LOCK(cs_tally);
+        mp_tally_map.clear();
+        mp_property_holders.clear();
+        mp_property_totals.clear();
+        addressTable.Clear();
+    }
+    if (pDbSpInfoOwned) {
+        delete pDbSpInfoOwned;
+        pDbSpInfo = nullptr;
+    }
+}
+
+BENCHMARK(CounosStoGetReceivers, 200);
@@ -0,0 +1,147 @@
+// Copyright (c) 2020 The CounosH Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/tally.h>
+#include <sync.h>
+
+#include <tinyformat.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mastercore;
+
+static const int TALLY_ADDRESSES = 100000;
+static const int TALLY_MAP_ADDRESSES = 10000;
+
+//! Most addresses hold one to three properties
+static uint32_t GetNumberOfProperties(int n)
+{
+    return 1 + (n % 3);
+}
+
+static void FillTallies(std::vector<CMPTally>& tallies)
+{
+    tallies.clear();
+    tallies.resize(TALLY_ADDRESSES);
+    for (int n = 0; n < TALLY_ADDRESSES; ++n) {
+        for (uint32_t i = 0; i < GetNumberOfProperties(n); ++i) {
+            tallies[n].updateMoney(1 + ((n + i * 7) % 50), 1000 + n, BALANCE);
+        }
+    }
+}
+
+// Creates tallies for 100k addresses, each holding one to three properties.
+static void CounosTallyUpdate(benchmark::State& state)
+{
+    std::vector<CMPTally> tallies;
+    while (state.KeepRunning()) {
+        FillTallies(tallies);
+    }
+}
+
+// Iterates over the balances of 100k addresses with the internal iterator.
+static void CounosTallyIterate(benchmark::State& state)
+{
+    std::vector<CMPTally> tallies;
+    FillTallies(tallies);
+
+    while (state.KeepRunning()) {
+        int64_t total = 0;
+        for (std::vector<CMPTally>::iterator it = tallies.begin(); it != tallies.end(); ++it) {
+            CMPTally& tally = *it;
+            uint32_t propertyId = 0;
+            tally.init();
+            while (0 != (propertyId = tally.next())) {
+                total += tally.getMoney(propertyId, BALANCE);
+            }
+        }
+        assert(total > 0);
+    }
+}
+
+// Iterates over the balance records of 100k addresses, without changing the tallies.
+static void CounosTallyIterateConst(benchmark::State& state)
+{
+    std::vector<CMPTally> tallies;
+    FillTallies(tallies);
+
+    while (state.KeepRunning()) {
+        int64_t total = 0;
+        for (std::vector<CMPTally>::const_iterator it = tallies.begin(); it != tallies.end(); ++it) {
+            const CMPTally& tally = *it;
+            for (CMPTally::const_iterator pit = tally.begin(); pit != tally.end(); ++pit) {
+                total += pit->balance[BALANCE];
+            }
+        }
+        assert(total > 0);
+    }
+}
+
+static void FillAddresses(std::vector<std::string>& addresses)
+{
+    for (int n = 0; n < TALLY_MAP_ADDRESSES; ++n) {
+        addresses.push_back(strprintf("1CounosTallyBenchAddress%010d", n));
+    }
+}
+
+static void ClearTallyMap()
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    addressTable.Clear();
+}
+
+// Credits and debits 10k addresses of typical length in the global tally map.
+static void CounosUpdateTallyMap(benchmark::State& state)
+{
+    std::vector<std::string> addresses;
+    FillAddresses(addresses);
+
+    while (state.KeepRunning()) {
+        LOCK(cs_tally);
+        for (std::vector<std::string>::const_iterator it = addresses.begin(); it != addresses.end(); ++it) {
+            update_tally_map(*it, COUNOS_PROPERTY_MSC, 1000, BALANCE);
+            update_tally_map(*it, COUNOS_PROPERTY_MSC, -1000, BALANCE);
+        }
+    }
+
+    ClearTallyMap();
+}
+
+// Looks up the balances of 10k addresses of typical length in the global tally map.
+static void CounosGetTokenBalance(benchmark::State& state)
+{
+    std::vector<std::string> addresses;
+    FillAddresses(addresses);
+    {
+        LOCK(cs_tally);
+        for (std::vector<std::string>::const_iterator it = addresses.begin(); it != addresses.end(); ++it) {
+            update_tally_map(*it, COUNOS_PROPERTY_MSC, 1000, BALANCE);
+        }
+    }
+
+    while (state.KeepRunning()) {
+        int64_t total = 0;
+        for (std::vector<std::string>::const_iterator it = addresses.begin(); it != addresses.end(); ++it) {
+            total += GetAvailableTokenBalance(*it, COUNOS_PROPERTY_MSC);
+        }
+        assert(total > 0);
+    }
+
+    ClearTallyMap();
+}
+
+BENCHMARK(CounosTallyUpdate, 5);
+BENCHMARK(CounosTallyIterate, 20);
+BENCHMARK(CounosTallyIterateConst, 20);
+BENCHMARK(CounosUpdateTallyMap, 1);
+BENCHMARK(CounosGetTokenBalance, 100);
@@ -0,0 +1,220 @@
+#include <counoscore/addressindex.h>
+
+#include <counoscore/counoscore.h>
+#include <counoscore/dbstolist.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/dbtransaction.h>
+
+#include <chain.h>
+#include <dbwrapper.h>
+#include <primitives/block.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/memory.h>
+#include <util/system.h>
+
+#include <stdint.h>
+
+#include <ios>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using mastercore::pDbStoList;
+using mastercore::pDbTradeList;
+using mastercore::pDbTransaction;
+
+/* Keys of the address index have the type [DB_ADDRESS, address, uint32 height (BE), uint32 position (BE)],
+ * and the value is the txid. The height and position are represented as big-endian, so the transactions
+ * of an address are sorted by block and position.
+ *
+ * Keys of the list of addresses per block have the type [DB_BLOCK_ADDRESSES, uint32 height (BE)], and
+ * the value holds the addresses and positions of the entries, which were added with the block.
+ */
+constexpr char DB_ADDRESS = 'a';
+constexpr char DB_BLOCK_ADDRESSES = 'h';
+
+std::unique_ptr<CCounosAddressIndex> g_counos_addressindex;
+
+namespace {
+
+//! Addresses and positions of the entries of a block
+typedef std::vector<std::pair<std::string, uint32_t> > BlockAddresses;
+
+struct DBAddressKey {
+    std::string address;
+    int height;
+    uint32_t position;
+
+    DBAddressKey() : height(0), position(0) {}
+    DBAddressKey(const std::string& address_in, int height_in, uint32_t position_in)
+        : address(address_in), height(height_in), position(position_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS);
+        s << address;
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, position);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_ADDRESS) {
+            throw std::ios_base::failure("Invalid format for Counos address index DB address key");
+        }
+        s >> address;
+        height = ser_readdata32be(s);
+        position = ser_readdata32be(s);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_ADDRESSES);
+        ser_writedata32be(s, height);
+    }
+};
+
+} // namespace
+
+/**
+ * Access to the Counos address index database (indexes/counosaddress/)
+ */
+class CCounosAddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Adds the removal of the entries of a block to the batch.
+    bool EraseBlock(CDBBatch& batch, int height) const;
+};
+
+CCounosAddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "counosaddress", n_cache_size, f_memory, f_wipe)
+{}
+
+bool CCounosAddressIndex::DB::EraseBlock(CDBBatch& batch, int height) const
+{
+    BlockAddresses addresses;
+    if (!Read(DBHeightKey(height), addresses)) {
+        // nothing was indexed at this height; anything else is a read failure
+        return !Exists(DBHeightKey(height));
+    }
+
+    for (const auto& entry : addresses) {
+        batch.Erase(DBAddressKey(entry.first, height, entry.second));
+    }
+    batch.Erase(DBHeightKey(height));
+    return true;
+}
+
+CCounosAddressIndex::CCounosAddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<CCounosAddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+CCounosAddressIndex::~CCounosAddressIndex() {}
+
+BaseIndex::DB& CCounosAddressIndex::GetDB() const { return *m_db; }
+
+bool CCounosAddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // entries of a block, which was indexed at this height before, are replaced
+    CDBBatch batch(*m_db);
+    if (!m_db->EraseBlock(batch, pindex->nHeight)) {
+        return error("%s: cannot read the addresses of block %d", __func__, pindex->nHeight);
+    }
+
+    BlockAddresses blockAddresses;
+    {
+        LOCK(cs_tally);
+        if (nullptr == pDbTransaction || nullptr == pDbTradeList || nullptr == pDbStoList) {
+            return error("%s: Counos Core databases are not available", __func__);
+        }
+
+        const uint256 blockHash = pindex->GetBlockHash();
+        std::set<std::string> addresses;
+        std::vector<std::string> recipients;
+        CDecodedTransactionRecord decoded;
+        for (const auto& tx : block.vtx) {
+            // the transactions are read only once, so they are not kept in memory
+            const uint256& txid = tx->GetHash();
+            if (!pDbTransaction->FetchDecodedTransaction(txid, decoded, false)) continue;
+            if (decoded.blockHash != blockHash) continue;
+
+            addresses.clear();
+            addresses.insert(decoded.sender);
+            addresses.insert(decoded.reference);
+            for (const auto& stm : decoded.stmAddresses) {
+                addresses.insert(stm.second);
+            }
+
+            // only valid transactions distribute tokens or match orders
+            if (decoded.nProcessingResult == 0) {
+                pDbTradeList->getTradeCounterparties(txid, addresses);
+                recipients.clear();
+                pDbStoList->getRecipientAddresses(txid, recipients);
+                addresses.insert(recipients.begin(), recipients.end());
+            }
+
+            for (const std::string& address : addresses) {
+                if (address.empty()) continue;
+                batch.Write(DBAddressKey(address, pindex->nHeight, decoded.nPosition), txid);
+                blockAddresses.emplace_back(address, decoded.nPosition);
+            }
+        }
+    }
+
+    if (!blockAddresses.empty()) {
+        batch.Write(DBHeightKey(pindex->nHeight), blockAddresses);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool CCounosAddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // remove the entries of the disconnected blocks, so they don't show up in lookups
+    CDBBatch batch(*m_db);
+    for (int height = new_tip->nHeight + 1; height <= current_tip->nHeight; ++height) {
+        if (!m_db->EraseBlock(batch, height)) {
+            return error("%s: cannot read the addresses of block %d", __func__, height);
+        }
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool CCounosAddressIndex::FindTransactions(const std::string& address, int nStartHeight, uint32_t nStartPosition, int nEndHeight,
+                                           size_t nMaxEntries, std::vector<CCounosAddressIndexEntry>& entries) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBAddressKey key;
+    for (db_it->Seek(DBAddressKey(address, nStartHeight, nStartPosition)); db_it->Valid() && entries.size() < nMaxEntries; db_it->Next()) {
+        // the entries of the address end with a key of another address or type
+        if (!db_it->GetKey(key) || key.address != address || key.height > nEndHeight) break;
+
+        CCounosAddressIndexEntry entry;
+        entry.nHeight = key.height;
+        entry.nPosition = key.position;
+        if (!db_it->GetValue(entry.txid)) {
+            return error("%s: cannot read the address index entry of %s at block %d", __func__, address, key.height);
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
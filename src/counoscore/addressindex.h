@@ -0,0 +1,84 @@
+#ifndef COUNOSH_COUNOSCORE_ADDRESSINDEX_H
+#define COUNOSH_COUNOSCORE_ADDRESSINDEX_H
+
+#include <index/base.h>
+#include <uint256.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+//! Default for -counosaddressindex
+static const bool DEFAULT_COUNOS_ADDRESS_INDEX = false;
+//! Max memory allocated to the Counos address index cache (MiB)
+static const int64_t nMaxCounosAddressIndexCache = 1024;
+
+/** A Counos transaction, which involves an address. */
+struct CCounosAddressIndexEntry
+{
+    int nHeight;
+    uint32_t nPosition;
+    uint256 txid;
+};
+
+/**
+ * Index of the Counos transactions of all addresses.
+ *
+ * For every Counos transaction, the sender, the reference address, the Send To
+ * Many receivers, the Send To Owners recipients and the counterparties of
+ * matched trades are indexed with key "address|height|position", so the
+ * transactions of an address are found with a prefix seek.
+ *
+ * The index is built from the Counos Core databases, which are updated, when a
+ * block is connected, before the index is notified about it. Entries of blocks,
+ * which are disconnected, are removed with the help of a list of the addresses
+ * indexed per block.
+ */
+class CCounosAddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "counosaddressindex"; }
+
+public:
+    /** Constructs the index, which becomes available to be queried. */
+    explicit CCounosAddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~CCounosAddressIndex() override;
+
+    /**
+     * Looks up the transactions of an address, ordered by block and position.
+     *
+     * @param[in]   address  The address to look up
+     * @param[in]   nStartHeight  The first block to include
+     * @param[in]   nStartPosition  The first position to include in the first block
+     * @param[in]   nEndHeight  The last block to include
+     * @param[in]   nMaxEntries  The maximum number of entries to return
+     * @param[out]  entries  The transactions, which involve the address
+     * @return  true if the index could be read
+     */
+    bool FindTransactions(const std::string& address, int nStartHeight, uint32_t nStartPosition, int nEndHeight,
+                          size_t nMaxEntries, std::vector<CCounosAddressIndexEntry>& entries) const;
+};
+
+/** The global index of the Counos transactions of all addresses. May be null. */
+extern std::unique_ptr<CCounosAddressIndex> g_counos_addressindex;
+
+#endif // COUNOSH_COUNOSCORE_ADDRESSINDEX_H
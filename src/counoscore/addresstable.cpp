@@ -0,0 +1,57 @@
+/**
+ * @file addresstable.cpp
+ *
+ * This file contains the table of interned addresses.
+ */
+
+#include <counoscore/addresstable.h>
+
+#include <assert.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Returns the identifier of an address, and interns the address, if it's new.
+ */
+AddressId CAddressTable::Intern(const std::string& address)
+{
+    std::pair<std::unordered_map<std::string, AddressId>::iterator, bool> ret;
+    ret = mapIds.insert(std::make_pair(address, static_cast<AddressId>(vAddresses.size())));
+    if (ret.second) {
+        // keys of unordered_map nodes are stable, even if the map is rehashed
+        vAddresses.push_back(&ret.first->first);
+    }
+    return ret.first->second;
+}
+
+/**
+ * Looks up the identifier of an address, without interning it.
+ */
+bool CAddressTable::Lookup(const std::string& address, AddressId& id) const
+{
+    std::unordered_map<std::string, AddressId>::const_iterator it = mapIds.find(address);
+    if (it == mapIds.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+/**
+ * Returns the address with the given identifier.
+ */
+const std::string& CAddressTable::GetAddress(AddressId id) const
+{
+    assert(id < vAddresses.size());
+    return *vAddresses[id];
+}
+
+/**
+ * Removes all addresses, which invalidates all identifiers.
+ */
+void CAddressTable::Clear()
+{
+    vAddresses.clear();
+    mapIds.clear();
+}
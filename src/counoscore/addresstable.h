@@ -0,0 +1,45 @@
+#ifndef COUNOSH_COUNOSCORE_ADDRESSTABLE_H
+#define COUNOSH_COUNOSCORE_ADDRESSTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! Compact identifier of an interned address
+typedef uint32_t AddressId;
+
+/** Table of interned addresses.
+ *
+ * The state maps are keyed by compact address identifiers instead of encoded
+ * addresses, so each address is stored and hashed only once. Identifiers are
+ * assigned in order of first use and stay valid until the table is cleared.
+ */
+class CAddressTable
+{
+private:
+    //! Identifiers by address
+    std::unordered_map<std::string, AddressId> mapIds;
+    //! Addresses by identifier, pointing to the keys of mapIds
+    std::vector<const std::string*> vAddresses;
+
+public:
+    /** Returns the identifier of an address, and interns the address, if it's new. */
+    AddressId Intern(const std::string& address);
+
+    /** Looks up the identifier of an address, without interning it. */
+    bool Lookup(const std::string& address, AddressId& id) const;
+
+    /** Returns the address with the given identifier. */
+    const std::string& GetAddress(AddressId id) const;
+
+    /** Returns the number of interned addresses. */
+    size_t size() const { return vAddresses.size(); }
+
+    /** Removes all addresses, which invalidates all identifiers. */
+    void Clear();
+};
+
+#endif // COUNOSH_COUNOSCORE_ADDRESSTABLE_H
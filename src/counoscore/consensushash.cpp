@@ -11,8 +11,13 @@
 #include <counoscore/log.h>
 #include <counoscore/parse_string.h>
 #include <counoscore/sp.h>
+#include <counoscore/tally.h>
 
 #include <arith_uint256.h>
+#include <clientversion.h>
+#include <crypto/muhash.h>
+#include <span.h>
+#include <streams.h>
 #include <uint256.h>
 
 #include <stdint.h>
@@ -156,16 +161,15 @@ uint256 GetConsensusHash()
     // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
     // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
     // Sort alphabetically first
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
+    std::map<std::string, const CMPTally*> tallyMapSorted;
+    for (std::unordered_map<AddressId, CMPTally>::const_iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
+        tallyMapSorted.insert(std::make_pair(addressTable.GetAddress(uoit->first), &uoit->second));
     }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
+    for (std::map<std::string, const CMPTally*>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
         const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
+        const CMPTally& tally = *my_it->second;
+        for (CMPTally::const_iterator pit = tally.begin(); pit != tally.end(); ++pit) {
+            uint32_t propertyId = pit->propertyId;
             std::string dataStr = GenerateConsensusString(tally, address, propertyId);
             if (dataStr.empty()) continue; // skip empty balances
             if (msc_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
@@ -281,7 +285,7 @@ uint256 GetMetaDExHash(const uint32_t propertyId)
 
     std::vector<std::pair<arith_uint256, std::string> > vecMetaDExTrades;
     for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyId == 0 || propertyId == my_it->first) {
+        if (propertyId == 0 || propertyId == my_it->first.first) {
             const md_PricesMap& prices = my_it->second;
             for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
                 const md_Set& indexes = it->second;
@@ -312,16 +316,15 @@ uint256 GetBalancesHash(const uint32_t hashPropertyId)
 
     LOCK(cs_tally);
 
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
+    std::map<std::string, const CMPTally*> tallyMapSorted;
+    for (std::unordered_map<AddressId, CMPTally>::const_iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
+        tallyMapSorted.insert(std::make_pair(addressTable.GetAddress(uoit->first), &uoit->second));
     }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
+    for (std::map<std::string, const CMPTally*>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
         const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
+        const CMPTally& tally = *my_it->second;
+        for (CMPTally::const_iterator pit = tally.begin(); pit != tally.end(); ++pit) {
+            uint32_t propertyId = pit->propertyId;
             if (propertyId != hashPropertyId) continue;
             std::string dataStr = GenerateConsensusString(tally, address, propertyId);
             if (dataStr.empty()) continue;
@@ -336,4 +339,217 @@ uint256 GetBalancesHash(const uint32_t hashPropertyId)
     return balancesHash;
 }
 
+//! Incrementally maintained hashes of the parts of the state
+static MuHash3072 stateHashParts[STATEHASH_PART_COUNT];
+
+//! Record type markers, to separate the records of the different parts of the state
+static const uint8_t STATEHASH_TAG_BALANCE = 'b';
+static const uint8_t STATEHASH_TAG_OFFER = 'o';
+static const uint8_t STATEHASH_TAG_ACCEPT = 'a';
+static const uint8_t STATEHASH_TAG_METADEX = 'm';
+static const uint8_t STATEHASH_TAG_CROWDSALE = 'c';
+
+// Serializes a balance record, returns false if all balances are empty
+static bool SerializeStateRecord(CDataStream& ssRecord, const CMPTally& tallyObj, const std::string& address, uint32_t propertyId)
+{
+    int64_t balance = tallyObj.getMoney(propertyId, BALANCE);
+    int64_t sellOfferReserve = tallyObj.getMoney(propertyId, SELLOFFER_RESERVE);
+    int64_t acceptReserve = tallyObj.getMoney(propertyId, ACCEPT_RESERVE);
+    int64_t metaDExReserve = tallyObj.getMoney(propertyId, METADEX_RESERVE);
+
+    if (!balance && !sellOfferReserve && !acceptReserve && !metaDExReserve) return false;
+
+    ssRecord << STATEHASH_TAG_BALANCE << address << propertyId;
+    ssRecord << balance << sellOfferReserve << acceptReserve << metaDExReserve;
+    return true;
+}
+
+// Serializes a DEx sell offer record
+static void SerializeStateRecord(CDataStream& ssRecord, const CMPOffer& offerObj, const std::string& seller)
+{
+    ssRecord << STATEHASH_TAG_OFFER << offerObj.getHash() << seller << offerObj.getProperty();
+    ssRecord << offerObj.getOfferAmountOriginal() << offerObj.getCCHDesiredOriginal();
+    ssRecord << offerObj.getMinFee() << offerObj.getBlockTimeLimit();
+}
+
+// Serializes a DEx accept record
+static void SerializeStateRecord(CDataStream& ssRecord, const CMPAccept& acceptObj, const std::string& buyer)
+{
+    ssRecord << STATEHASH_TAG_ACCEPT << acceptObj.getHash() << buyer << acceptObj.getAcceptAmount();
+    ssRecord << acceptObj.getAcceptAmountRemaining() << acceptObj.getAcceptBlock();
+}
+
+// Serializes a MetaDEx trade record
+static void SerializeStateRecord(CDataStream& ssRecord, const CMPMetaDEx& tradeObj)
+{
+    ssRecord << STATEHASH_TAG_METADEX << tradeObj.getHash() << tradeObj.getAddr() << tradeObj.getProperty();
+    ssRecord << tradeObj.getAmountForSale() << tradeObj.getDesProperty() << tradeObj.getAmountDesired();
+    ssRecord << tradeObj.getAmountRemaining();
+}
+
+// Serializes an active crowdsale record
+static void SerializeStateRecord(CDataStream& ssRecord, const CMPCrowd& crowdObj, const std::string& issuer)
+{
+    ssRecord << STATEHASH_TAG_CROWDSALE << issuer << crowdObj.getPropertyId() << crowdObj.getCurrDes();
+    ssRecord << crowdObj.getDeadline() << crowdObj.getUserCreated() << crowdObj.getIssuerCreated();
+}
+
+static void UpdateStateHashPart(MuHash3072& hash, const CDataStream& ssRecord, bool fInsert)
+{
+    Span<const unsigned char> record(reinterpret_cast<const unsigned char*>(ssRecord.data()), ssRecord.size());
+    if (fInsert) {
+        hash.Insert(record);
+    } else {
+        hash.Remove(record);
+    }
+}
+
+/**
+ * Adds or removes a balance record to or from the incremental state hash.
+ *
+ * Empty balance records are not part of the state hash, so the record must be
+ * removed before the balance is updated, and inserted again after the update.
+ */
+void UpdateStateHash(const CMPTally& tally, const std::string& address, uint32_t propertyId, bool fInsert)
+{
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+    if (!SerializeStateRecord(ssRecord, tally, address, propertyId)) return;
+
+    LOCK(cs_tally);
+    UpdateStateHashPart(stateHashParts[STATEHASH_BALANCES], ssRecord, fInsert);
+}
+
+/** Adds or removes a DEx sell offer to or from the incremental state hash. */
+void UpdateStateHash(const CMPOffer& offer, const std::string& seller, bool fInsert)
+{
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+    SerializeStateRecord(ssRecord, offer, seller);
+
+    LOCK(cs_tally);
+    UpdateStateHashPart(stateHashParts[STATEHASH_DEX_OFFERS], ssRecord, fInsert);
+}
+
+/** Adds or removes a DEx accept to or from the incremental state hash. */
+void UpdateStateHash(const CMPAccept& accept, const std::string& buyer, bool fInsert)
+{
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+    SerializeStateRecord(ssRecord, accept, buyer);
+
+    LOCK(cs_tally);
+    UpdateStateHashPart(stateHashParts[STATEHASH_DEX_ACCEPTS], ssRecord, fInsert);
+}
+
+/** Adds or removes a MetaDEx trade to or from the incremental state hash. */
+void UpdateStateHash(const CMPMetaDEx& trade, bool fInsert)
+{
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+    SerializeStateRecord(ssRecord, trade);
+
+    LOCK(cs_tally);
+    UpdateStateHashPart(stateHashParts[STATEHASH_METADEX], ssRecord, fInsert);
+}
+
+/**
+ * Adds or removes an active crowdsale to or from the incremental state hash.
+ *
+ * The tokens created by a crowdsale are part of the record, so the record must be
+ * removed before a participation is credited, and inserted again afterwards.
+ */
+void UpdateStateHash(const CMPCrowd& crowd, const std::string& issuer, bool fInsert)
+{
+    CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+    SerializeStateRecord(ssRecord, crowd, issuer);
+
+    LOCK(cs_tally);
+    UpdateStateHashPart(stateHashParts[STATEHASH_CROWDSALES], ssRecord, fInsert);
+}
+
+/** Resets a part of the incremental state hash, when the underlying state is cleared. */
+void ClearStateHash(StateHashPart part)
+{
+    LOCK(cs_tally);
+    stateHashParts[part] = MuHash3072();
+}
+
+/**
+ * Obtains the incrementally maintained hash of balances, DEx, MetaDEx and crowdsale state.
+ *
+ * Each balance record, DEx sell offer, DEx accept, MetaDEx trade and active crowdsale is added to a
+ * MuHash set, whenever it is created or updated, and removed, once it is updated or
+ * removed. Obtaining the hash therefore doesn't depend on the size of the state.
+ *
+ * Property issuers are not covered, and the result is not compatible
+ * with GetConsensusHash(), which remains in use for checkpoints.
+ */
+uint256 GetStateHash()
+{
+    LOCK(cs_tally);
+
+    MuHash3072 stateHash;
+    for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+        stateHash *= stateHashParts[part];
+    }
+
+    uint256 hash;
+    stateHash.Finalize(hash);
+    return hash;
+}
+
+/**
+ * Calculates the state hash from scratch, used to verify the incremental state hash.
+ */
+uint256 GetStateHashFromScratch()
+{
+    LOCK(cs_tally);
+
+    MuHash3072 stateHash;
+
+    for (std::unordered_map<AddressId, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        const std::string& address = addressTable.GetAddress(it->first);
+        const CMPTally& tally = it->second;
+        for (CMPTally::const_iterator pit = tally.begin(); pit != tally.end(); ++pit) {
+            uint32_t propertyId = pit->propertyId;
+            CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+            if (!SerializeStateRecord(ssRecord, tally, address, propertyId)) continue;
+            UpdateStateHashPart(stateHash, ssRecord, true);
+        }
+    }
+
+    for (OfferMap::const_iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
+        const std::string& sellCombo = it->first;
+        CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+        SerializeStateRecord(ssRecord, it->second, sellCombo.substr(0, sellCombo.find('-')));
+        UpdateStateHashPart(stateHash, ssRecord, true);
+    }
+
+    for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
+        const std::string& acceptCombo = it->first;
+        CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+        SerializeStateRecord(ssRecord, it->second, acceptCombo.substr(acceptCombo.find('+') + 1));
+        UpdateStateHashPart(stateHash, ssRecord, true);
+    }
+
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PricesMap& prices = my_it->second;
+        for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const md_Set& indexes = it->second;
+            for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+                SerializeStateRecord(ssRecord, *it);
+                UpdateStateHashPart(stateHash, ssRecord, true);
+            }
+        }
+    }
+
+    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
+        CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+        SerializeStateRecord(ssRecord, it->second, it->first);
+        UpdateStateHashPart(stateHash, ssRecord, true);
+    }
+
+    uint256 hash;
+    stateHash.Finalize(hash);
+    return hash;
+}
+
 } // namespace mastercore
@@ -3,8 +3,27 @@
 
 #include <uint256.h>
 
+#include <stdint.h>
+#include <string>
+
+class CMPAccept;
+class CMPCrowd;
+class CMPMetaDEx;
+class CMPOffer;
+class CMPTally;
+
 namespace mastercore
 {
+//! Parts of the state covered by the incremental state hash
+enum StateHashPart {
+    STATEHASH_BALANCES = 0,
+    STATEHASH_DEX_OFFERS,
+    STATEHASH_DEX_ACCEPTS,
+    STATEHASH_METADEX,
+    STATEHASH_CROWDSALES,
+    STATEHASH_PART_COUNT
+};
+
 /** Checks if a given block should be consensus hashed. */
 bool ShouldConsensusHashBlock(int block);
 
@@ -17,6 +36,30 @@ uint256 GetMetaDExHash(const uint32_t propertyId = 0);
 /** Obtains a hash of the balances for a specific property. */
 uint256 GetBalancesHash(const uint32_t hashPropertyId);
 
+/** Adds or removes a balance record to or from the incremental state hash. */
+void UpdateStateHash(const CMPTally& tally, const std::string& address, uint32_t propertyId, bool fInsert);
+
+/** Adds or removes a DEx sell offer to or from the incremental state hash. */
+void UpdateStateHash(const CMPOffer& offer, const std::string& seller, bool fInsert);
+
+/** Adds or removes a DEx accept to or from the incremental state hash. */
+void UpdateStateHash(const CMPAccept& accept, const std::string& buyer, bool fInsert);
+
+/** Adds or removes a MetaDEx trade to or from the incremental state hash. */
+void UpdateStateHash(const CMPMetaDEx& trade, bool fInsert);
+
+/** Adds or removes an active crowdsale to or from the incremental state hash. */
+void UpdateStateHash(const CMPCrowd& crowd, const std::string& issuer, bool fInsert);
+
+/** Resets a part of the incremental state hash, when the underlying state is cleared. */
+void ClearStateHash(StateHashPart part);
+
+/** Obtains the incrementally maintained hash of balances, DEx, MetaDEx and crowdsale state. */
+uint256 GetStateHash();
+
+/** Calculates the state hash from scratch, used to verify the incremental state hash. */
+uint256 GetStateHashFromScratch();
+
 }
 
 #endif // COUNOSH_COUNOSCORE_CONSENSUSHASH_H
@@ -23,7 +23,9 @@
 #include <counoscore/parsing.h>
 #include <counoscore/pending.h>
 #include <counoscore/persistence.h>
+#include <counoscore/prevoutcache.h>
 #include <counoscore/rules.h>
+#include <counoscore/scanner.h>
 #include <counoscore/script.h>
 #include <counoscore/seedblocks.h>
 #include <counoscore/sp.h>
@@ -67,6 +69,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -148,8 +151,14 @@ std::set<std::pair<uint32_t,int> > setFreezingEnabledProperties;
 //! Set containing addresses that have been frozen
 std::set<std::pair<std::string,uint32_t> > setFrozenAddresses;
 
+//! Interned addresses, which key the tally map and the holder index
+CAddressTable mastercore::addressTable;
 //! In-memory collection of all amounts for all addresses for all properties
-std::unordered_map<std::string, CMPTally> mastercore::mp_tally_map;
+std::unordered_map<AddressId, CMPTally> mastercore::mp_tally_map;
+//! Index of addresses holding a non-zero amount of a property
+std::unordered_map<uint32_t, PropertyHolderSet> mastercore::mp_property_holders;
+//! Running totals of tokens held per property, excluding pending amounts
+std::unordered_map<uint32_t, int64_t> mastercore::mp_property_totals;
 
 // Only needed for GUI:
 
@@ -256,7 +265,15 @@ std::string FormatByType(int64_t amount, uint16_t propertyType)
 
 CMPTally* mastercore::getTally(const std::string& address)
 {
-    std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.find(address);
+    AddressId id;
+    if (!addressTable.Lookup(address, id)) return static_cast<CMPTally*>(nullptr);
+
+    return getTally(id);
+}
+
+CMPTally* mastercore::getTally(AddressId id)
+{
+    std::unordered_map<AddressId, CMPTally>::iterator it = mp_tally_map.find(id);
 
     if (it != mp_tally_map.end()) return &(it->second);
 
@@ -272,9 +289,9 @@ int64_t GetTokenBalance(const std::string& address, uint32_t propertyId, TallyTy
     }
 
     LOCK(cs_tally);
-    const std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.find(address);
-    if (my_it != mp_tally_map.end()) {
-        balance = (my_it->second).getMoney(propertyId, ttype);
+    const CMPTally* tally = getTally(address);
+    if (tally) {
+        balance = tally->getMoney(propertyId, ttype);
     }
 
     return balance;
@@ -433,30 +450,24 @@ std::string mastercore::getTokenLabel(uint32_t propertyId)
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
     int64_t owners = 0;
     int64_t totalTokens = 0;
 
     LOCK(cs_tally);
 
-    CMPSPInfo::Entry property;
-    if (false == pDbSpInfo->getSP(propertyId, property)) {
+    CMPSPInfo::Summary property;
+    if (false == pDbSpInfo->getSPSummary(propertyId, property)) {
         return 0; // property ID does not exist
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
-            }
+        std::unordered_map<uint32_t, int64_t>::const_iterator itTotal = mp_property_totals.find(propertyId);
+        if (itTotal != mp_property_totals.end()) {
+            totalTokens = itTotal->second;
+        }
+        std::unordered_map<uint32_t, PropertyHolderSet>::const_iterator itHolders = mp_property_holders.find(propertyId);
+        if (itHolders != mp_property_holders.end()) {
+            owners = itHolders->second.size();
         }
         int64_t cachedFee = pDbFeeCache->GetCachedAmount(propertyId);
         totalTokens += cachedFee;
@@ -493,18 +504,49 @@ bool mastercore::update_tally_map(const std::string& who, uint32_t propertyId, i
         assert(!isAddressFrozen(who, propertyId)); // for safety, this should never fail if everything else is working properly.
     }
 
-    before = GetTokenBalance(who, propertyId, ttype);
+    // the address is hashed only once, all further lookups use its identifier
+    AddressId id = addressTable.Intern(who);
 
-    std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.find(who);
+    std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.find(id);
     if (my_it == mp_tally_map.end()) {
         // insert an empty element
-        my_it = (mp_tally_map.insert(std::make_pair(who, CMPTally()))).first;
+        my_it = (mp_tally_map.insert(std::make_pair(id, CMPTally()))).first;
     }
 
     CMPTally& tally = my_it->second;
+    before = tally.getMoney(propertyId, ttype);
+
+    // the balance record is replaced in the incremental state hash, pending amounts are not covered
+    if (PENDING != ttype) UpdateStateHash(tally, who, propertyId, false);
     bRet = tally.updateMoney(propertyId, amount, ttype);
+    if (PENDING != ttype) UpdateStateHash(tally, who, propertyId, true);
+
+    // keep the per-property holder index and totals in sync, pending amounts are not held
+    if (bRet && PENDING != ttype) {
+        mp_property_totals[propertyId] += amount;
+
+        int64_t held = tally.getMoney(propertyId, BALANCE);
+        held += tally.getMoney(propertyId, SELLOFFER_RESERVE);
+        held += tally.getMoney(propertyId, ACCEPT_RESERVE);
+        held += tally.getMoney(propertyId, METADEX_RESERVE);
+
+        // a holder only becomes one, when it receives tokens
+        if (held != 0) {
+            if (amount > 0) mp_property_holders[propertyId].insert(CPropertyHolder(id));
+        } else {
+            std::unordered_map<uint32_t, PropertyHolderSet>::iterator itHolders = mp_property_holders.find(propertyId);
+            if (itHolders != mp_property_holders.end()) {
+                itHolders->second.erase(CPropertyHolder(id));
+                if (itHolders->second.empty()) mp_property_holders.erase(itHolders);
+            }
+        }
+    }
+
+    // the wallet balance cache only compares changed addresses
+    if (bRet) WalletCacheMarkDirty(id);
 
-    after = GetTokenBalance(who, propertyId, ttype);
+    after = tally.getMoney(propertyId, ttype);
+    if (bRet && PENDING != ttype && g_counos_tally_subscribed) uiInterface.CounosTallyChanged(who, propertyId, ttype, amount, after);
     if (!bRet) {
         assert(before == after);
         PrintToLog("%s(%s, %u=0x%X, %+d, ttype=%d) ERROR: insufficient balance (=%d)\n", __func__, who, propertyId, propertyId, amount, ttype, before);
@@ -644,19 +686,19 @@ void CheckWalletUpdate(bool forceUpdate)
     global_balance_reserved.clear();
 
     // populate global balance totals and wallet property list - note global balances do not include additional balances from watch-only addresses
-    for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-        // check if the address is a wallet address (including watched addresses)
-        std::string address = my_it->first;
-        int addressIsMine = IsMyAddressAllWallets(address, false, ISMINE_SPENDABLE);
-        if (!addressIsMine) continue;
+    const std::set<std::string>& spendableAddresses = WalletCacheGetSpendableAddresses();
+    for (std::set<std::string>::const_iterator it = spendableAddresses.begin(); it != spendableAddresses.end(); ++it) {
+        const std::string& address = *it;
+        AddressId id;
+        if (!addressTable.Lookup(address, id)) continue;
+        std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.find(id);
+        if (my_it == mp_tally_map.end()) continue;
         // iterate only those properties in the TokenMap for this address
         my_it->second.init();
         uint32_t propertyId;
         while (0 != (propertyId = (my_it->second).next())) {
             // add to the global wallet property list
             global_wallet_property_list.insert(propertyId);
-            // check if the address is spendable (only spendable balances are included in totals)
-            if (addressIsMine != ISMINE_SPENDABLE) continue;
             // work out the balances and add to globals
             global_balance_money[propertyId] += GetAvailableTokenBalance(address, propertyId);
             global_balance_reserved[propertyId] += GetTokenBalance(address, propertyId, SELLOFFER_RESERVE);
@@ -767,27 +809,24 @@ bool IsInMarkerCache(const uint256& txHash)
 }
 
 /**
- * Returns the encoding class, used to embed a payload.
+ * Checks, whether a transaction may carry a marker.
  *
- *   0 None
- *   1 Class A (p2pkh)
- *   2 Class B (multisig)
- *   3 Class C (op-return)
+ * Performs a string comparison on hex for each scriptPubKey and looks directly
+ * for Exodus hash160 bytes or counos marker bytes. This allows to drop
+ * non-Counos transactions with less work.
+ *
+ * The check only depends on the transaction itself, so it can be performed
+ * without holding any locks.
  */
-int mastercore::GetEncodingClass(const CTransaction& tx, int nBlock)
+bool mastercore::MayHaveMarker(const CTransaction& tx, int nBlock)
 {
-    bool hasExodus = false;
-    bool hasMultisig = false;
-    bool hasOpReturn = false;
-    bool hasMoney = false;
+    // Examine everything when not on mainnet
+    if (isNonMainNet()) {
+        return true;
+    }
 
-    /* Fast Search
-     * Perform a string comparison on hex for each scriptPubKey & look directly for Exodus hash160 bytes or counos marker bytes
-     * This allows to drop non-Counos transactions with less work
-     */
     std::string strClassC = "434f4e53";
     std::string strClassAB = "0014d225141d95166c90172443893951321977cb499d";
-    bool examineClosely = false;
     for (unsigned int n = 0; n < tx.vout.size(); ++n) {
         const CTxOut& output = tx.vout[n];
         std::string strSPB = HexStr(output.scriptPubKey.begin(), output.scriptPubKey.end());
@@ -796,22 +835,33 @@ int mastercore::GetEncodingClass(const CTransaction& tx, int nBlock)
                 continue;
             } else {
                 if (strSPB.find(strClassC) != std::string::npos) {
-                    examineClosely = true;
-                    break;
+                    return true;
                 }
             }
         } else {
-            examineClosely = true;
-            break;
+            return true;
         }
     }
 
-    // Examine everything when not on mainnet
-    if (isNonMainNet()) {
-        examineClosely = true;
-    }
+    return false;
+}
+
+/**
+ * Returns the encoding class, used to embed a payload.
+ *
+ *   0 None
+ *   1 Class A (p2pkh)
+ *   2 Class B (multisig)
+ *   3 Class C (op-return)
+ */
+int mastercore::GetEncodingClass(const CTransaction& tx, int nBlock)
+{
+    bool hasExodus = false;
+    bool hasMultisig = false;
+    bool hasOpReturn = false;
+    bool hasMoney = false;
 
-    if (!examineClosely) return NO_MARKER;
+    if (!MayHaveMarker(tx, nBlock)) return NO_MARKER;
 
     for (unsigned int n = 0; n < tx.vout.size(); ++n) {
         const CTxOut& output = tx.vout[n];
@@ -889,12 +939,18 @@ CCoinsViewCache mastercore::view(&viewDummy);
 //! Guards coins view cache
 RecursiveMutex mastercore::cs_tx_cache;
 
+//! Outputs spent by Counos transactions, which outlive flushes of the coins view cache
+CPrevoutCache mastercore::prevoutCache(500000);
+
 static unsigned int nCacheHits = 0;
 static unsigned int nCacheMiss = 0;
 
 /**
  * Fetches transaction inputs and adds them to the coins view cache.
  *
+ * Inputs are looked up in the prevout cache first, then in the coins removed by
+ * the block, which is currently connected, and only then via the transaction index.
+ *
  * Note: cs_tx_cache should be locked, when adding and accessing inputs!
  *
  * @param tx[in]  The transaction to fetch inputs for
@@ -905,8 +961,9 @@ static bool FillTxInputCache(const CTransaction& tx, const std::shared_ptr<std::
     static unsigned int nCacheSize = gArgs.GetArg("-counostxcache", 500000);
 
     if (view.GetCacheSize() > nCacheSize) {
-        PrintToLog("%s(): clearing cache before insertion [size=%d, hit=%d, miss=%d]\n",
-                __func__, view.GetCacheSize(), nCacheHits, nCacheMiss);
+        PrintToLog("%s(): clearing cache before insertion [size=%d, hit=%d, miss=%d, prevout cache size=%d, hit=%d, miss=%d]\n",
+                __func__, view.GetCacheSize(), nCacheHits, nCacheMiss,
+                prevoutCache.GetSize(), prevoutCache.GetHits(), prevoutCache.GetMisses());
         view.Flush();
     }
 
@@ -925,13 +982,18 @@ static bool FillTxInputCache(const CTransaction& tx, const std::shared_ptr<std::
         CTransactionRef txPrev;
         uint256 hashBlock;
         Coin newcoin;
-        if (removedCoins && removedCoins->find(txIn.prevout) != removedCoins->end()) {
+        if (prevoutCache.Get(txIn.prevout, newcoin)) {
+            // nothing to do
+        } else if (removedCoins && removedCoins->find(txIn.prevout) != removedCoins->end()) {
             newcoin = removedCoins->find(txIn.prevout)->second;
+            prevoutCache.Add(txIn.prevout, newcoin);
         } else if (GetTransaction(txIn.prevout.hash, txPrev, Params().GetConsensus(), hashBlock)) {
             newcoin.out.scriptPubKey = txPrev->vout[nOut].scriptPubKey;
             newcoin.out.nValue = txPrev->vout[nOut].nValue;
             BlockMap::iterator bit = ::BlockIndex().find(hashBlock);
             newcoin.nHeight = bit != ::BlockIndex().end() ? bit->second->nHeight : 1;
+            // unconfirmed transactions may still change
+            if (!hashBlock.IsNull()) prevoutCache.Add(txIn.prevout, newcoin);
         } else {
             return false;
         }
@@ -1570,6 +1632,10 @@ static int msc_initial_scan(int nFirstBlock)
     // check if using seed block filter should be disabled
     bool seedBlockFilterEnabled = gArgs.GetBoolArg("-counosseedblockfilter", true);
 
+    // blocks are read from disk ahead, while the previous blocks are processed
+    int nScanThreads = gArgs.GetArg("-counosscanthreads", DEFAULT_SCAN_THREADS);
+    CBlockPrefetcher prefetcher(nFirstBlock, nLastBlock, nScanThreads, seedBlockFilterEnabled);
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1577,11 +1643,8 @@ static int msc_initial_scan(int nFirstBlock)
             break;
         }
 
-        CBlockIndex* pblockindex;
-        {
-            LOCK(cs_main);
-            pblockindex = ::ChainActive()[nBlock];
-        }
+        std::shared_ptr<CPrefetchedBlock> pPrefetched = prefetcher.GetBlock(nBlock);
+        const CBlockIndex* pblockindex = pPrefetched->pBlockIndex;
 
         if (nullptr == pblockindex) break;
         std::string strBlockHash = pblockindex->GetBlockHash().GetHex();
@@ -1598,12 +1661,13 @@ static int msc_initial_scan(int nFirstBlock)
         unsigned int nTxsFoundInBlock = 0;
         mastercore_handler_block_begin(nBlock, pblockindex);
 
-        if (!seedBlockFilterEnabled || !SkipBlock(nBlock)) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) break;
+        if (!pPrefetched->fSkipped) {
+            if (!pPrefetched->fRead) break;
+            const CBlock& block = pPrefetched->block;
 
-            for(const auto tx : block.vtx) {
-                if (mastercore_handler_tx(*tx, nBlock, nTxNum, pblockindex, nullptr)) ++nTxsFoundInBlock;
+            for (size_t n = 0; n < block.vtx.size(); ++n) {
+                const CTransaction& tx = *block.vtx[n];
+                if (mastercore_handler_tx(tx, nBlock, nTxNum, pblockindex, nullptr, pPrefetched->vMayHaveMarker[n])) ++nTxsFoundInBlock;
                 ++nTxNum;
             }
         }
@@ -1632,11 +1696,18 @@ void clear_all_state()
 
     // Memory based storage
     mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    addressTable.Clear();
+    WalletCacheMarkAllDirty();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
-    metadex.clear();
+    MetaDEx_CLEAR();
     my_pending.clear();
+    for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+        ClearStateHash(static_cast<StateHashPart>(part));
+    }
     ResetConsensusParams();
     ClearActivations();
     ClearAlerts();
@@ -1753,6 +1824,7 @@ int mastercore_init()
                 fs::path feesPath = GetDataDir() / "COUNOS_feecache";
                 fs::path feeHistoryPath = GetDataDir() / "COUNOS_feehistory";
                 fs::path nftdbPath = GetDataDir() / "COUNOS_nftdb";
+                fs::path unifiedPath = GetDataDir() / "COUNOS_db";
                 if (fs::exists(persistPath)) fs::remove_all(persistPath);
                 if (fs::exists(txlistPath)) fs::remove_all(txlistPath);
                 if (fs::exists(tradePath)) fs::remove_all(tradePath);
@@ -1762,6 +1834,7 @@ int mastercore_init()
                 if (fs::exists(feesPath)) fs::remove_all(feesPath);
                 if (fs::exists(feeHistoryPath)) fs::remove_all(feeHistoryPath);
                 if (fs::exists(nftdbPath)) fs::remove_all(nftdbPath);
+                if (fs::exists(unifiedPath)) fs::remove_all(unifiedPath);
                 PrintToLog("Success clearing persistence files in datadir %s\n", GetDataDir().string());
                 startClean = true;
             } catch (const fs::filesystem_error& e) {
@@ -1775,6 +1848,7 @@ int mastercore_init()
         pDbTransactionList = new CMPTxList(GetDataDir() / "MP_txlist", fReindex);
         pDbSpInfo = new CMPSPInfo(GetDataDir() / "MP_spinfo", fReindex);
         pDbTransaction = new CCounosTransactionDB(GetDataDir() / "Counos_TXDB", fReindex);
+        pDbTransaction->SetDecodedCacheSize(gArgs.GetArg("-counosrpctxcache", DEFAULT_DECODED_TX_CACHE_SIZE));
         pDbFeeCache = new CCounosFeeCache(GetDataDir() / "COUNOS_feecache", fReindex);
         pDbFeeHistory = new CCounosFeeHistory(GetDataDir() / "COUNOS_feehistory", fReindex);
         pDbNFT = new CMPNonFungibleTokensDB(GetDataDir() / "COUNOS_nftdb", fReindex);
@@ -1782,6 +1856,11 @@ int mastercore_init()
         pathStateFiles = GetDataDir() / "MP_persist";
         TryCreateDirectories(pathStateFiles);
 
+        {
+            LOCK(cs_tx_cache);
+            prevoutCache.SetMaxSize(gArgs.GetArg("-counostxcache", 500000));
+        }
+
         wrongDBVersion = (pDbTransactionList->getDBVersion() != DB_VERSION);
 
         ++mastercoreInitialized;
@@ -1892,6 +1971,12 @@ int mastercore_init()
         PrintToLog("Exodus balance after initialization: %s\n", FormatDivisibleMP(exodus_balance));
     }
 
+    // delete pending transactions, when they are dropped from the mempool
+    PendingRegisterNotifications();
+
+    // the calling thread flags a range of each large block as well
+    StartFlagWorkers(gArgs.GetArg("-counosscanthreads", DEFAULT_SCAN_THREADS) - 1);
+
     PrintToConsole("Counos Core initialization completed\n");
 
     return 0;
@@ -1907,6 +1992,13 @@ int mastercore_init()
  */
 int mastercore_shutdown()
 {
+    PendingUnregisterNotifications();
+
+    StopFlagWorkers();
+
+    // the state of the latest blocks may still be written
+    StopStatePersistence();
+
     LOCK(cs_tally);
 
     if (pDbTransactionList) {
@@ -1952,12 +2044,31 @@ int mastercore_shutdown()
     return 0;
 }
 
+/**
+ * Flags the transactions of a new block, which may carry a marker.
+ *
+ * The check doesn't depend on the state, so for large blocks it's done in
+ * parallel by the persistent flag workers, before the transactions are handled
+ * in order.
+ *
+ * @see FlagMarkerTransactions()
+ */
+std::vector<bool> mastercore_handler_block_flag_txs(const CBlock& block, int nBlock)
+{
+    static const int nThreads = gArgs.GetArg("-counosscanthreads", DEFAULT_SCAN_THREADS);
+
+    return FlagMarkerTransactions(block, nBlock, nThreads);
+}
+
 /**
  * This handler is called for every new transaction that comes in (actually in block parsing loop).
  *
+ * Transactions, which can't carry a marker, as flagged by MayHaveMarker(), only
+ * clear pending amounts.
+ *
  * @return True, if the transaction was an Exodus purchase, DEx payment or a valid Counos transaction
  */
-bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex, const std::shared_ptr<std::map<COutPoint, Coin> > removedCoins)
+bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex, const std::shared_ptr<std::map<COutPoint, Coin> > removedCoins, bool fMayHaveMarker)
 {
     int nMastercoreInit, pop_ret;
     {
@@ -1980,6 +2091,9 @@ bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx,
 
         // we do not care about parsing blocks prior to our waterline (empty blockchain defense)
         if (nBlock < nWaterlineBlock) return false;
+
+        // without marker, only pending amounts need to be cleared
+        if (!fMayHaveMarker) return false;
     }
 
     int64_t nBlockTime = pBlockIndex->GetBlockTime();
@@ -2025,6 +2139,23 @@ bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx,
             bool bValid = (0 <= interp_ret);
             pDbTransactionList->recordTX(tx.GetHash(), bValid, nBlock, mp_obj.getType(), mp_obj.getNewAmount());
             pDbTransaction->RecordTransaction(tx.GetHash(), idx, interp_ret);
+
+            // keep the decoded transaction, so RPC lookups don't need to parse it again
+            CDecodedTransactionRecord decoded;
+            decoded.blockHash = pBlockIndex->GetBlockHash();
+            decoded.nBlock = nBlock;
+            decoded.nBlockTime = nBlockTime;
+            decoded.nPosition = idx;
+            decoded.nProcessingResult = interp_ret;
+            decoded.sender = mp_obj.getSender();
+            decoded.reference = mp_obj.getReceiver();
+            decoded.payload = mp_obj.getRawPayload();
+            decoded.nEncodingClass = mp_obj.getEncodingClass();
+            decoded.nFee = mp_obj.getFeePaid();
+            decoded.stmAddresses = mp_obj.getValidStmAddresses();
+            pDbTransaction->RecordDecodedTransaction(tx.GetHash(), decoded);
+
+            uiInterface.CounosTransactionProcessed(tx.GetHash(), nBlock, mp_obj.getType(), bValid);
         }
         fFoundTx |= (interp_ret == 0);
     }
@@ -2139,8 +2270,25 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
             PrintToLog("Consensus hash for block %d: %s\n", nBlockNow, consensusHash.GetHex());
         }
 
-        // request nftdb sanity check
-        pDbNFT->SanityCheck();
+        // verify the incremental state hash against a full recalculation, if required
+        if (msc_debug_state_hash) {
+            uint256 stateHash = GetStateHash();
+            uint256 stateHashFromScratch = GetStateHashFromScratch();
+            if (stateHash != stateHashFromScratch) {
+                PrintToLog("ERROR: incremental state hash for block %d does not match the recalculated one: %s != %s\n",
+                        nBlockNow, stateHash.GetHex(), stateHashFromScratch.GetHex());
+            } else {
+                PrintToLog("State hash for block %d: %s\n", nBlockNow, stateHash.GetHex());
+            }
+        }
+
+        // request nftdb sanity check, which only scans the whole database, if requested
+        static const bool fNFTAudit = gArgs.GetBoolArg("-counosnftaudit", false);
+        if (fNFTAudit) {
+            pDbNFT->FullSanityCheck();
+        } else {
+            pDbNFT->SanityCheck();
+        }
 
         // request checkpoint verification
         checkpointValid = VerifyCheckpoint(nBlockNow, pBlockIndex->GetBlockHash());
@@ -2153,6 +2301,7 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
             PrintToLog(msg);
             if (!gArgs.GetBoolArg("-overrideforcedshutdown", false)) {
                 fs::path persistPath = GetDataDir() / "MP_persist";
+                StopStatePersistence();
                 if (fs::exists(persistPath)) fs::remove_all(persistPath); // prevent the node being restarted without a reparse after forced shutdown
                 AbortNode(msg, msg);
             }
@@ -2167,15 +2316,24 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         }
     }
 
+    // sync the writes of this block, when the databases are stored in one
+    SyncUnifiedDB();
+
     return 0;
 }
 
 void mastercore_handler_disc_begin(const int nHeight)
 {
-    LOCK(cs_tally);
+    {
+        LOCK(cs_tally);
 
-    reorgRecoveryMode = 1;
-    reorgRecoveryMaxHeight = (nHeight > reorgRecoveryMaxHeight) ? nHeight: reorgRecoveryMaxHeight;
+        reorgRecoveryMode = 1;
+        reorgRecoveryMaxHeight = (nHeight > reorgRecoveryMaxHeight) ? nHeight: reorgRecoveryMaxHeight;
+    }
+
+    // outputs created in the disconnected block may not exist anymore
+    LOCK(cs_tx_cache);
+    prevoutCache.RemoveAbove(nHeight);
 }
 
 /**
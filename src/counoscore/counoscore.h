@@ -1,12 +1,15 @@
 #ifndef COUNOSH_COUNOSCORE_COUNOSCORE_H
 #define COUNOSH_COUNOSCORE_COUNOSCORE_H
 
+class CBlock;
 class CBlockIndex;
 class CCoinsView;
 class CCoinsViewCache;
 class CTransaction;
 class Coin;
+class CPrevoutCache;
 
+#include <counoscore/addresstable.h>
 #include <counoscore/log.h>
 #include <counoscore/tally.h>
 
@@ -172,7 +175,8 @@ int mastercore_shutdown();
 void mastercore_handler_disc_begin(const int nHeight);
 int mastercore_handler_block_begin(int nBlockNow, CBlockIndex const * pBlockIndex);
 int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex, unsigned int);
-bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex, const std::shared_ptr<std::map<COutPoint, Coin>> removedCoins);
+bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex, const std::shared_ptr<std::map<COutPoint, Coin>> removedCoins, bool fMayHaveMarker);
+std::vector<bool> mastercore_handler_block_flag_txs(const CBlock& block, int nBlock);
 
 /** Scans for marker and if one is found, add transaction to marker cache. */
 void TryToAddToMarkerCache(const CTransactionRef& tx);
@@ -189,14 +193,43 @@ void NotifyTotalTokensChanged(uint32_t propertyId, int block);
 
 namespace mastercore
 {
+//! Interned addresses, which key the tally map and the holder index
+extern CAddressTable addressTable;
+
+/** An interned address holding a property, which is ordered by address. */
+struct CPropertyHolder
+{
+    AddressId id;
+    //! The interned address, which stays valid, until the address table is cleared
+    const std::string* address;
+
+    explicit CPropertyHolder(AddressId idIn) : id(idIn), address(&addressTable.GetAddress(idIn)) {}
+    //! Only used to seek to the given address, which isn't necessarily interned
+    explicit CPropertyHolder(const std::string& addressIn) : id(0), address(&addressIn) {}
+
+    bool operator<(const CPropertyHolder& other) const { return *address < *other.address; }
+};
+
+//! Holders of a property, ordered by address, so they can be paged through
+typedef std::set<CPropertyHolder> PropertyHolderSet;
+
 //! In-memory collection of all amounts for all addresses for all properties
-extern std::unordered_map<std::string, CMPTally> mp_tally_map;
+extern std::unordered_map<AddressId, CMPTally> mp_tally_map;
+//! Addresses holding a non-zero amount of a property, maintained by update_tally_map()
+extern std::unordered_map<uint32_t, PropertyHolderSet> mp_property_holders;
+//! Number of tokens held per property, excluding pending amounts, maintained by update_tally_map()
+extern std::unordered_map<uint32_t, int64_t> mp_property_totals;
 
 // TODO: move, rename
 extern CCoinsView viewDummy;
 extern CCoinsViewCache view;
 //! Guards coins view cache
 extern RecursiveMutex cs_tx_cache;
+//! Outputs spent by Counos transactions, guarded by cs_tx_cache
+extern CPrevoutCache prevoutCache;
+
+/** Checks, whether a transaction may carry a marker, without locking. */
+bool MayHaveMarker(const CTransaction& tx, int nBlock);
 
 /** Returns the encoding class, used to embed a payload. */
 int GetEncodingClass(const CTransaction& tx, int nBlock);
@@ -209,6 +242,7 @@ bool isMainEcosystemProperty(uint32_t propertyId);
 uint32_t GetNextPropertyId(bool maineco); // maybe move into sp
 
 CMPTally* getTally(const std::string& address);
+CMPTally* getTally(AddressId id);
 bool update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype);
 int64_t getTotalTokens(uint32_t propertyId, int64_t* n_owners_total = nullptr);
 
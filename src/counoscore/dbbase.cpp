@@ -3,18 +3,280 @@
 #include <counoscore/log.h>
 
 #include <fs.h>
+#include <sync.h>
 #include <util/system.h>
 
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/iterator.h>
 #include <leveldb/write_batch.h>
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+//! Name of the shared database, used with -counosunifieddb
+const char* const UNIFIED_DB_NAME = "COUNOS_db";
+
+//! Columns of the shared database, by name of the standalone database
+const std::pair<const char*, char> UNIFIED_DB_COLUMNS[] = {
+    {"MP_txlist", 't'},
+    {"MP_tradelist", 'r'},
+    {"MP_stolist", 's'},
+    {"MP_spinfo", 'p'},
+    {"Counos_TXDB", 'x'},
+    {"COUNOS_feecache", 'f'},
+    {"COUNOS_feehistory", 'h'},
+    {"COUNOS_nftdb", 'n'},
+};
+
+/** Returns the block cache, which is shared by all databases. */
+leveldb::Cache* GetSharedBlockCache()
+{
+    static const std::unique_ptr<leveldb::Cache> cache{leveldb::NewLRUCache(
+            std::max<int64_t>(gArgs.GetArg("-counosdbcache", DEFAULT_COUNOS_DB_CACHE), 1) << 20)};
+    return cache.get();
+}
+
+/** Returns the bloom filter policy used for point lookups. */
+const leveldb::FilterPolicy* GetBloomFilterPolicy()
+{
+    static const std::unique_ptr<const leveldb::FilterPolicy> policy{leveldb::NewBloomFilterPolicy(10)};
+    return policy.get();
+}
+
+/** The shared database, which holds the databases as columns. */
+class CUnifiedDB
+{
+public:
+    leveldb::DB* pdb;
+
+    CUnifiedDB() : pdb(nullptr) {}
+
+    ~CUnifiedDB()
+    {
+        if (pdb) {
+            // make sure everything since the last block is on disk
+            leveldb::WriteOptions syncoptions;
+            syncoptions.sync = true;
+            leveldb::WriteBatch batch;
+            pdb->Write(syncoptions, &batch);
+            delete pdb;
+        }
+    }
+};
+
+Mutex cs_unified;
+//! Open shared databases, by path
+std::map<std::string, std::weak_ptr<CUnifiedDB>> mapUnifiedDBs GUARDED_BY(cs_unified);
+
+/** Opens the shared database, or returns the one already open. */
+leveldb::Status OpenUnifiedDB(const fs::path& path, const leveldb::Options& options, std::shared_ptr<CUnifiedDB>& unified)
+{
+    LOCK(cs_unified);
+    unified = mapUnifiedDBs[path.string()].lock();
+    if (unified) return leveldb::Status::OK();
+
+    TryCreateDirectories(path);
+    if (msc_debug_persistence) PrintToLog("Opening LevelDB in %s\n", path.string());
+
+    std::shared_ptr<CUnifiedDB> newDB = std::make_shared<CUnifiedDB>();
+    leveldb::Status status = leveldb::DB::Open(options, path.string(), &newDB->pdb);
+    if (!status.ok()) return status;
+
+    unified = newDB;
+    mapUnifiedDBs[path.string()] = unified;
+    return status;
+}
+
+/** Iterator over the entries of one column, which strips the column prefix. */
+class CColumnIterator : public leveldb::Iterator
+{
+private:
+    std::unique_ptr<leveldb::Iterator> it;
+    const std::string prefix;
+
+public:
+    CColumnIterator(leveldb::Iterator* i, const std::string& prefixIn) : it(i), prefix(prefixIn) {}
+
+    bool Valid() const override { return it->Valid() && it->key().starts_with(prefix); }
+    void SeekToFirst() override { it->Seek(prefix); }
+    void Seek(const leveldb::Slice& target) override { it->Seek(prefix + target.ToString()); }
+    void Next() override { it->Next(); }
+    void Prev() override { it->Prev(); }
+
+    void SeekToLast() override
+    {
+        std::string end = prefix;
+        end[end.size() - 1] += 1;
+        it->Seek(end);
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+    }
+
+    leveldb::Slice key() const override
+    {
+        leveldb::Slice key = it->key();
+        key.remove_prefix(prefix.size());
+        return key;
+    }
+
+    leveldb::Slice value() const override { return it->value(); }
+    leveldb::Status status() const override { return it->status(); }
+};
+
+/** Adds the column prefix to the keys of a batch. */
+class CColumnBatchHandler : public leveldb::WriteBatch::Handler
+{
+public:
+    const std::string& prefix;
+    leveldb::WriteBatch batch;
+
+    explicit CColumnBatchHandler(const std::string& prefixIn) : prefix(prefixIn) {}
+
+    void Put(const leveldb::Slice& key, const leveldb::Slice& value) override { batch.Put(prefix + key.ToString(), value); }
+    void Delete(const leveldb::Slice& key) override { batch.Delete(prefix + key.ToString()); }
+};
+
+/**
+ * One database stored as column of the shared database.
+ *
+ * All keys are prefixed with the column. Writes use the options of the caller,
+ * and the writes, which aren't synced individually, are synced once per block
+ * with SyncUnifiedDB().
+ */
+class CColumnDB : public leveldb::DB
+{
+private:
+    std::shared_ptr<CUnifiedDB> unified;
+    const std::string prefix;
+
+    std::string Key(const leveldb::Slice& key) const { return prefix + key.ToString(); }
+
+public:
+    CColumnDB(std::shared_ptr<CUnifiedDB> unifiedIn, char column) : unified(std::move(unifiedIn)), prefix(1, column) {}
+
+    leveldb::Status Put(const leveldb::WriteOptions& options, const leveldb::Slice& key, const leveldb::Slice& value) override
+    {
+        return unified->pdb->Put(options, Key(key), value);
+    }
+
+    leveldb::Status Delete(const leveldb::WriteOptions& options, const leveldb::Slice& key) override
+    {
+        return unified->pdb->Delete(options, Key(key));
+    }
+
+    leveldb::Status Write(const leveldb::WriteOptions& options, leveldb::WriteBatch* updates) override
+    {
+        CColumnBatchHandler handler(prefix);
+        leveldb::Status status = updates->Iterate(&handler);
+        if (!status.ok()) return status;
+        return unified->pdb->Write(options, &handler.batch);
+    }
+
+    leveldb::Status Get(const leveldb::ReadOptions& options, const leveldb::Slice& key, std::string* value) override
+    {
+        return unified->pdb->Get(options, Key(key), value);
+    }
+
+    leveldb::Iterator* NewIterator(const leveldb::ReadOptions& options) override
+    {
+        return new CColumnIterator(unified->pdb->NewIterator(options), prefix);
+    }
+
+    const leveldb::Snapshot* GetSnapshot() override { return unified->pdb->GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot* snapshot) override { unified->pdb->ReleaseSnapshot(snapshot); }
+    bool GetProperty(const leveldb::Slice& property, std::string* value) override { return unified->pdb->GetProperty(property, value); }
+
+    void GetApproximateSizes(const leveldb::Range* range, int n, uint64_t* sizes) override
+    {
+        for (int i = 0; i < n; ++i) {
+            const std::string start = Key(range[i].start);
+            const std::string limit = Key(range[i].limit);
+            const leveldb::Range columnRange(start, limit);
+            unified->pdb->GetApproximateSizes(&columnRange, 1, &sizes[i]);
+        }
+    }
+
+    void CompactRange(const leveldb::Slice* begin, const leveldb::Slice* end) override
+    {
+        std::string start = begin ? Key(*begin) : prefix;
+        std::string limit = prefix;
+        if (end) {
+            limit = Key(*end);
+        } else {
+            limit[limit.size() - 1] += 1;
+        }
+        const leveldb::Slice slStart(start);
+        const leveldb::Slice slLimit(limit);
+        unified->pdb->CompactRange(&slStart, &slLimit);
+    }
+};
+
+} // anonymous namespace
+
+CDBBase::CDBBase() : pdb(NULL), nRead(0), nWritten(0)
+{
+    options.paranoid_checks = true;
+    options.create_if_missing = true;
+    options.compression = leveldb::kNoCompression;
+    options.max_open_files = 64;
+    options.block_cache = GetSharedBlockCache();
+    options.filter_policy = GetBloomFilterPolicy();
+    readoptions.verify_checksums = true;
+    iteroptions.verify_checksums = true;
+    iteroptions.fill_cache = false;
+    syncoptions.sync = true;
+}
 
 /**
  * Opens or creates a LevelDB based database.
  */
 leveldb::Status CDBBase::Open(const fs::path& path, bool fWipe)
 {
+    const fs::path pathUnified = path.parent_path() / UNIFIED_DB_NAME;
+    const std::string strName = path.filename().string();
+    char column = 0;
+    for (const auto& entry : UNIFIED_DB_COLUMNS) {
+        if (strName == entry.first) column = entry.second;
+    }
+
+    if (column != 0 && gArgs.GetBoolArg("-counosunifieddb", DEFAULT_COUNOS_UNIFIED_DB)) {
+        // the standalone database is outdated, once the shared one is used
+        if (fs::exists(path)) {
+            PrintToLog("Removing LevelDB in %s, which is replaced by %s\n", path.string(), pathUnified.string());
+            leveldb::DestroyDB(path.string(), options);
+            fs::remove_all(path);
+        }
+
+        std::shared_ptr<CUnifiedDB> unified;
+        leveldb::Status status = OpenUnifiedDB(pathUnified, options, unified);
+        if (!status.ok()) return status;
+
+        pdb = new CColumnDB(unified, column);
+        if (fWipe) {
+            if (msc_debug_persistence) PrintToLog("Wiping column %c of LevelDB in %s\n", column, pathUnified.string());
+            Clear();
+        }
+        return status;
+    }
+
+    // vice versa, the shared database is outdated, once the standalone ones are used
+    if (column != 0 && fs::exists(pathUnified)) {
+        PrintToLog("Removing LevelDB in %s, which is replaced by %s\n", pathUnified.string(), path.string());
+        leveldb::DestroyDB(pathUnified.string(), options);
+        fs::remove_all(pathUnified);
+    }
+
     if (fWipe) {
         if (msc_debug_persistence) PrintToLog("Wiping LevelDB in %s\n", path.string());
         leveldb::DestroyDB(path.string(), options);
@@ -62,6 +324,34 @@ void CDBBase::Close()
 }
 
 
+/**
+ * Syncs the writes of a block in the shared database to disk.
+ */
+void SyncUnifiedDB()
+{
+    std::vector<std::shared_ptr<CUnifiedDB>> vUnified;
+    {
+        LOCK(cs_unified);
+        for (const auto& entry : mapUnifiedDBs) {
+            std::shared_ptr<CUnifiedDB> unified = entry.second.lock();
+            if (unified) vUnified.push_back(unified);
+        }
+    }
+
+    leveldb::WriteOptions syncoptions;
+    syncoptions.sync = true;
+
+    // an empty synced write flushes the log, including all writes before it
+    for (const std::shared_ptr<CUnifiedDB>& unified : vUnified) {
+        leveldb::WriteBatch batch;
+        leveldb::Status status = unified->pdb->Write(syncoptions, &batch);
+        if (!status.ok()) {
+            PrintToLog("%s(): ERROR: failed to sync %s\n", __func__, status.ToString());
+        }
+    }
+}
+
+
 /**
 @todo  Move initialization and deinitialization of databases into this file (?)
 @todo  Move file based storage into this file
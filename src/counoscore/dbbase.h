@@ -3,12 +3,116 @@
 
 #include <algorithm>
 #include <leveldb/db.h>
+#include <leveldb/slice.h>
+#include <leveldb/write_batch.h>
 
+#include <clientversion.h>
 #include <fs.h>
+#include <serialize.h>
+#include <streams.h>
 
 #include <assert.h>
+#include <exception>
+#include <ios>
 #include <memory>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+//! Default for -counosdbcache, the block cache shared by all databases in MiB
+static const int64_t DEFAULT_COUNOS_DB_CACHE = 64;
+
+//! Default for -counosunifieddb, whether all databases are stored in one LevelDB
+static const bool DEFAULT_COUNOS_UNIFIED_DB = false;
+
+/** Minimal stream to deserialize database records directly from a LevelDB value.
+ */
+class CDBRecordReader
+{
+private:
+    const char* pbegin;
+    const char* pend;
+
+public:
+    explicit CDBRecordReader(const leveldb::Slice& value) : pbegin(value.data()), pend(value.data() + value.size()) {}
+
+    int GetType() const { return SER_DISK; }
+    int GetVersion() const { return CLIENT_VERSION; }
+
+    bool empty() const { return pbegin == pend; }
+
+    void read(char* dst, size_t n)
+    {
+        if (n > static_cast<size_t>(pend - pbegin)) {
+            throw std::ios_base::failure("CDBRecordReader::read(): end of data");
+        }
+        memcpy(dst, pbegin, n);
+        pbegin += n;
+    }
+
+    template <typename T>
+    CDBRecordReader& operator>>(T& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+};
+
+/**
+ * Decodes a typed database record, which has no legacy format.
+ *
+ * @param value   The raw database value, starting with the version byte T::VERSION
+ * @param record  The record to decode into
+ * @return True, if the value could be decoded
+ */
+template <typename T>
+bool DecodeBinaryDBRecord(const leveldb::Slice& value, T& record)
+{
+    if (value.empty() || static_cast<unsigned char>(value[0]) != T::VERSION) return false;
+
+    try {
+        CDBRecordReader reader(leveldb::Slice(value.data() + 1, value.size() - 1));
+        reader >> record;
+        return reader.empty();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+/**
+ * Decodes a typed database record.
+ *
+ * Records are serialized with a leading version byte, which is provided by T::VERSION.
+ * Values without that version byte are considered to be in the legacy colon-delimited
+ * text format, and are handed to T::ParseLegacy().
+ *
+ * @param value      The raw database value
+ * @param record     The record to decode into
+ * @param pfLegacy   Optionally set to true, if the value was in the legacy format
+ * @return True, if the value could be decoded
+ */
+template <typename T>
+bool DecodeDBRecord(const leveldb::Slice& value, T& record, bool* pfLegacy = nullptr)
+{
+    if (value.empty() || static_cast<unsigned char>(value[0]) != T::VERSION) {
+        if (pfLegacy) *pfLegacy = true;
+        return record.ParseLegacy(value.ToString());
+    }
+    if (pfLegacy) *pfLegacy = false;
+
+    return DecodeBinaryDBRecord(value, record);
+}
+
+/** Encodes a typed database record, prefixed with its version byte. */
+template <typename T>
+CDataStream EncodeDBRecord(const T& record)
+{
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    ssValue << static_cast<unsigned char>(T::VERSION);
+    ssValue << record;
+    return ssValue;
+}
 
 /** Base class for LevelDB based storage.
  */
@@ -40,17 +144,7 @@ protected:
     //! Number of entries written
     unsigned int nWritten;
 
-    CDBBase() : pdb(NULL), nRead(0), nWritten(0)
-    {
-        options.paranoid_checks = true;
-        options.create_if_missing = true;
-        options.compression = leveldb::kNoCompression;
-        options.max_open_files = 64;
-        readoptions.verify_checksums = true;
-        iteroptions.verify_checksums = true;
-        iteroptions.fill_cache = false;
-        syncoptions.sync = true;
-    }
+    CDBBase();
 
     virtual ~CDBBase()
     {
@@ -77,6 +171,10 @@ protected:
      * If the database is wiped before opening, it's content is destroyed, including
      * all log files and meta data.
      *
+     * With -counosunifieddb, the known databases are not opened at the given path,
+     * but are stored as a column of one shared database in the same directory, and
+     * wiping only removes the entries of the column.
+     *
      * @param path   The path of the database to open
      * @param fWipe  Whether to wipe the database before opening
      * @return A Status object, indicating success or failure
@@ -88,6 +186,51 @@ protected:
      */
     void Close();
 
+    /**
+     * Reads and decodes a typed record.
+     *
+     * Records still stored in the legacy text format are migrated lazily, and
+     * written back in the binary format, once they are read.
+     *
+     * @param key     The key of the record
+     * @param record  The record to decode into
+     * @return True, if the record exists and could be decoded
+     */
+    template <typename T>
+    bool ReadRecord(const std::string& key, T& record)
+    {
+        assert(pdb != NULL);
+        std::string strValue;
+        leveldb::Status status = pdb->Get(readoptions, key, &strValue);
+        ++nRead;
+        if (!status.ok()) return false;
+
+        bool fLegacy = false;
+        if (!DecodeDBRecord(strValue, record, &fLegacy)) return false;
+        if (fLegacy) WriteRecord(key, record);
+
+        return true;
+    }
+
+    /** Encodes and writes a typed record. */
+    template <typename T>
+    leveldb::Status WriteRecord(const std::string& key, const T& record)
+    {
+        assert(pdb != NULL);
+        const CDataStream ssValue = EncodeDBRecord(record);
+        ++nWritten;
+        return pdb->Put(writeoptions, key, leveldb::Slice(ssValue.data(), ssValue.size()));
+    }
+
+    /** Encodes a typed record, and adds it to the batch. */
+    template <typename T>
+    void WriteRecord(leveldb::WriteBatch& batch, const std::string& key, const T& record)
+    {
+        const CDataStream ssValue = EncodeDBRecord(record);
+        ++nWritten;
+        batch.Put(key, leveldb::Slice(ssValue.data(), ssValue.size()));
+    }
+
 public:
     /**
      * Deletes all entries of the database, and resets the counters.
@@ -139,4 +282,15 @@ public:
     }
 };
 
+/**
+ * Syncs the writes of a block in the shared database to disk.
+ *
+ * Writes, which aren't synced individually, are only synced once per block,
+ * instead of being left to the operating system. Like the standalone
+ * databases, the columns may hold writes above the SP watermark after a crash,
+ * which are replaced, when the blocks are processed again.
+ * Without -counosunifieddb, this does nothing.
+ */
+void SyncUnifiedDB();
+
 #endif // COUNOSH_COUNOSCORE_DBBASE_H
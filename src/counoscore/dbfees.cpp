@@ -29,6 +29,95 @@ using namespace mastercore;
 
 std::map<uint32_t, int64_t> distributionThresholds;
 
+const unsigned char CCounosFeeCacheRecord::VERSION;
+const unsigned char CCounosFeeHistoryRecord::VERSION;
+
+/**
+ * Parses a record in the legacy "block:amount,..." format.
+ *
+ * Malformed entries are skipped, and the record of a rolled back cache is empty.
+ */
+bool CCounosFeeCacheRecord::ParseLegacy(const std::string& value)
+{
+    items.clear();
+
+    std::vector<std::string> vCacheHistoryItems;
+    boost::split(vCacheHistoryItems, value, boost::is_any_of(","), boost::token_compress_on);
+    for (std::vector<std::string>::iterator it = vCacheHistoryItems.begin(); it != vCacheHistoryItems.end(); ++it) {
+        if (it->empty()) continue;
+        std::vector<std::string> vCacheHistoryItem;
+        boost::split(vCacheHistoryItem, *it, boost::is_any_of(":"), boost::token_compress_on);
+        if (2 != vCacheHistoryItem.size()) {
+            PrintToConsole("ERROR: vCacheHistoryItem has unexpected number of elements: %d (raw %s)!\n", vCacheHistoryItem.size(), *it);
+            continue;
+        }
+        try {
+            items.insert(std::make_pair(boost::lexical_cast<int>(vCacheHistoryItem[0]), boost::lexical_cast<int64_t>(vCacheHistoryItem[1])));
+        } catch (const boost::bad_lexical_cast&) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string CCounosFeeCacheRecord::ToString() const
+{
+    std::string str;
+    for (std::set<feeCacheItem>::const_iterator it = items.begin(); it != items.end(); ++it) {
+        if (!str.empty()) str += ",";
+        str += strprintf("%d:%d", it->first, it->second);
+    }
+    return str;
+}
+
+/**
+ * Parses a record in the legacy "block:property:total:address=amount,..." format.
+ */
+bool CCounosFeeHistoryRecord::ParseLegacy(const std::string& value)
+{
+    recipients.clear();
+
+    std::vector<std::string> vFeeHistoryDetail;
+    boost::split(vFeeHistoryDetail, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (4 != vFeeHistoryDetail.size()) {
+        PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+        return false; // bad data
+    }
+
+    try {
+        nBlock = boost::lexical_cast<int32_t>(vFeeHistoryDetail[0]);
+        propertyId = boost::lexical_cast<uint32_t>(vFeeHistoryDetail[1]);
+        nTotal = boost::lexical_cast<int64_t>(vFeeHistoryDetail[2]);
+
+        std::vector<std::string> vFeeHistoryItems;
+        boost::split(vFeeHistoryItems, vFeeHistoryDetail[3], boost::is_any_of(","), boost::token_compress_on);
+        for (std::vector<std::string>::iterator it = vFeeHistoryItems.begin(); it != vFeeHistoryItems.end(); ++it) {
+            std::vector<std::string> vFeeHistoryItem;
+            boost::split(vFeeHistoryItem, *it, boost::is_any_of("="), boost::token_compress_on);
+            if (2 != vFeeHistoryItem.size()) {
+                PrintToConsole("ERROR: vFeeHistoryItem has unexpected number of elements: %d (raw %s)!\n", vFeeHistoryItem.size(), *it);
+                continue;
+            }
+            recipients.insert(std::make_pair(vFeeHistoryItem[0], boost::lexical_cast<int64_t>(vFeeHistoryItem[1])));
+        }
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string CCounosFeeHistoryRecord::ToString() const
+{
+    std::string feeRecipientsStr;
+    for (std::set<feeHistoryItem>::const_iterator it = recipients.begin(); it != recipients.end(); ++it) {
+        if (!feeRecipientsStr.empty()) feeRecipientsStr += ",";
+        feeRecipientsStr += strprintf("%s=%d", it->first, it->second);
+    }
+    return strprintf("%d:%d:%d:%s", nBlock, propertyId, nTotal, feeRecipientsStr);
+}
+
 CCounosFeeCache::CCounosFeeCache(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -80,22 +169,17 @@ void CCounosFeeCache::ClearCache(const uint32_t &propertyId, int block)
     const std::string key = strprintf("%010d", propertyId);
     std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
     if (msc_debug_fees) PrintToLog("   Iterating cache history (%d items)...\n",sCacheHistoryItems.size());
-    std::string newValue;
-    if (!sCacheHistoryItems.empty()) {
-        for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
-            feeCacheItem tempItem = *it;
-            if (tempItem.first == block) continue;
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
-            if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
-        }
-        if (!newValue.empty()) newValue += ",";
+    CCounosFeeCacheRecord newRecord;
+    for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
+        feeCacheItem tempItem = *it;
+        if (tempItem.first == block) continue;
+        newRecord.items.insert(tempItem);
+        if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
     }
     if (msc_debug_fees) PrintToLog("   Adding zero valued entry: block %d\n", block);
-    newValue += strprintf("%d:%d", block, 0);
-    leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+    newRecord.items.insert(std::make_pair(block, 0));
+    leveldb::Status status = WriteRecord(key, newRecord);
     assert(status.ok());
-    ++nWritten;
 
     PruneCache(propertyId, block);
 
@@ -128,23 +212,18 @@ void CCounosFeeCache::AddFee(const uint32_t &propertyId, int block, const int64_
     const std::string key = strprintf("%010d", propertyId);
     std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
     if (msc_debug_fees) PrintToLog("   Iterating cache history (%d items)...\n",sCacheHistoryItems.size());
-    std::string newValue;
-    if (!sCacheHistoryItems.empty()) {
-        for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
-            feeCacheItem tempItem = *it;
-            if (tempItem.first == block) continue; // this is an older entry for the same block, discard it
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
-            if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
-        }
-        if (!newValue.empty()) newValue += ",";
+    CCounosFeeCacheRecord newRecord;
+    for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
+        feeCacheItem tempItem = *it;
+        if (tempItem.first == block) continue; // this is an older entry for the same block, discard it
+        newRecord.items.insert(tempItem);
+        if (msc_debug_fees) PrintToLog("      Readding entry: block %d amount %d\n", tempItem.first, tempItem.second);
     }
     if (msc_debug_fees) PrintToLog("   Adding requested entry: block %d new amount %d\n", block, newCachedAmount);
-    newValue += strprintf("%d:%d", block, newCachedAmount);
-    leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+    newRecord.items.insert(std::make_pair(block, newCachedAmount));
+    leveldb::Status status = WriteRecord(key, newRecord);
     assert(status.ok());
-    ++nWritten;
-    if (msc_debug_fees) PrintToLog("AddFee completed for property %d (new=%s [%s])\n", propertyId, newValue, status.ToString());
+    if (msc_debug_fees) PrintToLog("AddFee completed for property %d (new=%s [%s])\n", propertyId, newRecord.ToString(), status.ToString());
 
     // Call for pruning (we only prune when we update a record)
     PruneCache(propertyId, block);
@@ -166,19 +245,18 @@ void CCounosFeeCache::RollBackCache(int block)
             std::set<feeCacheItem> sCacheHistoryItems = GetCacheHistory(propertyId);
             if (!sCacheHistoryItems.empty()) {
                 std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
-                std::string newValue;
+                CCounosFeeCacheRecord newRecord;
                 --mostRecentIt;
                 feeCacheItem mostRecentItem = *mostRecentIt;
                 if (mostRecentItem.first < block) continue; // all entries are unaffected by this rollback, nothing to do
                 for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
                     feeCacheItem tempItem = *it;
                     if (tempItem.first >= block) continue; // discard this entry
-                    if (!newValue.empty()) newValue += ",";
-                    newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
+                    newRecord.items.insert(tempItem);
                 }
-                leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+                leveldb::Status status = WriteRecord(key, newRecord);
                 assert(status.ok());
-                PrintToLog("Rolling back fee cache for property %d, new=%s [%s])\n", propertyId, newValue, status.ToString());
+                PrintToLog("Rolling back fee cache for property %d, new=%s [%s])\n", propertyId, newRecord.ToString(), status.ToString());
             }
         }
     }
@@ -253,7 +331,7 @@ void CCounosFeeCache::PruneCache(const uint32_t &propertyId, int block)
             if (msc_debug_fees) PrintToLog("Ending PruneCache - no matured entries found.\n");
             return; // all entries are above supplied block value, nothing to do
         }
-        std::string newValue;
+        CCounosFeeCacheRecord newRecord;
         for (std::set<feeCacheItem>::iterator it = sCacheHistoryItems.begin(); it != sCacheHistoryItems.end(); it++) {
             feeCacheItem tempItem = *it;
             if (tempItem.first < pruneBlock) {
@@ -262,21 +340,20 @@ void CCounosFeeCache::PruneCache(const uint32_t &propertyId, int block)
                     continue; // discard this entry
                 }
             }
-            if (!newValue.empty()) newValue += ",";
-            newValue += strprintf("%d:%d", tempItem.first, tempItem.second);
+            newRecord.items.insert(tempItem);
             if (msc_debug_fees) PrintToLog("      Readding immature entry: block %d amount %d\n", tempItem.first, tempItem.second);
         }
         // make sure the pruned cache isn't completely empty, if it is, prune down to just the most recent entry
-        if (newValue.empty()) {
+        if (newRecord.items.empty()) {
             std::set<feeCacheItem>::iterator mostRecentIt = sCacheHistoryItems.end();
             --mostRecentIt;
             feeCacheItem mostRecentItem = *mostRecentIt;
-            newValue = strprintf("%d:%d", mostRecentItem.first, mostRecentItem.second);
+            newRecord.items.insert(mostRecentItem);
             if (msc_debug_fees) PrintToLog("   All entries matured and pruned - readding most recent entry: block %d amount %d\n", mostRecentItem.first, mostRecentItem.second);
         }
-        leveldb::Status status = pdb->Put(writeoptions, key, newValue);
+        leveldb::Status status = WriteRecord(key, newRecord);
         assert(status.ok());
-        if (msc_debug_fees) PrintToLog("PruneCache completed for property %d (new=%s [%s])\n", propertyId, newValue, status.ToString());
+        if (msc_debug_fees) PrintToLog("PruneCache completed for property %d (new=%s [%s])\n", propertyId, newRecord.ToString(), status.ToString());
     } else {
         return; // nothing to do
     }
@@ -295,7 +372,9 @@ void CCounosFeeCache::printAll()
     leveldb::Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next()) {
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, it->key().ToString(), it->value().ToString());
+        CCounosFeeCacheRecord record;
+        DecodeDBRecord(it->value(), record);
+        PrintToConsole("entry #%8d= %s:%s\n", count, it->key().ToString(), record.ToString());
     }
     delete it;
 }
@@ -307,29 +386,12 @@ std::set<feeCacheItem> CCounosFeeCache::GetCacheHistory(const uint32_t &property
 
     const std::string key = strprintf("%010d", propertyId);
 
-    std::set<feeCacheItem> sCacheHistoryItems;
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
-    if (status.IsNotFound()) {
-        return sCacheHistoryItems; // no cache, return empty set
-    }
-    assert(status.ok());
-    std::vector<std::string> vCacheHistoryItems;
-    boost::split(vCacheHistoryItems, strValue, boost::is_any_of(","), boost::token_compress_on);
-    for (std::vector<std::string>::iterator it = vCacheHistoryItems.begin(); it != vCacheHistoryItems.end(); ++it) {
-        std::vector<std::string> vCacheHistoryItem;
-        boost::split(vCacheHistoryItem, *it, boost::is_any_of(":"), boost::token_compress_on);
-        if (2 != vCacheHistoryItem.size()) {
-            PrintToConsole("ERROR: vCacheHistoryItem has unexpected number of elements: %d (raw %s)!\n", vCacheHistoryItem.size(), *it);
-            printAll();
-            continue;
-        }
-        int64_t cacheItemBlock = boost::lexical_cast<int64_t>(vCacheHistoryItem[0]);
-        int64_t cacheItemAmount = boost::lexical_cast<int64_t>(vCacheHistoryItem[1]);
-        sCacheHistoryItems.insert(std::make_pair(cacheItemBlock, cacheItemAmount));
+    CCounosFeeCacheRecord record;
+    if (!ReadRecord(key, record)) {
+        return std::set<feeCacheItem>(); // no cache, return empty set
     }
 
-    return sCacheHistoryItems;
+    return record.items;
 }
 
 CCounosFeeHistory::CCounosFeeHistory(const fs::path& path, bool fWipe)
@@ -356,8 +418,10 @@ void CCounosFeeHistory::printAll()
     leveldb::Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next()) {
         ++count;
-        PrintToConsole("entry #%8d= %s-%s\n", count, it->key().ToString(), it->value().ToString());
-        PrintToLog("entry #%8d= %s-%s\n", count, it->key().ToString(), it->value().ToString());
+        CCounosFeeHistoryRecord record;
+        DecodeDBRecord(it->value(), record);
+        PrintToConsole("entry #%8d= %s-%s\n", count, it->key().ToString(), record.ToString());
+        PrintToLog("entry #%8d= %s-%s\n", count, it->key().ToString(), record.ToString());
     }
     delete it;
 }
@@ -383,17 +447,14 @@ void CCounosFeeHistory::RollBackHistory(int block)
     std::set<int> sDistributions;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strValue = it->value().ToString();
         std::string strKey = it->key().ToString();
-        std::vector<std::string> vFeeHistoryDetail;
-        boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vFeeHistoryDetail.size()) {
-            PrintToLog("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+        CCounosFeeHistoryRecord record;
+        if (!DecodeDBRecord(it->value(), record)) {
+            PrintToLog("ERROR: fee history record %s is malformed!\n", strKey);
             continue; // bad data
         }
-        int feeBlock = boost::lexical_cast<int>(vFeeHistoryDetail[0]);
-        if (feeBlock >= block) {
-            PrintToLog("%s() deleting from fee history DB: %s %s\n", __FUNCTION__, strKey, strValue);
+        if (record.nBlock >= block) {
+            PrintToLog("%s() deleting from fee history DB: %s %s\n", __FUNCTION__, strKey, record.ToString());
             pdb->Delete(writeoptions, strKey);
         }
     }
@@ -408,16 +469,12 @@ std::set<int> CCounosFeeHistory::GetDistributionsForProperty(const uint32_t &pro
     std::set<int> sDistributions;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vFeeHistoryDetail;
-        boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vFeeHistoryDetail.size()) {
-            PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
+        CCounosFeeHistoryRecord record;
+        if (!DecodeDBRecord(it->value(), record)) {
             printAll();
             continue; // bad data
         }
-        uint32_t prop = boost::lexical_cast<uint32_t>(vFeeHistoryDetail[1]);
-        if (prop == propertyId) {
+        if (record.propertyId == propertyId) {
             std::string key = it->key().ToString();
             int id = boost::lexical_cast<int>(key);
             sDistributions.insert(id);
@@ -433,22 +490,13 @@ bool CCounosFeeHistory::GetDistributionData(int id, uint32_t *propertyId, int *b
     assert(pdb);
 
     const std::string key = strprintf("%d", id);
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
-    if (status.IsNotFound()) {
-        return false; // fee distribution not found
+    CCounosFeeHistoryRecord record;
+    if (!ReadRecord(key, record)) {
+        return false; // fee distribution not found or bad data
     }
-    assert(status.ok());
-    std::vector<std::string> vFeeHistoryDetail;
-    boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-    if (4 != vFeeHistoryDetail.size()) {
-        PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
-        printAll();
-        return false; // bad data
-    }
-    *block = boost::lexical_cast<int>(vFeeHistoryDetail[0]);
-    *propertyId = boost::lexical_cast<uint32_t>(vFeeHistoryDetail[1]);
-    *total = boost::lexical_cast<int64_t>(vFeeHistoryDetail[2]);
+    *block = record.nBlock;
+    *propertyId = record.propertyId;
+    *total = record.nTotal;
     return true;
 }
 
@@ -458,35 +506,12 @@ std::set<feeHistoryItem> CCounosFeeHistory::GetFeeDistribution(int id)
     assert(pdb);
 
     const std::string key = strprintf("%d", id);
-    std::set<feeHistoryItem> sFeeHistoryItems;
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, key, &strValue);
-    if (status.IsNotFound()) {
-        return sFeeHistoryItems; // fee distribution not found, return empty set
-    }
-    assert(status.ok());
-    std::vector<std::string> vFeeHistoryDetail;
-    boost::split(vFeeHistoryDetail, strValue, boost::is_any_of(":"), boost::token_compress_on);
-    if (4 != vFeeHistoryDetail.size()) {
-        PrintToConsole("ERROR: vFeeHistoryDetail has unexpected number of elements: %d !\n", vFeeHistoryDetail.size());
-        printAll();
-        return sFeeHistoryItems; // bad data, return empty set
-    }
-    std::vector<std::string> vFeeHistoryItems;
-    boost::split(vFeeHistoryItems, vFeeHistoryDetail[3], boost::is_any_of(","), boost::token_compress_on);
-    for (std::vector<std::string>::iterator it = vFeeHistoryItems.begin(); it != vFeeHistoryItems.end(); ++it) {
-        std::vector<std::string> vFeeHistoryItem;
-        boost::split(vFeeHistoryItem, *it, boost::is_any_of("="), boost::token_compress_on);
-        if (2 != vFeeHistoryItem.size()) {
-            PrintToConsole("ERROR: vFeeHistoryItem has unexpected number of elements: %d (raw %s)!\n", vFeeHistoryItem.size(), *it);
-            printAll();
-            continue;
-        }
-        int64_t feeHistoryItemAmount = boost::lexical_cast<int64_t>(vFeeHistoryItem[1]);
-        sFeeHistoryItems.insert(std::make_pair(vFeeHistoryItem[0], feeHistoryItemAmount));
+    CCounosFeeHistoryRecord record;
+    if (!ReadRecord(key, record)) {
+        return std::set<feeHistoryItem>(); // fee distribution not found or bad data, return empty set
     }
 
-    return sFeeHistoryItems;
+    return record.recipients;
 }
 
 // Record a fee distribution
@@ -496,19 +521,7 @@ void CCounosFeeHistory::RecordFeeDistribution(const uint32_t &propertyId, int bl
 
     int count = CountRecords() + 1;
     std::string key = strprintf("%d", count);
-    std::string feeRecipientsStr;
-
-    if (!feeRecipients.empty()) {
-        for (std::set<feeHistoryItem>::iterator it = feeRecipients.begin(); it != feeRecipients.end(); it++) {
-            feeHistoryItem tempRecipient = *it;
-            feeRecipientsStr += strprintf("%s=%d,", tempRecipient.first, tempRecipient.second);
-        }
-        if (feeRecipientsStr.size() > 0) {
-            feeRecipientsStr.resize(feeRecipientsStr.size() - 1);
-        }
-    }
-
-    std::string value = strprintf("%d:%d:%d:%s", block, propertyId, total, feeRecipientsStr);
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
-    if (msc_debug_fees) PrintToLog("Added fee distribution to feeCacheHistory - key=%s value=%s [%s]\n", key, value, status.ToString());
+    const CCounosFeeHistoryRecord record(block, propertyId, total, feeRecipients);
+    leveldb::Status status = WriteRecord(key, record);
+    if (msc_debug_fees) PrintToLog("Added fee distribution to feeCacheHistory - key=%s value=%s [%s]\n", key, record.ToString(), status.ToString());
 }
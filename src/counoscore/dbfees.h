@@ -5,6 +5,8 @@
 #include <counoscore/log.h>
 
 #include <fs.h>
+#include <serialize.h>
+
 #include <stdint.h>
 #include <set>
 #include <string>
@@ -13,6 +15,62 @@
 typedef std::pair<int, int64_t> feeCacheItem;
 typedef std::pair<std::string, int64_t> feeHistoryItem;
 
+/** The cache history of a property, stored with the property identifier as key. */
+class CCounosFeeCacheRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    //! Cached amounts by block, the last entry is the most recent one
+    std::set<feeCacheItem> items;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(items);
+    }
+
+    /** Parses a record in the legacy "block:amount,..." format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
+/** A fee distribution, stored with the number of the distribution as key. */
+class CCounosFeeHistoryRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    int32_t nBlock;
+    uint32_t propertyId;
+    int64_t nTotal;
+    std::set<feeHistoryItem> recipients;
+
+    CCounosFeeHistoryRecord() : nBlock(0), propertyId(0), nTotal(0) {}
+
+    CCounosFeeHistoryRecord(int32_t nBlockIn, uint32_t propertyIdIn, int64_t nTotalIn, const std::set<feeHistoryItem>& recipientsIn)
+      : nBlock(nBlockIn), propertyId(propertyIdIn), nTotal(nTotalIn), recipients(recipientsIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nBlock);
+        READWRITE(propertyId);
+        READWRITE(nTotal);
+        READWRITE(recipients);
+    }
+
+    /** Parses a record in the legacy "block:property:total:address=amount,..." format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
 /** LevelDB based storage for the MetaDEx fee cache.
  */
 class CCounosFeeCache : public CDBBase
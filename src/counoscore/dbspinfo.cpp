@@ -28,6 +28,9 @@ CMPSPInfo::Entry::Entry()
     close_early(false), max_tokens(false), missedTokens(0), timeclosed(0),
     fixed(false), manual(false), unique(false), delegate("") {}
 
+CMPSPInfo::Summary::Summary()
+  : num_tokens(0), ecosystem(0), divisible(false), fixed(false), manual(false), unique(false) {}
+
 bool CMPSPInfo::Entry::isDivisible() const
 {
     switch (prop_type) {
@@ -174,6 +177,8 @@ CMPSPInfo::~CMPSPInfo()
 
 void CMPSPInfo::Clear()
 {
+    LOCK(cs_cache);
+    cachedEntries.clear();
     // wipe database via parent class
     CDBBase::Clear();
     // reset "next property identifiers"
@@ -211,6 +216,10 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
         return false;
     }
 
+    // the cached entry is dropped, and read again with the updated unique and delegate fields
+    LOCK(cs_cache);
+    cachedEntries.erase(propertyId);
+
     // DB key for property entry
     CDataStream ssSpKey(SER_DISK, CLIENT_VERSION);
     ssSpKey << std::make_pair('s', propertyId);
@@ -296,6 +305,9 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
     ssTxValue << propertyId;
     leveldb::Slice slTxValue(&ssTxValue[0], ssTxValue.size());
 
+    LOCK(cs_cache);
+    cachedEntries.erase(propertyId);
+
     // sanity checking
     std::string existingEntry;
     if (!pdb->Get(readoptions, slSpKey, &existingEntry).IsNotFound() && slSpValue.compare(existingEntry) != 0) {
@@ -335,16 +347,57 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
 }
 
 bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
+{
+    LOCK(cs_cache);
+    const Entry* entry = getCachedSP(propertyId);
+    if (!entry) return false;
+
+    info = *entry;
+    return true;
+}
+
+bool CMPSPInfo::getSPSummary(uint32_t propertyId, Summary& summary) const
+{
+    LOCK(cs_cache);
+    const Entry* entry = getCachedSP(propertyId);
+    if (!entry) return false;
+
+    summary.issuer = entry->issuer;
+    summary.delegate = entry->delegate;
+    summary.name = entry->name;
+    summary.num_tokens = entry->num_tokens;
+    summary.ecosystem = mastercore::isTestEcosystemProperty(propertyId) ? COUNOS_PROPERTY_TMSC : COUNOS_PROPERTY_MSC;
+    summary.divisible = entry->isDivisible();
+    summary.fixed = entry->fixed;
+    summary.manual = entry->manual;
+    summary.unique = entry->unique;
+    return true;
+}
+
+const CMPSPInfo::Entry* CMPSPInfo::getCachedSP(uint32_t propertyId) const
 {
     // special cases for constant SPs MSC and TMSC
     if (COUNOS_PROPERTY_MSC == propertyId) {
-        info = implied_counos;
-        return true;
+        return &implied_counos;
     } else if (COUNOS_PROPERTY_TMSC == propertyId) {
-        info = implied_tcounos;
-        return true;
+        return &implied_tcounos;
     }
 
+    std::map<uint32_t, Entry>::const_iterator it = cachedEntries.find(propertyId);
+    if (it != cachedEntries.end()) {
+        return &it->second;
+    }
+
+    Entry info;
+    if (!readSP(propertyId, info)) {
+        return nullptr;
+    }
+
+    return &cachedEntries.insert(std::make_pair(propertyId, info)).first->second;
+}
+
+bool CMPSPInfo::readSP(uint32_t propertyId, Entry& info) const
+{
     // DB key for property entry
     CDataStream ssSpKey(SER_DISK, CLIENT_VERSION);
     ssSpKey << std::make_pair('s', propertyId);
@@ -448,6 +501,10 @@ uint32_t CMPSPInfo::findSPByTX(const uint256& txid) const
 
 int64_t CMPSPInfo::popBlock(const uint256& block_hash)
 {
+    // rolled back entries are read again
+    LOCK(cs_cache);
+    cachedEntries.clear();
+
     int64_t remainingSPs = 0;
     leveldb::WriteBatch commitBatch;
     leveldb::Iterator* iter = NewIterator();
@@ -7,6 +7,7 @@
 
 #include <fs.h>
 #include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
 
 #include <stdint.h>
@@ -146,6 +147,21 @@ public:
         std::string getDelegate(int block) const;
     };
 
+    /** Frequently used fields of an entry, which are cheap to copy. */
+    struct Summary {
+        std::string issuer;
+        std::string delegate;
+        std::string name;
+        int64_t num_tokens;
+        uint8_t ecosystem;
+        bool divisible;
+        bool fixed;
+        bool manual;
+        bool unique;
+
+        Summary();
+    };
+
 private:
     // implied version of COUN and TCOUN so they don't hit the leveldb
     Entry implied_counos;
@@ -154,6 +170,16 @@ private:
     uint32_t next_spid;
     uint32_t next_test_spid;
 
+    //! Guards the entry cache
+    mutable RecursiveMutex cs_cache;
+    //! Decoded entries, which were read from the database
+    mutable std::map<uint32_t, Entry> cachedEntries;
+
+    /** Returns the entry of a property, which is read from the database, if it's not cached (requires cs_cache). */
+    const Entry* getCachedSP(uint32_t propertyId) const;
+    /** Reads and decodes an entry from the database. */
+    bool readSP(uint32_t propertyId, Entry& info) const;
+
 public:
     CMPSPInfo(const fs::path& path, bool fWipe);
     virtual ~CMPSPInfo();
@@ -167,6 +193,8 @@ public:
     bool updateSP(uint32_t propertyId, const Entry& info);
     uint32_t putSP(uint8_t ecosystem, const Entry& info);
     bool getSP(uint32_t propertyId, Entry& info) const;
+    /** Returns the frequently used fields of an entry, without copying the historical data. */
+    bool getSPSummary(uint32_t propertyId, Summary& summary) const;
     bool hasSP(uint32_t propertyId) const;
     uint32_t findSPByTX(const uint256& txid) const;
 
@@ -15,6 +15,7 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
+#include <leveldb/write_batch.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -28,10 +29,74 @@
 using mastercore::IsMyAddress;
 using mastercore::isPropertyDivisible;
 
+//! Version of the recipient index, increment to rebuild it on startup
+static const int STO_INDEX_VERSION = 1;
+//! Key of the version of the recipient index
+static const std::string STO_INDEX_VERSION_KEY = "stoindexversion";
+
+static std::string RecipientIndexPrefix(const uint256& txid)
+{
+    return strprintf("t:%s:", txid.ToString());
+}
+
+static std::string RecipientIndexKey(const uint256& txid, const std::string& address)
+{
+    return RecipientIndexPrefix(txid) + address;
+}
+
+/** Returns true for keys, which are not the address of a recipient. */
+static bool IsIndexKey(const std::string& key)
+{
+    return key == STO_INDEX_VERSION_KEY || (key.size() > 2 && key[0] == 't' && key[1] == ':');
+}
+
+const unsigned char CMPSTOListRecord::VERSION;
+
+/**
+ * Parses a record in the legacy "txid:block:property:amount,..." format.
+ *
+ * Records of recipients, whose receipts were all removed, are empty.
+ */
+bool CMPSTOListRecord::ParseLegacy(const std::string& value)
+{
+    receipts.clear();
+
+    std::vector<std::string> vecSTORecords;
+    boost::split(vecSTORecords, value, boost::is_any_of(","), boost::token_compress_on);
+    for (const std::string& strReceipt : vecSTORecords) {
+        if (strReceipt.empty()) continue; // trailing comma
+        std::vector<std::string> vecSTORecordFields;
+        boost::split(vecSTORecordFields, strReceipt, boost::is_any_of(":"), boost::token_compress_on);
+        if (4 != vecSTORecordFields.size() || vecSTORecordFields[0].size() != 64) return false;
+
+        try {
+            receipts.push_back(CMPSTOReceipt(uint256S(vecSTORecordFields[0]),
+                    boost::lexical_cast<int32_t>(vecSTORecordFields[1]),
+                    boost::lexical_cast<uint32_t>(vecSTORecordFields[2]),
+                    boost::lexical_cast<uint64_t>(vecSTORecordFields[3])));
+        } catch (const boost::bad_lexical_cast&) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string CMPSTOListRecord::ToString() const
+{
+    std::string str;
+    for (const CMPSTOReceipt& receipt : receipts) {
+        str += strprintf("%s:%d:%u:%lu,", receipt.txid.ToString(), receipt.nBlock, receipt.propertyId, receipt.nAmount);
+    }
+    return str;
+}
+
 CMPSTOList::CMPSTOList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading send-to-owners database: %s\n", status.ToString());
+
+    if (status.ok()) buildIndexes();
 }
 
 CMPSTOList::~CMPSTOList()
@@ -39,6 +104,64 @@ CMPSTOList::~CMPSTOList()
     if (msc_debug_persistence) PrintToLog("CMPSTOList closed\n");
 }
 
+/**
+ * Adds the recipient index entries of all STO receipts, if the index is missing
+ * or outdated.
+ *
+ * The index is written as part of recording receipts, so this is only needed
+ * once for databases created before the index was introduced.
+ */
+void CMPSTOList::buildIndexes()
+{
+    std::string strVersion;
+    leveldb::Status status = pdb->Get(readoptions, STO_INDEX_VERSION_KEY, &strVersion);
+    if (status.ok() && strVersion == strprintf("%d", STO_INDEX_VERSION)) return;
+
+    leveldb::WriteBatch batch;
+    unsigned int nIndexed = 0;
+    leveldb::Iterator* it = NewIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        std::string recipientAddress = it->key().ToString();
+        if (IsIndexKey(recipientAddress)) continue;
+
+        CMPSTOListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue;
+        for (const CMPSTOReceipt& receipt : record.receipts) {
+            batch.Put(RecipientIndexKey(receipt.txid, recipientAddress), strprintf("%d", receipt.nBlock));
+            ++nIndexed;
+        }
+    }
+    delete it;
+
+    batch.Put(STO_INDEX_VERSION_KEY, strprintf("%d", STO_INDEX_VERSION));
+    status = pdb->Write(syncoptions, &batch);
+
+    if (nIndexed > 0) PrintToConsole("Indexing send-to-owners database: %d receipts indexed\n", nIndexed);
+    PrintToLog("%s(): indexed %d receipts: %s\n", __func__, nIndexed, status.ToString());
+}
+
+/**
+ * Deletes all entries of the database, and marks the index of the now empty database as complete.
+ */
+void CMPSTOList::Clear()
+{
+    CDBBase::Clear();
+    pdb->Put(writeoptions, STO_INDEX_VERSION_KEY, strprintf("%d", STO_INDEX_VERSION));
+}
+
+/**
+ * Obtains the addresses, which received tokens with the given send-to-owners transaction.
+ */
+void CMPSTOList::getRecipientAddresses(const uint256& txid, std::vector<std::string>& addresses)
+{
+    if (!pdb) return;
+
+    const std::string prefix = RecipientIndexPrefix(txid);
+    for (CDBaseIterator it{NewIterator(), prefix}; it && it->key().starts_with(prefix); ++it) {
+        addresses.push_back(it->key().ToString().substr(prefix.size()));
+    }
+}
+
 void CMPSTOList::getRecipients(const uint256 txid, std::string filterAddress, UniValue* recipientArray, uint64_t* total, uint64_t* numRecipients, interfaces::Wallet* iWallet)
 {
     if (!pdb) return;
@@ -53,66 +176,41 @@ void CMPSTOList::getRecipients(const uint256 txid, std::string filterAddress, Un
         filterByAddress = true;
     }
 
-    // iterate through SDB, dropping all records where key is not filterAddress (if filtering)
-    int count = 0;
-
     // the fee is variable based on version of STO - provide number of recipients and allow calling function to work out fee
     *numRecipients = 0;
 
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        std::string recipientAddress = skey.ToString();
-        svalue = it->value();
-        std::string strValue = svalue.ToString();
-        // see if txid is in the data
-        size_t txidMatch = strValue.find(txid.ToString());
-        if (txidMatch != std::string::npos) {
-            ++*numRecipients;
-            // the txid exists inside the data, this address was a recipient of this STO, check filter and add the details
-            if (filter) {
-                if (((filterByAddress) && (filterAddress == recipientAddress)) || ((filterByWallet) && (IsMyAddress(recipientAddress, iWallet)))) {
-                } else {
-                    continue;
-                } // move on if no filter match (but counter still increased for fee)
-            }
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(","), boost::token_compress_on);
-            for (uint32_t i = 0; i < vstr.size(); i++) {
-                std::vector<std::string> svstr;
-                boost::split(svstr, vstr[i], boost::is_any_of(":"), boost::token_compress_on);
-                if (4 == svstr.size()) {
-                    if (svstr[0] == txid.ToString()) {
-                        //add data to array
-                        uint64_t amount = 0;
-                        uint64_t propertyId = 0;
-                        try {
-                            amount = boost::lexical_cast<uint64_t>(svstr[3]);
-                            propertyId = boost::lexical_cast<uint64_t>(svstr[2]);
-                        } catch (const boost::bad_lexical_cast &e) {
-                            PrintToLog("DEBUG STO - error in converting values from leveldb\n");
-                            delete it;
-                            return; //(something went wrong)
-                        }
-                        UniValue recipient(UniValue::VOBJ);
-                        recipient.pushKV("address", recipientAddress);
-                        if (isPropertyDivisible(propertyId)) {
-                            recipient.pushKV("amount", FormatDivisibleMP(amount));
-                        } else {
-                            recipient.pushKV("amount", FormatIndivisibleMP(amount));
-                        }
-                        *total += amount;
-                        recipientArray->push_back(recipient);
-                        ++count;
-                    }
-                }
+    // the recipient index lists the addresses, which received tokens with this transaction
+    std::vector<std::string> recipientAddresses;
+    getRecipientAddresses(txid, recipientAddresses);
+
+    for (const std::string& recipientAddress : recipientAddresses) {
+        ++*numRecipients;
+        // this address was a recipient of this STO, check filter and add the details
+        if (filter) {
+            if (((filterByAddress) && (filterAddress == recipientAddress)) || ((filterByWallet) && (IsMyAddress(recipientAddress, iWallet)))) {
+            } else {
+                continue;
+            } // move on if no filter match (but counter still increased for fee)
+        }
+        CMPSTOListRecord record;
+        if (!ReadRecord(recipientAddress, record)) {
+            PrintToLog("DEBUG STO - error in converting values from leveldb\n");
+            return; //(something went wrong)
+        }
+        for (const CMPSTOReceipt& receipt : record.receipts) {
+            if (receipt.txid != txid) continue;
+            //add data to array
+            UniValue recipient(UniValue::VOBJ);
+            recipient.pushKV("address", recipientAddress);
+            if (isPropertyDivisible(receipt.propertyId)) {
+                recipient.pushKV("amount", FormatDivisibleMP(receipt.nAmount));
+            } else {
+                recipient.pushKV("amount", FormatIndivisibleMP(receipt.nAmount));
             }
+            *total += receipt.nAmount;
+            recipientArray->push_back(recipient);
         }
     }
-
-    delete it;
-    return;
 }
 
 std::string CMPSTOList::getMySTOReceipts(std::string filterAddress, interfaces::Wallet &iWallet)
@@ -124,22 +222,18 @@ std::string CMPSTOList::getMySTOReceipts(std::string filterAddress, interfaces::
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
         skey = it->key();
         std::string recipientAddress = skey.ToString();
+        if (IsIndexKey(recipientAddress)) continue;
         if (!IsMyAddress(recipientAddress, &iWallet)) continue; // not ours, not interested
         if ((!filterAddress.empty()) && (filterAddress != recipientAddress)) continue; // not the filtered address
         // ours, get info
         svalue = it->value();
-        std::string strValue = svalue.ToString();
-        // break into individual receipts
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of(","), boost::token_compress_on);
-        for (uint32_t i = 0; i < vstr.size(); i++) {
+        CMPSTOListRecord record;
+        if (!DecodeDBRecord(svalue, record)) continue;
+        for (const CMPSTOReceipt& receipt : record.receipts) {
             // add to array
-            std::vector<std::string> svstr;
-            boost::split(svstr, vstr[i], boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == svstr.size()) {
-                size_t txidMatch = mySTOReceipts.find(svstr[0]);
-                if (txidMatch == std::string::npos) mySTOReceipts += svstr[0] + ":" + svstr[1] + ":" + recipientAddress + ":" + svstr[2] + ",";
-            }
+            const std::string strTxid = receipt.txid.ToString();
+            size_t txidMatch = mySTOReceipts.find(strTxid);
+            if (txidMatch == std::string::npos) mySTOReceipts += strprintf("%s:%d:%s:%u,", strTxid, receipt.nBlock, recipientAddress, receipt.propertyId);
         }
     }
     delete it;
@@ -156,26 +250,30 @@ std::string CMPSTOList::getMySTOReceipts(std::string filterAddress, interfaces::
 int CMPSTOList::deleteAboveBlock(int blockNum)
 {
     unsigned int n_found = 0;
-    std::vector<std::string> vecSTORecords;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string newValue;
-        std::string oldValue = it->value().ToString();
+        std::string strKey = it->key().ToString();
+        if (IsIndexKey(strKey)) {
+            // recipient index entries carry the block as value
+            if (strKey != STO_INDEX_VERSION_KEY && atoi(it->value().ToString()) >= blockNum) {
+                pdb->Delete(writeoptions, strKey);
+            }
+            continue;
+        }
+        CMPSTOListRecord oldRecord;
+        if (!DecodeDBRecord(it->value(), oldRecord)) continue;
+        CMPSTOListRecord newRecord;
         bool needsUpdate = false;
-        boost::split(vecSTORecords, oldValue, boost::is_any_of(","), boost::token_compress_on);
-        for (uint32_t i = 0; i < vecSTORecords.size(); i++) {
-            std::vector<std::string> vecSTORecordFields;
-            boost::split(vecSTORecordFields, vecSTORecords[i], boost::is_any_of(":"), boost::token_compress_on);
-            if (4 != vecSTORecordFields.size()) continue;
-            if (atoi(vecSTORecordFields[1]) < blockNum) {
-                newValue += vecSTORecords[i].append(","); // STO before the reorg, add data back to new value string
+        for (const CMPSTOReceipt& receipt : oldRecord.receipts) {
+            if (receipt.nBlock < blockNum) {
+                newRecord.receipts.push_back(receipt); // STO before the reorg, add data back to new record
             } else {
                 needsUpdate = true;
             }
         }
         if (needsUpdate) { // rewrite record with existing key and new value
             ++n_found;
-            leveldb::Status status = pdb->Put(writeoptions, it->key().ToString(), newValue);
+            leveldb::Status status = WriteRecord(strKey, newRecord);
             PrintToLog("DEBUG STO - rewriting STO data after reorg\n");
             PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
         }
@@ -203,7 +301,12 @@ void CMPSTOList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        CMPSTOListRecord record;
+        if (!IsIndexKey(skey.ToString()) && DecodeDBRecord(svalue, record)) {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), record.ToString());
+        } else {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        }
     }
 
     delete it;
@@ -227,35 +330,22 @@ void CMPSTOList::recordSTOReceive(std::string address, const uint256 &txid, int
 {
     if (!pdb) return;
 
-    bool addressExists = exists(address);
-    if (addressExists) {
-        // retrieve existing record
-        std::vector<std::string> vstr;
-        std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, address, &strValue);
-        if (status.ok()) {
-            // add details to record
-            // see if we are overwriting (check)
-            size_t txidMatch = strValue.find(txid.ToString());
-            if (txidMatch != std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n", address, txid.ToString());
-
-            const std::string key = address;
-            const std::string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-            strValue += newValue;
-            // write updated record
-            leveldb::Status status;
-            if (pdb) {
-                status = pdb->Put(writeoptions, key, strValue);
-                PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-            }
+    // retrieve existing record, if any
+    CMPSTOListRecord record;
+    if (ReadRecord(address, record)) {
+        // see if we are overwriting (check)
+        for (const CMPSTOReceipt& receipt : record.receipts) {
+            if (receipt.txid == txid) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n", address, txid.ToString());
         }
     } else {
-        const std::string key = address;
-        const std::string value = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-        leveldb::Status status;
-        if (pdb) {
-            status = pdb->Put(writeoptions, key, value);
-            PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-        }
+        record.receipts.clear();
     }
+
+    // add details to record and write updated record
+    record.receipts.push_back(CMPSTOReceipt(txid, nBlock, propertyId, amount));
+    leveldb::WriteBatch batch;
+    WriteRecord(batch, address, record);
+    batch.Put(RecipientIndexKey(txid, address), strprintf("%d", nBlock));
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
 }
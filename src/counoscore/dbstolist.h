@@ -4,6 +4,7 @@
 #include <counoscore/dbbase.h>
 
 #include <fs.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <univalue.h>
@@ -11,19 +12,76 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 namespace interfaces {
 class Wallet;
 } // namespace interfaces
 
-/** LevelDB based storage for STO recipients.
+/** A single receipt of tokens sent with a send-to-owners transaction. */
+class CMPSTOReceipt
+{
+public:
+    uint256 txid;
+    int32_t nBlock;
+    uint32_t propertyId;
+    uint64_t nAmount;
+
+    CMPSTOReceipt() : nBlock(0), propertyId(0), nAmount(0) {}
+
+    CMPSTOReceipt(const uint256& txidIn, int32_t nBlockIn, uint32_t propertyIdIn, uint64_t nAmountIn)
+      : txid(txidIn), nBlock(nBlockIn), propertyId(propertyIdIn), nAmount(nAmountIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(nBlock);
+        READWRITE(propertyId);
+        READWRITE(nAmount);
+    }
+};
+
+/** The receipts of one recipient, stored with the address as key. */
+class CMPSTOListRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    std::vector<CMPSTOReceipt> receipts;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(receipts);
+    }
+
+    /** Parses a record in the legacy "txid:block:property:amount,..." format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
+/** LevelDB based storage for STO recipients. Receipts are listed with the address as key.
+ *
+ * Receipts are additionally indexed with key "t:txid:address", so the recipients
+ * of a transaction can be found without iterating over all addresses.
  */
 class CMPSTOList : public CDBBase
 {
+private:
+    void buildIndexes();
+
 public:
     CMPSTOList(const fs::path& path, bool fWipe);
     virtual ~CMPSTOList();
 
+    void Clear();
+    void getRecipientAddresses(const uint256& txid, std::vector<std::string>& addresses);
+
     void getRecipients(const uint256 txid, std::string filterAddress, UniValue* recipientArray, uint64_t* total, uint64_t* numRecipients, interfaces::Wallet* iWallet = nullptr);
     std::string getMySTOReceipts(std::string filterAddress, interfaces::Wallet& iWallet);
     
@@ -18,6 +18,7 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
+#include <leveldb/write_batch.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -26,16 +27,145 @@
 
 #include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
 using mastercore::isPropertyDivisible;
 
+//! Version of the address and pair indexes, increment to rebuild them on startup
+static const int TRADE_INDEX_VERSION = 1;
+//! Key of the version of the address and pair indexes
+static const std::string TRADE_INDEX_VERSION_KEY = "tradeindexversion";
+
+static std::string AddressIndexPrefix(const std::string& address)
+{
+    return strprintf("a:%s:", address);
+}
+
+static std::string AddressIndexKey(const std::string& address, int blockNum, int blockIndex)
+{
+    return strprintf("a:%s:%010d:%010d", address, blockNum, blockIndex);
+}
+
+static std::string PairIndexPrefix(uint32_t propertyIdA, uint32_t propertyIdB)
+{
+    if (propertyIdA > propertyIdB) std::swap(propertyIdA, propertyIdB);
+    return strprintf("p:%010d:%010d:", propertyIdA, propertyIdB);
+}
+
+static std::string PairIndexKey(uint32_t propertyIdA, uint32_t propertyIdB, int blockNum, int blockIndex, const std::string& tradeKey)
+{
+    return PairIndexPrefix(propertyIdA, propertyIdB) + strprintf("%010d:%010d:%s", blockNum, blockIndex, tradeKey);
+}
+
+static bool IsIndexKey(const std::string& key)
+{
+    return key.size() > 2 && key[1] == ':' && (key[0] == 'a' || key[0] == 'p');
+}
+
+/**
+ * Returns the block of an index entry.
+ *
+ * Address index keys end with the block and index, and in pair index keys the
+ * block follows the two property identifiers.
+ */
+static int GetIndexKeyBlock(const std::string& key)
+{
+    if (key[0] == 'a') {
+        return atoi(key.substr(key.size() - 21, 10));
+    }
+    return atoi(key.substr(24, 10));
+}
+
+const unsigned char CMPTradeRecord::VERSION;
+const unsigned char CMPTradeMatchRecord::VERSION;
+const unsigned char CMPTradeAddressIndexRecord::VERSION;
+
+/**
+ * Parses a record in the legacy "address:propertyForSale:propertyDesired:block:idx" format.
+ */
+bool CMPTradeRecord::ParseLegacy(const std::string& value)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (5 != vstr.size()) return false; // unexpected number of tokens
+
+    try {
+        address = vstr[0];
+        propertyIdForSale = boost::lexical_cast<uint32_t>(vstr[1]);
+        propertyIdDesired = boost::lexical_cast<uint32_t>(vstr[2]);
+        nBlock = boost::lexical_cast<int32_t>(vstr[3]);
+        nBlockIndex = boost::lexical_cast<int32_t>(vstr[4]);
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string CMPTradeRecord::ToString() const
+{
+    return strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, nBlock, nBlockIndex);
+}
+
+/**
+ * Parses a record in the legacy "address1:address2:prop1:prop2:amount1:amount2:block:fee" format.
+ */
+bool CMPTradeMatchRecord::ParseLegacy(const std::string& value)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (8 != vstr.size()) return false; // unexpected number of tokens
+
+    try {
+        address1 = vstr[0];
+        address2 = vstr[1];
+        prop1 = boost::lexical_cast<uint32_t>(vstr[2]);
+        prop2 = boost::lexical_cast<uint32_t>(vstr[3]);
+        amount1 = boost::lexical_cast<int64_t>(vstr[4]);
+        amount2 = boost::lexical_cast<int64_t>(vstr[5]);
+        nBlock = boost::lexical_cast<int32_t>(vstr[6]);
+        nFee = boost::lexical_cast<int64_t>(vstr[7]);
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string CMPTradeMatchRecord::ToString() const
+{
+    return strprintf("%s:%s:%u:%u:%d:%d:%d:%d", address1, address2, prop1, prop2, amount1, amount2, nBlock, nFee);
+}
+
+/**
+ * Parses an address index entry in the legacy "txid:propertyForSale:propertyDesired" format.
+ */
+bool CMPTradeAddressIndexRecord::ParseLegacy(const std::string& value)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (3 != vstr.size() || vstr[0].size() != 64) return false;
+
+    try {
+        txid = uint256S(vstr[0]);
+        propertyIdForSale = boost::lexical_cast<uint32_t>(vstr[1]);
+        propertyIdDesired = boost::lexical_cast<uint32_t>(vstr[2]);
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+
+    return true;
+}
+
 CMPTradeList::CMPTradeList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading trades database: %s\n", status.ToString());
+
+    if (status.ok()) buildIndexes();
 }
 
 CMPTradeList::~CMPTradeList()
@@ -43,22 +173,84 @@ CMPTradeList::~CMPTradeList()
     if (msc_debug_persistence) PrintToLog("CMPTradeList closed\n");
 }
 
-void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int64_t fee)
+/**
+ * Adds the address and pair index entries of all trades, if the indexes are
+ * missing or outdated.
+ *
+ * The indexes are written as part of recording trades, so this is only needed
+ * once for databases created before the indexes were introduced.
+ */
+void CMPTradeList::buildIndexes()
+{
+    std::string strVersion;
+    leveldb::Status status = pdb->Get(readoptions, TRADE_INDEX_VERSION_KEY, &strVersion);
+    if (status.ok() && strVersion == strprintf("%d", TRADE_INDEX_VERSION)) return;
+
+    leveldb::WriteBatch batch;
+    unsigned int nIndexed = 0;
+    leveldb::Iterator* it = NewIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        std::string strKey = it->key().ToString();
+
+        if (strKey.size() == 64) {
+            CMPTradeRecord trade;
+            if (!DecodeDBRecord(it->value(), trade)) continue;
+            WriteRecord(batch, AddressIndexKey(trade.address, trade.nBlock, trade.nBlockIndex),
+                    CMPTradeAddressIndexRecord(uint256S(strKey), trade.propertyIdForSale, trade.propertyIdDesired));
+            ++nIndexed;
+        } else if (strKey.size() == 129) {
+            CMPTradeMatchRecord match;
+            if (!DecodeDBRecord(it->value(), match)) continue;
+
+            // the position within the block is taken from the new trade of the second txid
+            int blockIndex = 0;
+            std::string strNewTrade;
+            CMPTradeRecord trade;
+            if (pdb->Get(readoptions, strKey.substr(65, 64), &strNewTrade).ok() && DecodeDBRecord(strNewTrade, trade)) {
+                blockIndex = trade.nBlockIndex;
+            }
+            batch.Put(PairIndexKey(match.prop1, match.prop2, match.nBlock, blockIndex, strKey), strKey);
+            ++nIndexed;
+        }
+    }
+    delete it;
+
+    batch.Put(TRADE_INDEX_VERSION_KEY, strprintf("%d", TRADE_INDEX_VERSION));
+    status = pdb->Write(syncoptions, &batch);
+
+    if (nIndexed > 0) PrintToConsole("Indexing trades database: %d trades indexed\n", nIndexed);
+    PrintToLog("%s(): indexed %d trades: %s\n", __func__, nIndexed, status.ToString());
+}
+
+/**
+ * Deletes all entries of the database, and marks the indexes of the now empty database as complete.
+ */
+void CMPTradeList::Clear()
+{
+    CDBBase::Clear();
+    pdb->Put(writeoptions, TRADE_INDEX_VERSION_KEY, strprintf("%d", TRADE_INDEX_VERSION));
+}
+
+void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int blockIndex, int64_t fee)
 {
     if (!pdb) return;
     const std::string key = txid1.ToString() + "+" + txid2.ToString();
-    const std::string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
-    ++nWritten;
+    const CMPTradeMatchRecord record(address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
+    leveldb::WriteBatch batch;
+    WriteRecord(batch, key, record);
+    batch.Put(PairIndexKey(prop1, prop2, blockNum, blockIndex, key), key);
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
 
 void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex)
 {
     if (!pdb) return;
-    std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-    leveldb::Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
-    ++nWritten;
+    const CMPTradeRecord record(address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
+    leveldb::WriteBatch batch;
+    WriteRecord(batch, txid.ToString(), record);
+    WriteRecord(batch, AddressIndexKey(address, blockNum, blockIndex), CMPTradeAddressIndexRecord(txid, propertyIdForSale, propertyIdDesired));
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
 
@@ -69,23 +261,25 @@ void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& addres
  */
 int CMPTradeList::deleteAboveBlock(int blockNum)
 {
-    leveldb::Slice skey, svalue;
-    unsigned int count = 0;
-    std::vector<std::string> vstr;
-    int block = 0;
+    leveldb::Slice skey;
     unsigned int n_found = 0;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
         skey = it->key();
-        svalue = it->value();
-        ++count;
-        std::string strvalue = it->value().ToString();
-        boost::split(vstr, strvalue, boost::is_any_of(":"), boost::token_compress_on);
-        if (7 == vstr.size()) block = atoi(vstr[6]); // trade matches have 7 tokens, key is txid+txid, only care about block
-        if (5 == vstr.size()) block = atoi(vstr[3]); // trades have 5 tokens, key is txid, only care about block
-        if (block >= blockNum) {
+        int block = -1;
+        std::string strkey = it->key().ToString();
+        if (IsIndexKey(strkey)) {
+            block = GetIndexKeyBlock(strkey); // index entries carry the block in the key
+        } else if (strkey.size() == 64) {
+            CMPTradeRecord trade;
+            if (DecodeDBRecord(it->value(), trade)) block = trade.nBlock; // key is txid, only care about block
+        } else if (strkey.size() == 129) {
+            CMPTradeMatchRecord match;
+            if (DecodeDBRecord(it->value(), match)) block = match.nBlock; // key is txid+txid, only care about block
+        }
+        if (block >= 0 && block >= blockNum) {
             ++n_found;
-            PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
+            PrintToLog("%s() DELETING FROM TRADEDB: %s\n", __func__, strkey);
             pdb->Delete(writeoptions, skey);
         }
     }
@@ -112,7 +306,15 @@ void CMPTradeList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        CMPTradeRecord trade;
+        CMPTradeMatchRecord match;
+        if (skey.size() == 64 && DecodeDBRecord(svalue, trade)) {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), trade.ToString());
+        } else if (skey.size() == 129 && DecodeDBRecord(svalue, match)) {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), match.ToString());
+        } else {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), HexStr(svalue.data(), svalue.data() + svalue.size()));
+        }
     }
 
     delete it;
@@ -126,13 +328,11 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
     totalReceived = 0;
     totalSold = 0;
 
-    std::vector<std::string> vstr;
     std::string txidStr = txid.ToString();
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
         // search key to see if this is a matching trade
         std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
         std::string matchTxid;
         size_t txidMatch = strKey.find(txidStr);
         if (txidMatch == std::string::npos) continue; // no match
@@ -147,22 +347,20 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
             matchTxid = strKey.substr(0, 64);
         }
 
-        // ensure correct amount of tokens in value string
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vstr.size() != 8) {
-            PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+        // decode the details of the match
+        CMPTradeMatchRecord match;
+        if (!DecodeDBRecord(it->value(), match)) {
+            PrintToLog("TRADEDB error - unexpected value of trade match (%s)\n", strKey);
             continue;
         }
-
-        // decode the details from the value string
-        std::string address1 = vstr[0];
-        std::string address2 = vstr[1];
-        uint32_t prop1 = boost::lexical_cast<uint32_t>(vstr[2]);
-        uint32_t prop2 = boost::lexical_cast<uint32_t>(vstr[3]);
-        int64_t amount1 = boost::lexical_cast<int64_t>(vstr[4]);
-        int64_t amount2 = boost::lexical_cast<int64_t>(vstr[5]);
-        int blockNum = atoi(vstr[6]);
-        int64_t tradingFee = boost::lexical_cast<int64_t>(vstr[7]);
+        const std::string& address1 = match.address1;
+        const std::string& address2 = match.address2;
+        uint32_t prop1 = match.prop1;
+        uint32_t prop2 = match.prop2;
+        int64_t amount1 = match.amount1;
+        int64_t amount2 = match.amount2;
+        int blockNum = match.nBlock;
+        int64_t tradingFee = match.nFee;
 
         std::string strAmount1 = FormatMP(prop1, amount1);
         std::string strAmount2 = FormatMP(prop2, amount2);
@@ -213,80 +411,88 @@ void CMPTradeList::getTradesForAddress(const std::string& address, std::vector<u
 {
     if (!pdb) return;
 
-    std::map<std::string, uint256> mapTrades;
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vecValues;
-        if (strKey.size() != 64) continue; // only interested in trades
-        uint256 txid = uint256S(strKey);
-        size_t addressMatch = strValue.find(address);
-        if (addressMatch == std::string::npos) continue;
-        boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vecValues.size() != 5) {
-            PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+    const std::string prefix = AddressIndexPrefix(address);
+    for (CDBaseIterator it{NewIterator(), prefix}; it && it->key().starts_with(prefix); ++it) {
+        CMPTradeAddressIndexRecord entry;
+        if (!DecodeDBRecord(it->value(), entry)) {
+            PrintToLog("TRADEDB error - unexpected value of address index entry (%s)\n", it->key().ToString());
             continue;
         }
-        uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vecValues[1]);
-        uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vecValues[2]);
-        int64_t blockNum = boost::lexical_cast<uint32_t>(vecValues[3]);
-        int64_t txIndex = boost::lexical_cast<uint32_t>(vecValues[4]);
-        if (propertyIdFilter != 0 && propertyIdFilter != propertyIdForSale && propertyIdFilter != propertyIdDesired) continue;
-        std::string sortKey = strprintf("%06d%010d", blockNum, txIndex);
-        mapTrades.insert(std::make_pair(sortKey, txid));
-    }
-    delete it;
-
-    for (std::map<std::string, uint256>::iterator it = mapTrades.begin(); it != mapTrades.end(); it++) {
-        vecTransactions.push_back(it->second);
+        if (propertyIdFilter != 0 && propertyIdFilter != entry.propertyIdForSale && propertyIdFilter != entry.propertyIdDesired) continue;
+        vecTransactions.push_back(entry.txid);
     }
 }
 
-static bool CompareTradePair(const std::pair<int64_t, UniValue>& firstJSONObj, const std::pair<int64_t, UniValue>& secondJSONObj)
+// obtains the addresses of the orders, which were matched by the supplied trade, when it was added to the order book
+void CMPTradeList::getTradeCounterparties(const uint256& txid, std::set<std::string>& addresses)
 {
-    return firstJSONObj.first > secondJSONObj.first;
+    if (!pdb) return;
+
+    CMPTradeRecord trade;
+    if (!ReadRecord(txid.ToString(), trade)) return;
+
+    // the matches of the new trade are indexed with its block and position
+    const std::string prefix = PairIndexPrefix(trade.propertyIdForSale, trade.propertyIdDesired) + strprintf("%010d:%010d:", trade.nBlock, trade.nBlockIndex);
+    const std::string txidStr = txid.ToString();
+    for (CDBaseIterator it{NewIterator(), prefix}; it && it->key().starts_with(prefix); ++it) {
+        // "txid1+txid2", where the new trade is the second one
+        std::string strKey = it->value().ToString();
+        if (strKey.size() != 129 || strKey.compare(65, 64, txidStr) != 0) continue;
+
+        CMPTradeMatchRecord match;
+        if (!ReadRecord(strKey, match)) {
+            PrintToLog("TRADEDB error - unexpected value of trade match (%s)\n", strKey);
+            continue;
+        }
+        addresses.insert(match.address1);
+    }
 }
 
 // obtains an array of matching trades with pricing and volume details for a pair sorted by blocknumber
 void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& responseArray, uint64_t count)
 {
     if (!pdb) return;
-    leveldb::Iterator* it = NewIterator();
-    std::vector<std::pair<int64_t, UniValue> > vecResponse;
+    std::vector<UniValue> vecResponse;
     bool propertyIdSideAIsDivisible = isPropertyDivisible(propertyIdSideA);
     bool propertyIdSideBIsDivisible = isPropertyDivisible(propertyIdSideB);
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string strKey = it->key().ToString();
-        std::string strValue = it->value().ToString();
-        std::vector<std::string> vecKeys;
-        std::vector<std::string> vecValues;
+
+    // walk the index of the pair backwards, starting with the most recent trade
+    const std::string prefix = PairIndexPrefix(propertyIdSideA, propertyIdSideB);
+    std::string end = prefix;
+    end[end.size() - 1] = ':' + 1;
+    leveldb::Iterator* it = NewIterator();
+    it->Seek(end);
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+
+    for (; it->Valid() && it->key().starts_with(prefix) && vecResponse.size() < count; it->Prev()) {
+        std::string strKey = it->value().ToString();
+        CMPTradeMatchRecord match;
+        if (strKey.size() != 129 || !ReadRecord(strKey, match)) {
+            PrintToLog("TRADEDB error - unexpected trade match (%s)\n", strKey);
+            continue;
+        }
+
         uint256 sellerTxid, matchingTxid;
         std::string sellerAddress, matchingAddress;
         int64_t amountReceived = 0, amountSold = 0;
-        if (strKey.size() != 129) continue; // only interested in matches
-        boost::split(vecKeys, strKey, boost::is_any_of("+"), boost::token_compress_on);
-        boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vecKeys.size() != 2 || vecValues.size() != 8) {
-            PrintToLog("TRADEDB error - unexpected number of tokens (%s:%s)\n", strKey, strValue);
-            continue;
-        }
-        uint32_t tradePropertyIdSideA = boost::lexical_cast<uint32_t>(vecValues[2]);
-        uint32_t tradePropertyIdSideB = boost::lexical_cast<uint32_t>(vecValues[3]);
-        if (tradePropertyIdSideA == propertyIdSideA && tradePropertyIdSideB == propertyIdSideB) {
-            sellerTxid.SetHex(vecKeys[1]);
-            sellerAddress = vecValues[1];
-            amountSold = boost::lexical_cast<int64_t>(vecValues[4]);
-            matchingTxid.SetHex(vecKeys[0]);
-            matchingAddress = vecValues[0];
-            amountReceived = boost::lexical_cast<int64_t>(vecValues[5]);
-        } else if (tradePropertyIdSideB == propertyIdSideA && tradePropertyIdSideA == propertyIdSideB) {
-            sellerTxid.SetHex(vecKeys[0]);
-            sellerAddress = vecValues[0];
-            amountSold = boost::lexical_cast<int64_t>(vecValues[5]);
-            matchingTxid.SetHex(vecKeys[1]);
-            matchingAddress = vecValues[1];
-            amountReceived = boost::lexical_cast<int64_t>(vecValues[4]);
+        if (match.prop1 == propertyIdSideA && match.prop2 == propertyIdSideB) {
+            sellerTxid.SetHex(strKey.substr(65, 64));
+            sellerAddress = match.address2;
+            amountSold = match.amount1;
+            matchingTxid.SetHex(strKey.substr(0, 64));
+            matchingAddress = match.address1;
+            amountReceived = match.amount2;
+        } else if (match.prop2 == propertyIdSideA && match.prop1 == propertyIdSideB) {
+            sellerTxid.SetHex(strKey.substr(0, 64));
+            sellerAddress = match.address1;
+            amountSold = match.amount2;
+            matchingTxid.SetHex(strKey.substr(65, 64));
+            matchingAddress = match.address2;
+            amountReceived = match.amount1;
         } else {
             continue;
         }
@@ -298,7 +504,7 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
         std::string unitPriceStr = xToString(unitPrice); // TODO: not here!
         std::string inversePriceStr = xToString(inversePrice);
 
-        int64_t blockNum = boost::lexical_cast<int64_t>(vecValues[6]);
+        int64_t blockNum = match.nBlock;
 
         UniValue trade(UniValue::VOBJ);
         trade.pushKV("block", blockNum);
@@ -322,26 +528,14 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
         }
         trade.pushKV("matchingtxid", matchingTxid.GetHex());
         trade.pushKV("matchingaddress", matchingAddress);
-        vecResponse.push_back(std::make_pair(blockNum, trade));
-    }
-
-    // sort the response most recent first before adding to the array
-    std::sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
-    uint64_t processed = 0;
-    for (std::vector<std::pair<int64_t, UniValue> >::iterator it = vecResponse.begin(); it != vecResponse.end(); ++it) {
-        responseArray.push_back(it->second);
-        processed++;
-        if (processed >= count) break;
+        vecResponse.push_back(trade);
     }
+    delete it;
 
-    std::vector<UniValue> responseArrayValues = responseArray.getValues();
-    std::reverse(responseArrayValues.begin(), responseArrayValues.end());
-    responseArray.clear();
-    for (std::vector<UniValue>::iterator it = responseArrayValues.begin(); it != responseArrayValues.end(); ++it) {
+    // the trades were collected most recent first, but are returned oldest first
+    for (std::vector<UniValue>::reverse_iterator it = vecResponse.rbegin(); it != vecResponse.rend(); ++it) {
         responseArray.push_back(*it);
     }
-
-    delete it;
 }
 
 int CMPTradeList::getMPTradeCountTotal()
@@ -349,7 +543,9 @@ int CMPTradeList::getMPTradeCountTotal()
     int count = 0;
     leveldb::Iterator* it = NewIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        ++count;
+        // only count trades and matches, but not index entries
+        size_t nKeySize = it->key().size();
+        if (nKeySize == 64 || nKeySize == 129) ++count;
     }
     delete it;
     return count;
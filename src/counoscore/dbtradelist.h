@@ -4,32 +4,150 @@
 #include <counoscore/dbbase.h>
 
 #include <fs.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <univalue.h>
 
 #include <stdint.h>
 
+#include <set>
 #include <string>
 #include <vector>
 
+/** A new trade, which was added to the MetaDEx, stored with key "txid". */
+class CMPTradeRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    std::string address;
+    uint32_t propertyIdForSale;
+    uint32_t propertyIdDesired;
+    int32_t nBlock;
+    int32_t nBlockIndex;
+
+    CMPTradeRecord() : propertyIdForSale(0), propertyIdDesired(0), nBlock(0), nBlockIndex(0) {}
+
+    CMPTradeRecord(const std::string& addressIn, uint32_t propertyIdForSaleIn, uint32_t propertyIdDesiredIn, int32_t nBlockIn, int32_t nBlockIndexIn)
+      : address(addressIn), propertyIdForSale(propertyIdForSaleIn), propertyIdDesired(propertyIdDesiredIn), nBlock(nBlockIn), nBlockIndex(nBlockIndexIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(address);
+        READWRITE(propertyIdForSale);
+        READWRITE(propertyIdDesired);
+        READWRITE(nBlock);
+        READWRITE(nBlockIndex);
+    }
+
+    /** Parses a record in the legacy "address:propertyForSale:propertyDesired:block:idx" format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
+/** A match of two trades, stored with key "txid1+txid2". */
+class CMPTradeMatchRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    std::string address1;
+    std::string address2;
+    uint32_t prop1;
+    uint32_t prop2;
+    int64_t amount1;
+    int64_t amount2;
+    int32_t nBlock;
+    int64_t nFee;
+
+    CMPTradeMatchRecord() : prop1(0), prop2(0), amount1(0), amount2(0), nBlock(0), nFee(0) {}
+
+    CMPTradeMatchRecord(const std::string& address1In, const std::string& address2In, uint32_t prop1In, uint32_t prop2In,
+                        int64_t amount1In, int64_t amount2In, int32_t nBlockIn, int64_t nFeeIn)
+      : address1(address1In), address2(address2In), prop1(prop1In), prop2(prop2In),
+        amount1(amount1In), amount2(amount2In), nBlock(nBlockIn), nFee(nFeeIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(address1);
+        READWRITE(address2);
+        READWRITE(prop1);
+        READWRITE(prop2);
+        READWRITE(amount1);
+        READWRITE(amount2);
+        READWRITE(nBlock);
+        READWRITE(nFee);
+    }
+
+    /** Parses a record in the legacy "address1:address2:prop1:prop2:amount1:amount2:block:fee" format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
+/** An entry of the address index, stored with key "a:address:block:idx". */
+class CMPTradeAddressIndexRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    uint256 txid;
+    uint32_t propertyIdForSale;
+    uint32_t propertyIdDesired;
+
+    CMPTradeAddressIndexRecord() : propertyIdForSale(0), propertyIdDesired(0) {}
+
+    CMPTradeAddressIndexRecord(const uint256& txidIn, uint32_t propertyIdForSaleIn, uint32_t propertyIdDesiredIn)
+      : txid(txidIn), propertyIdForSale(propertyIdForSaleIn), propertyIdDesired(propertyIdDesiredIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(propertyIdForSale);
+        READWRITE(propertyIdDesired);
+    }
+
+    /** Parses a record in the legacy "txid:propertyForSale:propertyDesired" format. */
+    bool ParseLegacy(const std::string& value);
+};
+
 /** LevelDB based storage for the MetaDEx trade history. Trades are listed with key "txid1+txid2".
+ *
+ * New trades are additionally indexed with key "a:address:block:idx", and matched trades
+ * with key "p:propertyA:propertyB:block:idx:txid1+txid2", where propertyA is the lower
+ * property identifier of the pair.
  */
 class CMPTradeList : public CDBBase
 {
+private:
+    void buildIndexes();
+
 public:
     CMPTradeList(const fs::path& path, bool fWipe);
     virtual ~CMPTradeList();
 
-    void recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int64_t fee);
+    void recordMatchedTrade(const uint256& txid1, const uint256& txid2, const std::string& address1, const std::string& address2, uint32_t prop1, uint32_t prop2, int64_t amount1, int64_t amount2, int blockNum, int blockIndex, int64_t fee);
     void recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex);
     int deleteAboveBlock(int blockNum);
+    void Clear();
     bool exists(const uint256 &txid);
     void printStats();
     void printAll();
     bool getMatchingTrades(const uint256& txid, uint32_t propertyId, UniValue& tradeArray, int64_t& totalSold, int64_t& totalBought);
     void getTradesForAddress(const std::string& address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter = 0);
     void getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& response, uint64_t count);
+    void getTradeCounterparties(const uint256& txid, std::set<std::string>& addresses);
     int getMPTradeCountTotal();
 };
 
@@ -18,7 +18,17 @@
 #include <string>
 #include <vector>
 
-CCounosTransactionDB::CCounosTransactionDB(const fs::path& path, bool fWipe)
+//! Prefix of the keys of decoded transactions, which are binary and therefore never collide with the hex txids
+static const char DB_DECODED_TX = 'D';
+
+static std::string DecodedTransactionKey(const uint256& txid)
+{
+    std::string key(1, DB_DECODED_TX);
+    key.append(txid.begin(), txid.end());
+    return key;
+}
+
+CCounosTransactionDB::CCounosTransactionDB(const fs::path& path, bool fWipe) : nMaxDecodedEntries(DEFAULT_DECODED_TX_CACHE_SIZE)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading master transactions database: %s\n", status.ToString());
@@ -29,6 +39,17 @@ CCounosTransactionDB::~CCounosTransactionDB()
     if (msc_debug_persistence) PrintToLog("CCounosTransactionDB closed\n");
 }
 
+void CCounosTransactionDB::Clear()
+{
+    {
+        LOCK(cs_decoded);
+        decodedEntries.clear();
+        mapDecodedEntries.clear();
+    }
+    // wipe database via parent class
+    CDBBase::Clear();
+}
+
 /**
  * Retrieves the serialized transaction details from the DB. 
  */
@@ -98,3 +119,102 @@ std::string CCounosTransactionDB::FetchInvalidReason(const uint256& txid)
 
     return error_str(processingResult);
 }
+
+/**
+ * Stores a decoded transaction, which replaces any previous one.
+ */
+void CCounosTransactionDB::RecordDecodedTransaction(const uint256& txid, const CDecodedTransactionRecord& record)
+{
+    assert(pdb);
+
+    WriteRecord(DecodedTransactionKey(txid), record);
+
+    // a transaction may be confirmed again in another block, so the cached entry is replaced
+    LOCK(cs_decoded);
+    std::map<uint256, DecodedList::iterator>::iterator it = mapDecodedEntries.find(txid);
+    if (it != mapDecodedEntries.end()) {
+        decodedEntries.erase(it->second);
+        mapDecodedEntries.erase(it);
+    }
+}
+
+/**
+ * Retrieves a decoded transaction, from memory, if it was used recently.
+ *
+ * Transactions read from the database are kept in memory, unless fCache is
+ * false, for example when reading many transactions only once.
+ */
+bool CCounosTransactionDB::FetchDecodedTransaction(const uint256& txid, CDecodedTransactionRecord& record, bool fCache)
+{
+    assert(pdb);
+
+    {
+        LOCK(cs_decoded);
+        std::map<uint256, DecodedList::iterator>::iterator it = mapDecodedEntries.find(txid);
+        if (it != mapDecodedEntries.end()) {
+            decodedEntries.splice(decodedEntries.begin(), decodedEntries, it->second);
+            record = it->second->second;
+            return true;
+        }
+    }
+
+    std::string strValue;
+    leveldb::Status status = pdb->Get(readoptions, DecodedTransactionKey(txid), &strValue);
+    ++nRead;
+    if (!status.ok() || !DecodeBinaryDBRecord(strValue, record)) return false;
+    if (!fCache) return true;
+
+    LOCK(cs_decoded);
+    CacheDecodedTransaction(txid, record);
+
+    return true;
+}
+
+/**
+ * Removes a decoded transaction, which is no longer part of the chain.
+ */
+void CCounosTransactionDB::EraseDecodedTransaction(const uint256& txid)
+{
+    assert(pdb);
+
+    pdb->Delete(writeoptions, DecodedTransactionKey(txid));
+
+    LOCK(cs_decoded);
+    std::map<uint256, DecodedList::iterator>::iterator it = mapDecodedEntries.find(txid);
+    if (it != mapDecodedEntries.end()) {
+        decodedEntries.erase(it->second);
+        mapDecodedEntries.erase(it);
+    }
+}
+
+/**
+ * Sets the number of decoded transactions kept in memory.
+ */
+void CCounosTransactionDB::SetDecodedCacheSize(size_t nMaxSize)
+{
+    LOCK(cs_decoded);
+    nMaxDecodedEntries = nMaxSize;
+    while (decodedEntries.size() > nMaxDecodedEntries) {
+        mapDecodedEntries.erase(decodedEntries.back().first);
+        decodedEntries.pop_back();
+    }
+}
+
+/**
+ * Adds a decoded transaction to the front of the recently used entries, and
+ * evicts the least recently used entries, if the cache is full.
+ */
+void CCounosTransactionDB::CacheDecodedTransaction(const uint256& txid, const CDecodedTransactionRecord& record)
+{
+    AssertLockHeld(cs_decoded);
+
+    if (nMaxDecodedEntries == 0 || mapDecodedEntries.count(txid)) return;
+
+    decodedEntries.push_front(std::make_pair(txid, record));
+    mapDecodedEntries.emplace(txid, decodedEntries.begin());
+
+    while (decodedEntries.size() > nMaxDecodedEntries) {
+        mapDecodedEntries.erase(decodedEntries.back().first);
+        decodedEntries.pop_back();
+    }
+}
@@ -4,14 +4,69 @@
 #include <counoscore/dbbase.h>
 
 #include <fs.h>
+#include <serialize.h>
+#include <sync.h>
 #include <uint256.h>
 
 #include <stdint.h>
 
+#include <list>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
+//! Default number of decoded transactions kept in memory for RPC lookups
+static const size_t DEFAULT_DECODED_TX_CACHE_SIZE = 10000;
+
+/** A Counos transaction, as decoded when its block was connected.
+ *
+ * It holds everything needed to interpret the transaction again, without
+ * looking up the transaction or its inputs.
+ */
+class CDecodedTransactionRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    uint256 blockHash;
+    int32_t nBlock;
+    int64_t nBlockTime;
+    uint32_t nPosition;
+    int32_t nProcessingResult;
+    std::string sender;
+    std::string reference;
+    std::vector<unsigned char> payload;
+    int32_t nEncodingClass;
+    uint64_t nFee;
+    //! Outputs, which are valid Send To Many destinations
+    std::map<uint8_t, std::string> stmAddresses;
+
+    CDecodedTransactionRecord() : nBlock(0), nBlockTime(0), nPosition(0), nProcessingResult(0), nEncodingClass(0), nFee(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(blockHash);
+        READWRITE(nBlock);
+        READWRITE(nBlockTime);
+        READWRITE(nPosition);
+        READWRITE(nProcessingResult);
+        READWRITE(sender);
+        READWRITE(reference);
+        READWRITE(payload);
+        READWRITE(nEncodingClass);
+        READWRITE(nFee);
+        READWRITE(stmAddresses);
+    }
+};
+
 /** LevelDB based storage for storing Counos transaction validation and position in block data.
+ *
+ * Decoded transactions are stored in the binary record format only, and have
+ * no legacy text format, so they are decoded with DecodeBinaryDBRecord().
  */
 class CCounosTransactionDB : public CDBBase
 {
@@ -19,6 +74,9 @@ public:
     CCounosTransactionDB(const fs::path& path, bool fWipe);
     virtual ~CCounosTransactionDB();
 
+    /** Extends clearing of CDBBase. */
+    void Clear();
+
     /** Stores position in block and validation result for a transaction. */
     void RecordTransaction(const uint256& txid, uint32_t posInBlock, int processingResult);
 
@@ -28,7 +86,32 @@ public:
     /** Returns the reason why a transaction is invalid. */
     std::string FetchInvalidReason(const uint256& txid);
 
+    /** Stores a decoded transaction, which replaces any previous one. */
+    void RecordDecodedTransaction(const uint256& txid, const CDecodedTransactionRecord& record);
+
+    /** Retrieves a decoded transaction, from memory, if it was used recently. */
+    bool FetchDecodedTransaction(const uint256& txid, CDecodedTransactionRecord& record, bool fCache = true);
+
+    /** Removes a decoded transaction, which is no longer part of the chain. */
+    void EraseDecodedTransaction(const uint256& txid);
+
+    /** Sets the number of decoded transactions kept in memory. */
+    void SetDecodedCacheSize(size_t nMaxSize);
+
 private:
+    typedef std::list<std::pair<uint256, CDecodedTransactionRecord> > DecodedList;
+
+    Mutex cs_decoded;
+    //! Recently used decoded transactions, with the most recently used entry first
+    DecodedList decodedEntries;
+    //! Position of the decoded transactions in the list
+    std::map<uint256, DecodedList::iterator> mapDecodedEntries;
+    //! Maximum number of decoded transactions kept in memory
+    size_t nMaxDecodedEntries;
+
+    /** Adds a decoded transaction to the front of the recently used entries. */
+    void CacheDecodedTransaction(const uint256& txid, const CDecodedTransactionRecord& record);
+
     /** Retrieves the serialized transaction details from the DB. */
     std::vector<std::string> FetchTransactionDetails(const uint256& txid);
 };
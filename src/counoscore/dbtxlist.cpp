@@ -22,6 +22,7 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
+#include <leveldb/write_batch.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -43,10 +44,80 @@ using mastercore::GetBlockIndex;
 using mastercore::isNonMainNet;
 using mastercore::pDbTransaction;
 
+//! Prefix of the block height index entries
+static const char HEIGHT_INDEX_PREFIX = 'h';
+//! Version of the block height index, stored alongside the DB version
+static const int HEIGHT_INDEX_VERSION = 1;
+//! Key of the version of the block height index
+static const std::string HEIGHT_INDEX_VERSION_KEY = "txlistindexversion";
+
+/**
+ * Creates the key of a block height index entry.
+ *
+ * The height is stored in big-endian byte order, so entries are sorted by
+ * height and a block range can be retrieved with a single seek.
+ */
+static std::string HeightIndexKey(int nBlock, const std::string& txidStr)
+{
+    std::string key;
+    key.reserve(5 + txidStr.size());
+    key.push_back(HEIGHT_INDEX_PREFIX);
+    key.push_back(static_cast<char>((nBlock >> 24) & 0xff));
+    key.push_back(static_cast<char>((nBlock >> 16) & 0xff));
+    key.push_back(static_cast<char>((nBlock >> 8) & 0xff));
+    key.push_back(static_cast<char>(nBlock & 0xff));
+    key.append(txidStr);
+    return key;
+}
+
+/** Extracts the block height from a block height index key. */
+static int GetHeightIndexBlock(const leveldb::Slice& key)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(key.data());
+    return (static_cast<uint32_t>(p[1]) << 24) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 8) | static_cast<uint32_t>(p[4]);
+}
+
+/** Checks, whether the key is a block height index key. */
+static bool IsHeightIndexKey(const leveldb::Slice& key)
+{
+    return key.size() == 5 + 64 && key[0] == HEIGHT_INDEX_PREFIX;
+}
+
+const unsigned char CMPTxListRecord::VERSION;
+
+/**
+ * Parses a record in the legacy "valid:block:type:value" format.
+ */
+bool CMPTxListRecord::ParseLegacy(const std::string& value)
+{
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (4 != vstr.size()) return false; // unexpected number of tokens
+
+    try {
+        fValid = (atoi(vstr[0]) != 0);
+        nBlock = atoi(vstr[1]);
+        nType = atoi(vstr[2]);
+        nValue = boost::lexical_cast<uint64_t>(vstr[3]);
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string CMPTxListRecord::ToString() const
+{
+    return strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, nType, nValue);
+}
+
 CMPTxList::CMPTxList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
     PrintToConsole("Loading tx meta-info database: %s\n", status.ToString());
+
+    if (status.ok()) buildIndexes();
 }
 
 CMPTxList::~CMPTxList()
@@ -54,6 +125,49 @@ CMPTxList::~CMPTxList()
     if (msc_debug_persistence) PrintToLog("CMPTxList closed\n");
 }
 
+/**
+ * Adds the block height index entries of all master records, if the index is
+ * missing or outdated.
+ *
+ * The index is written as part of recording transactions, so this is only needed
+ * once for databases created before the index was introduced. The master records
+ * of transactions and DEx payments are keyed by txid, and the ones of MetaDEx
+ * cancels by txid and "-C", which are indexed by txid.
+ */
+void CMPTxList::buildIndexes()
+{
+    std::string strVersion;
+    leveldb::Status status = pdb->Get(readoptions, HEIGHT_INDEX_VERSION_KEY, &strVersion);
+    if (status.ok() && strVersion == strprintf("%d", HEIGHT_INDEX_VERSION)) return;
+
+    leveldb::WriteBatch batch;
+    unsigned int nIndexed = 0;
+    leveldb::Iterator* it = NewIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        const leveldb::Slice& skey = it->key();
+        bool fCancel = (skey.size() == 66 && skey[64] == '-' && skey[65] == 'C');
+        if (skey.size() != 64 && !fCancel) continue;
+
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue; // not a master record
+        batch.Put(HeightIndexKey(record.nBlock, std::string(skey.data(), 64)), "");
+        ++nIndexed;
+    }
+    delete it;
+
+    batch.Put(HEIGHT_INDEX_VERSION_KEY, strprintf("%d", HEIGHT_INDEX_VERSION));
+    status = pdb->Write(syncoptions, &batch);
+
+    if (nIndexed > 0) PrintToConsole("Indexing tx meta-info database: %d transactions indexed\n", nIndexed);
+    PrintToLog("%s(): indexed %d transactions: %s\n", __func__, nIndexed, status.ToString());
+}
+
+void CMPTxList::Clear()
+{
+    CDBBase::Clear();
+    pdb->Put(writeoptions, HEIGHT_INDEX_VERSION_KEY, strprintf("%d", HEIGHT_INDEX_VERSION));
+}
+
 void CMPTxList::recordTX(const uint256 &txid, bool fValid, int nBlock, unsigned int type, uint64_t nValue)
 {
     if (!pdb) return;
@@ -63,14 +177,16 @@ void CMPTxList::recordTX(const uint256 &txid, bool fValid, int nBlock, unsigned
     if (exists(txid)) PrintToLog("LEVELDB TX OVERWRITE DETECTION - %s\n", txid.ToString());
 
     const std::string key = txid.ToString();
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, nValue);
+    const CMPTxListRecord record(fValid, nBlock, type, nValue);
     leveldb::Status status;
 
     PrintToLog("%s(%s, valid=%s, block= %d, type= %d, value= %lu)\n",
             __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, nValue);
 
-    status = pdb->Put(writeoptions, key, value);
-    ++nWritten;
+    leveldb::WriteBatch batch;
+    WriteRecord(batch, key, record);
+    batch.Put(HeightIndexKey(nBlock, key), "");
+    status = pdb->Write(writeoptions, &batch);
 }
 
 void CMPTxList::recordPaymentTX(const uint256& txid, bool fValid, int nBlock, unsigned int vout, unsigned int propertyId, uint64_t nValue, std::string buyer, std::string seller)
@@ -90,28 +206,22 @@ void CMPTxList::recordPaymentTX(const uint256& txid, bool fValid, int nBlock, un
     // Step 2b - If does exist add +1 to existing number of payments and set this paymentNumber as new numberOfPayments
     if (paymentEntryExists) {
         //retrieve old numberOfPayments
-        std::vector<std::string> vstr;
-        std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
-        if (status.ok()) {
-            // parse the string returned
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-
+        CMPTxListRecord existing;
+        if (ReadRecord(txid.ToString(), existing)) {
             // obtain the existing number of payments
-            if (4 <= vstr.size()) {
-                existingNumberOfPayments = atoi(vstr[3]);
-                paymentNumber = existingNumberOfPayments + 1;
-                numberOfPayments = existingNumberOfPayments + 1;
-            }
+            existingNumberOfPayments = existing.nValue;
+            paymentNumber = existingNumberOfPayments + 1;
+            numberOfPayments = existingNumberOfPayments + 1;
         }
     }
 
     // Step 3 - Create new/update master record for payment tx in TXList
     const std::string key = txid.ToString();
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, numberOfPayments);
+    const CMPTxListRecord record(fValid, nBlock, type, numberOfPayments);
     leveldb::Status status;
     PrintToLog("DEXPAYDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of payments= %lu)\n", __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, numberOfPayments);
-    status = pdb->Put(writeoptions, key, value);
+    status = WriteRecord(key, record);
+    status = pdb->Put(writeoptions, HeightIndexKey(nBlock, key), "");
 
     // Step 4 - Write sub-record with payment details
     const std::string txidStr = txid.ToString();
@@ -135,25 +245,19 @@ void CMPTxList::recordMetaDExCancelTX(const uint256& txidMaster, const uint256&
     // Step 1 - Check TXList to see if this cancel TXID exists
     // Step 2a - If doesn't exist leave number of affected txs & ref set to 1
     // Step 2b - If does exist add +1 to existing ref and set this ref as new number of affected
-    std::vector<std::string> vstr;
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txidMasterStr, &strValue);
-    if (status.ok()) {
-        // parse the string returned
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-
+    CMPTxListRecord existing;
+    if (ReadRecord(txidMasterStr, existing)) {
         // obtain the existing affected tx count
-        if (4 <= vstr.size()) {
-            existingAffectedTXCount = atoi(vstr[3]);
-            refNumber = existingAffectedTXCount + 1;
-        }
+        existingAffectedTXCount = existing.nValue;
+        refNumber = existingAffectedTXCount + 1;
     }
 
     // Step 3 - Create new/update master record for cancel tx in TXList
     const std::string key = txidMasterStr;
-    const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, refNumber);
+    const CMPTxListRecord record(fValid, nBlock, type, refNumber);
     PrintToLog("METADEXCANCELDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of affected transactions= %d)\n", __func__, txidMaster.ToString(), fValid ? "YES" : "NO", nBlock, type, refNumber);
-    status = pdb->Put(writeoptions, key, value);
+    leveldb::Status status = WriteRecord(key, record);
+    status = pdb->Put(writeoptions, HeightIndexKey(nBlock, txidMaster.ToString()), "");
 
     // Step 4 - Write sub-record with cancel details
     const std::string txidStr = txidMaster.ToString() + "-C";
@@ -224,14 +328,9 @@ int CMPTxList::getNumberOfSubRecords(const uint256& txid)
 {
     int numberOfSubRecords = 0;
 
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
-    if (status.ok()) {
-        std::vector<std::string> vstr;
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 <= vstr.size()) {
-            numberOfSubRecords = boost::lexical_cast<int>(vstr[3]);
-        }
+    CMPTxListRecord record;
+    if (ReadRecord(txid.ToString(), record)) {
+        numberOfSubRecords = static_cast<int>(record.nValue);
     }
 
     return numberOfSubRecords;
@@ -241,16 +340,10 @@ int CMPTxList::getNumberOfMetaDExCancels(const uint256 txid)
 {
     if (!pdb) return 0;
     int numberOfCancels = 0;
-    std::vector<std::string> vstr;
-    std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString() + "-C", &strValue);
-    if (status.ok()) {
-        // parse the string returned
-        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
+    CMPTxListRecord record;
+    if (ReadRecord(txid.ToString() + "-C", record)) {
         // obtain the number of cancels
-        if (4 <= vstr.size()) {
-            numberOfCancels = atoi(vstr[3]);
-        }
+        numberOfCancels = static_cast<int>(record.nValue);
     }
     return numberOfCancels;
 }
@@ -320,14 +413,10 @@ int CMPTxList::getMPTransactionCountBlock(int block)
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
         skey = it->key();
         svalue = it->value();
-        if (skey.ToString().length() == 64) {
-            std::string strValue = svalue.ToString();
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vstr.size()) {
-                if (atoi(vstr[1]) == block) {
-                    ++count;
-                }
+        if (skey.size() == 64) {
+            CMPTxListRecord record;
+            if (DecodeDBRecord(svalue, record) && record.nBlock == block) {
+                ++count;
             }
         }
     }
@@ -340,22 +429,14 @@ int CMPTxList::GetCounosTxsInBlockRange(int blockFirst, int blockLast, std::set<
 {
     int count = 0;
     leveldb::Iterator* it = NewIterator();
-    
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+
+    for (it->Seek(HeightIndexKey(std::max(blockFirst, 0), "")); it->Valid(); it->Next()) {
         const leveldb::Slice& sKey = it->key();
-        const leveldb::Slice& sValue = it->value();
-
-        if (sKey.ToString().length() == 64) {
-            const std::string& strValue = sValue.ToString();
-            std::vector<std::string> vStr;
-            boost::split(vStr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vStr.size()) {
-                int blockCurrent = atoi(vStr[1]);
-                if (blockCurrent >= blockFirst && blockCurrent <= blockLast) {
-                    retTxs.insert(uint256S(sKey.ToString()));                    
-                    ++count;
-                }
-            }
+        if (!IsHeightIndexKey(sKey) || GetHeightIndexBlock(sKey) > blockLast) break;
+
+        // entries of payments and cancels share the txid, so only count new ones
+        if (retTxs.insert(uint256S(std::string(sKey.data() + 5, sKey.size() - 5))).second) {
+            ++count;
         }
     }
 
@@ -438,16 +519,9 @@ bool CMPTxList::exists(const uint256 &txid)
     return true;
 }
 
-bool CMPTxList::getTX(const uint256 &txid, std::string& value)
+bool CMPTxList::getTX(const uint256 &txid, CMPTxListRecord& record)
 {
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &value);
-    ++nRead;
-
-    if (status.ok()) {
-        return true;
-    }
-
-    return false;
+    return ReadRecord(txid.ToString(), record);
 }
 
 // call it like so (variable # of parameters):
@@ -459,43 +533,23 @@ bool CMPTxList::getTX(const uint256 &txid, std::string& value)
 //
 bool CMPTxList::getValidMPTX(const uint256& txid, int* block, unsigned int* type, uint64_t* nAmended)
 {
-    std::string result;
-    int validity = 0;
+    CMPTxListRecord record;
 
     if (msc_debug_txdb) PrintToLog("%s()\n", __func__);
 
     if (!pdb) return false;
 
-    if (!getTX(txid, result)) return false;
+    if (!getTX(txid, record)) return false;
 
-    // parse the string returned, find the validity flag/bit & other parameters
-    std::vector<std::string> vstr;
-    boost::split(vstr, result, boost::is_any_of(":"), boost::token_compress_on);
+    if (msc_debug_txdb) PrintToLog("%s() : %s\n", __func__, record.ToString());
 
-    if (msc_debug_txdb) PrintToLog("%s() size=%lu : %s\n", __func__, vstr.size(), result);
-
-    if (1 <= vstr.size()) validity = atoi(vstr[0]);
-
-    if (block) {
-        if (2 <= vstr.size()) *block = atoi(vstr[1]);
-        else *block = 0;
-    }
-
-    if (type) {
-        if (3 <= vstr.size()) *type = atoi(vstr[2]);
-        else *type = 0;
-    }
-
-    if (nAmended) {
-        if (4 <= vstr.size()) *nAmended = boost::lexical_cast<boost::uint64_t>(vstr[3]);
-        else nAmended = 0;
-    }
+    if (block) *block = record.nBlock;
+    if (type) *type = record.nType;
+    if (nAmended) *nAmended = record.nValue;
 
     if (msc_debug_txdb) printStats();
 
-    if ((int) 0 == validity) return false;
-
-    return true;
+    return record.fValid;
 }
 
 std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
@@ -507,13 +561,10 @@ std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
     leveldb::Iterator* it = NewIterator();
 
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        int block = atoi(vstr[1]);
-        if (block >= startHeight && block <= endHeight) {
-            setSeedBlocks.insert(block);
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue; // not a master record
+        if (record.nBlock >= startHeight && record.nBlock <= endHeight) {
+            setSeedBlocks.insert(record.nBlock);
         }
     }
 
@@ -531,13 +582,11 @@ void CMPTxList::LoadAlerts(int blockHeight)
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != COUNOSCORE_MESSAGE_TYPE_ALERT || atoi(vstr[0]) != 1) continue; // not a valid alert
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue; // not a master record
+        if (record.nType != COUNOSCORE_MESSAGE_TYPE_ALERT || !record.fValid) continue; // not a valid alert
         uint256 txid = uint256S(it->key().ToString());
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
+        loadOrder.push_back(std::make_pair(record.nBlock, txid));
     }
 
     std::sort(loadOrder.begin(), loadOrder.end());
@@ -607,13 +656,11 @@ void CMPTxList::LoadActivations(int blockHeight)
     std::vector<std::pair<int64_t, uint256> > loadOrder;
 
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        if (atoi(vstr[2]) != COUNOSCORE_MESSAGE_TYPE_ACTIVATION || atoi(vstr[0]) != 1) continue; // we only care about valid activations
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue; // not a master record
+        if (record.nType != COUNOSCORE_MESSAGE_TYPE_ACTIVATION || !record.fValid) continue; // we only care about valid activations
         uint256 txid = uint256S(it->key().ToString());
-        loadOrder.push_back(std::make_pair(atoi(vstr[1]), txid));
+        loadOrder.push_back(std::make_pair(record.nBlock, txid));
     }
 
     std::sort(loadOrder.begin(), loadOrder.end());
@@ -680,17 +727,15 @@ bool CMPTxList::LoadFreezeState(int blockHeight)
     PrintToLog("Loading freeze state from levelDB\n");
 
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue;
-        uint16_t txtype = atoi(vstr[2]);
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue;
+        uint16_t txtype = record.nType;
         if (txtype != MSC_TYPE_FREEZE_PROPERTY_TOKENS && txtype != MSC_TYPE_UNFREEZE_PROPERTY_TOKENS &&
                 txtype != MSC_TYPE_ENABLE_FREEZING && txtype != MSC_TYPE_DISABLE_FREEZING) continue;
-        if (atoi(vstr[0]) != 1) continue; // invalid, ignore
+        if (!record.fValid) continue; // invalid, ignore
         uint256 txid = uint256S(it->key().ToString());
         int txPosition = pDbTransaction->FetchTransactionPosition(txid);
-        std::string sortKey = strprintf("%06d%010d", atoi(vstr[1]), txPosition);
+        std::string sortKey = strprintf("%06d%010d", record.nBlock, txPosition);
         loadOrder.push_back(std::make_pair(sortKey, txid));
     }
 
@@ -756,13 +801,10 @@ bool CMPTxList::CheckForFreezeTxs(int blockHeight)
     leveldb::Iterator* it = NewIterator();
 
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block < blockHeight) continue;
-        uint16_t txtype = atoi(vstr[2]);
+        CMPTxListRecord record;
+        if (!DecodeDBRecord(it->value(), record)) continue;
+        if (record.nBlock < blockHeight) continue;
+        uint16_t txtype = record.nType;
         if (txtype == MSC_TYPE_FREEZE_PROPERTY_TOKENS || txtype == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS ||
                 txtype == MSC_TYPE_ENABLE_FREEZING || txtype == MSC_TYPE_DISABLE_FREEZING) {
             delete it;
@@ -789,7 +831,12 @@ void CMPTxList::printAll()
         skey = it->key();
         svalue = it->value();
         ++count;
-        PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        CMPTxListRecord record;
+        if (DecodeDBRecord(svalue, record)) {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), record.ToString());
+        } else {
+            PrintToConsole("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
+        }
     }
 
     delete it;
@@ -797,43 +844,40 @@ void CMPTxList::printAll()
 
 // figure out if there was at least 1 Master Protocol transaction within the block range, or a block if starting equals ending
 // block numbers are inclusive
-// pass in bDeleteFound = true to erase each entry found within the block range
+// pass in bDeleteFound = true to erase each entry found within the block range, including all sub records
 bool CMPTxList::isMPinBlockRange(int starting_block, int ending_block, bool bDeleteFound)
 {
-    leveldb::Slice skey, svalue;
-    unsigned int count = 0;
-    std::vector<std::string> vstr;
-    int block;
     unsigned int n_found = 0;
+    leveldb::WriteBatch batch;
 
     leveldb::Iterator* it = NewIterator();
+    leveldb::Iterator* itRecord = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
+    for (it->Seek(HeightIndexKey(std::max(starting_block, 0), "")); it->Valid(); it->Next()) {
+        const leveldb::Slice& skey = it->key();
+        if (!IsHeightIndexKey(skey) || GetHeightIndexBlock(skey) > ending_block) break;
 
-        ++count;
-
-        std::string strvalue = it->value().ToString();
+        ++n_found;
+        if (!bDeleteFound) break;
 
-        // parse the string returned, find the validity flag/bit & other parameters
-        boost::split(vstr, strvalue, boost::is_any_of(":"), boost::token_compress_on);
+        // the master record, and all sub records, are prefixed with the txid
+        const leveldb::Slice txidPrefix(skey.data() + 5, skey.size() - 5);
+        for (itRecord->Seek(txidPrefix); itRecord->Valid() && itRecord->key().starts_with(txidPrefix); itRecord->Next()) {
+            PrintToLog("%s() DELETING: %s=%s\n", __func__, itRecord->key().ToString(), itRecord->value().ToString());
+            batch.Delete(itRecord->key());
+        }
+        batch.Delete(skey);
+    }
 
-        // only care about the block number/height here
-        if (2 <= vstr.size()) {
-            block = atoi(vstr[1]);
+    delete itRecord;
+    delete it;
 
-            if ((starting_block <= block) && (block <= ending_block)) {
-                ++n_found;
-                PrintToLog("%s() DELETING: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
-                if (bDeleteFound) pdb->Delete(writeoptions, skey);
-            }
-        }
+    if (bDeleteFound && n_found > 0) {
+        leveldb::Status status = pdb->Write(writeoptions, &batch);
+        if (!status.ok()) PrintToLog("%s(): failed to delete records: %s\n", __func__, status.ToString());
     }
 
     PrintToLog("%s(%d, %d); n_found= %d\n", __func__, starting_block, ending_block, n_found);
 
-    delete it;
-
     return (n_found);
 }
@@ -5,6 +5,7 @@
 #include <counoscore/nftdb.h>
 
 #include <fs.h>
+#include <serialize.h>
 #include <uint256.h>
 
 #include <stdint.h>
@@ -12,10 +13,51 @@
 #include <set>
 #include <string>
 
+/** Master record of a transaction in the transaction list.
+ *
+ * It's also used for the master records of DEx payments and MetaDEx cancels, which
+ * store the number of sub records as value.
+ */
+class CMPTxListRecord
+{
+public:
+    //! Version byte of the serialized record
+    static const unsigned char VERSION = 0x01;
+
+    bool fValid;
+    int32_t nBlock;
+    uint32_t nType;
+    uint64_t nValue;
+
+    CMPTxListRecord() : fValid(false), nBlock(0), nType(0), nValue(0) {}
+
+    CMPTxListRecord(bool fValidIn, int32_t nBlockIn, uint32_t nTypeIn, uint64_t nValueIn)
+      : fValid(fValidIn), nBlock(nBlockIn), nType(nTypeIn), nValue(nValueIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(fValid);
+        READWRITE(nBlock);
+        READWRITE(nType);
+        READWRITE(nValue);
+    }
+
+    /** Parses a record in the legacy "valid:block:type:value" format. */
+    bool ParseLegacy(const std::string& value);
+
+    std::string ToString() const;
+};
+
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
  */
 class CMPTxList : public CDBBase
 {
+private:
+    /** Adds the block height index entries of all master records, if the index is missing. */
+    void buildIndexes();
+
 public:
     CMPTxList(const fs::path& path, bool fWipe);
     virtual ~CMPTxList();
@@ -47,8 +89,11 @@ public:
     int getDBVersion();
     int setDBVersion();
 
+    /** Deletes all entries of the database, and marks the index of the now empty database as complete. */
+    void Clear();
+
     bool exists(const uint256& txid);
-    bool getTX(const uint256& txid, std::string& value);
+    bool getTX(const uint256& txid, CMPTxListRecord& record);
     bool getValidMPTX(const uint256& txid, int* block = nullptr, unsigned int* type = nullptr, uint64_t* nAmended = nullptr);
 
     std::set<int> GetSeedBlocks(int startHeight, int endHeight);
@@ -6,6 +6,7 @@
 
 #include <counoscore/dex.h>
 
+#include <counoscore/consensushash.h>
 #include <counoscore/convert.h>
 #include <counoscore/dbtxlist.h>
 #include <counoscore/log.h>
@@ -252,6 +253,7 @@ int DEx_offerCreate(const std::string& addressSeller, uint32_t propertyId, int64
 
         CMPOffer sellOffer(block, amountOffered, propertyId, amountDesired, minAcceptFee, paymentWindow, txid);
         my_offers.insert(std::make_pair(key, sellOffer));
+        UpdateStateHash(sellOffer, addressSeller, true);
 
         rc = 0;
     }
@@ -283,6 +285,7 @@ int DEx_offerDestroy(const std::string& addressSeller, uint32_t propertyId)
     // delete the offer
     const std::string key = STR_SELLOFFER_ADDR_PROP_COMBO(addressSeller, propertyId);
     OfferMap::iterator it = my_offers.find(key);
+    UpdateStateHash(it->second, addressSeller, false);
     my_offers.erase(it);
 
     if (msc_debug_dex) PrintToLog("%s(%s|%s)\n", __func__, addressSeller, key);
@@ -368,6 +371,7 @@ int DEx_acceptCreate(const std::string& addressBuyer, const std::string& address
 
         CMPAccept acceptOffer(amountReserved, block, offer.getBlockTimeLimit(), offer.getProperty(), offer.getOfferAmountOriginal(), offer.getCCHDesiredOriginal(), offer.getHash());
         my_accepts.insert(std::make_pair(keyAcceptOrder, acceptOffer));
+        UpdateStateHash(acceptOffer, addressBuyer, true);
 
         rc = 0;
     }
@@ -431,6 +435,7 @@ int DEx_acceptDestroy(const std::string& addressBuyer, const std::string& addres
         AcceptMap::iterator it = my_accepts.find(key);
 
         if (my_accepts.end() != it) {
+            UpdateStateHash(it->second, addressBuyer, false);
             my_accepts.erase(it);
         }
     }
@@ -595,7 +600,11 @@ int DEx_payment(const uint256& txid, unsigned int vout, const std::string& addre
     }
 
     // reduce the amount of units still desired by the buyer and if 0 destroy the Accept order
-    if (p_accept->reduceAcceptAmountRemaining_andIsZero(amountPurchased)) {
+    UpdateStateHash(*p_accept, addressBuyer, false);
+    bool fAcceptFilled = p_accept->reduceAcceptAmountRemaining_andIsZero(amountPurchased);
+    UpdateStateHash(*p_accept, addressBuyer, true);
+
+    if (fAcceptFilled) {
         const int64_t reserveSell = GetTokenBalance(addressSeller, propertyId, SELLOFFER_RESERVE);
         const int64_t reserveAccept = GetTokenBalance(addressSeller, propertyId, ACCEPT_RESERVE);
 
@@ -635,6 +644,7 @@ unsigned int eraseExpiredAccepts(int blockNow)
 
             DEx_acceptDestroy(addressBuyer, addressSeller, propertyId);
 
+            UpdateStateHash(acceptOrder, addressBuyer, false);
             my_accepts.erase(it++);
 
             ++how_many_erased;
@@ -7,6 +7,7 @@
 
 #include <amount.h>
 #include <hash.h>
+#include <serialize.h>
 #include <tinyformat.h>
 #include <uint256.h>
 
@@ -56,6 +57,7 @@ private:
 
 public:
     uint256 getHash() const { return txid; }
+    int getOfferBlock() const { return offerBlock; }
     uint32_t getProperty() const { return property; }
     int64_t getMinFee() const { return min_fee ; }
     uint8_t getBlockTimeLimit() const { return blocktimelimit; }
@@ -86,7 +88,7 @@ public:
     {
     }
 
-    void saveOffer(std::ofstream& file, const std::string& address, CHash256& hasher) const
+    void saveOffer(std::ostream& file, const std::string& address, CHash256& hasher) const
     {
         std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s",
                 address,
@@ -106,6 +108,20 @@ public:
         // write the line
         file << lineOut << std::endl;
     }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(offerBlock);
+        READWRITE(offer_amount_original);
+        READWRITE(property);
+        READWRITE(CCH_desired_original);
+        READWRITE(min_fee);
+        READWRITE(blocktimelimit);
+        READWRITE(txid);
+        READWRITE(subaction);
+    }
 };
 
 /** Accepted offer on the DEx.
@@ -142,6 +158,12 @@ public:
 
     int getAcceptBlock() const { return block; }
 
+    CMPAccept()
+      : accept_amount_original(0), accept_amount_remaining(0), blocktimelimit(0), property(0),
+        offer_amount_original(0), CCH_desired_original(0), block(0)
+    {
+    }
+
     CMPAccept(int64_t amountAccepted, int blockIn, uint8_t paymentWindow, uint32_t propertyId,
               int64_t offerAmountOriginal, int64_t amountDesired, const uint256& txid)
       : accept_amount_remaining(amountAccepted), blocktimelimit(paymentWindow),
@@ -194,7 +216,7 @@ public:
         return bRet;
     }
 
-    void saveAccept(std::ofstream& file, const std::string& address, const std::string& buyer, CHash256& hasher) const
+    void saveAccept(std::ostream& file, const std::string& address, const std::string& buyer, CHash256& hasher) const
     {
         std::string lineOut = strprintf("%s,%d,%s,%d,%d,%d,%d,%d,%d,%s",
                 address,
@@ -214,6 +236,20 @@ public:
         // write the line
         file << lineOut << std::endl;
     }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(accept_amount_original);
+        READWRITE(accept_amount_remaining);
+        READWRITE(blocktimelimit);
+        READWRITE(property);
+        READWRITE(offer_amount_original);
+        READWRITE(CCH_desired_original);
+        READWRITE(offer_txid);
+        READWRITE(block);
+    }
 };
 
 namespace mastercore
@@ -66,6 +66,8 @@ bool msc_debug_consensus_hash_every_transaction = 0;
 bool msc_debug_fees               = 1;
 //! Debug the non-fungible tokens database
 bool msc_debug_nftdb              = 0;
+//! Verify the incremental state hash against a full recalculation for each block
+bool msc_debug_state_hash         = 0;
 
 /**
  * LogPrintf() has been broken a couple of times now
@@ -267,6 +269,7 @@ void InitDebugLogLevels()
         if (*it == "consensus_hash_every_transaction") msc_debug_consensus_hash_every_transaction = true;
         if (*it == "fees") msc_debug_fees = true;
         if (*it == "nftdb") msc_debug_nftdb = true;
+        if (*it == "state_hash") msc_debug_state_hash = true;
         if (*it == "none" || *it == "all") {
             bool allDebugState = false;
             if (*it == "all") allDebugState = true;
@@ -304,6 +307,7 @@ void InitDebugLogLevels()
             msc_debug_consensus_hash_every_transaction = allDebugState;
             msc_debug_fees = allDebugState;
             msc_debug_nftdb = allDebugState;
+            msc_debug_state_hash = allDebugState;
         }
     }
 }
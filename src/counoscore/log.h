@@ -53,6 +53,7 @@ extern bool msc_debug_alerts;
 extern bool msc_debug_consensus_hash_every_transaction;
 extern bool msc_debug_fees;
 extern bool msc_debug_nftdb;
+extern bool msc_debug_state_hash;
 
 /* When we switch to C++11, this can be switched to variadic templates instead
  * of this macro-based construction (see tinyformat.h).
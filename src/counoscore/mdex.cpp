@@ -1,5 +1,6 @@
 #include <counoscore/mdex.h>
 
+#include <counoscore/consensushash.h>
 #include <counoscore/dbfees.h>
 #include <counoscore/dbtradelist.h>
 #include <counoscore/dbtxlist.h>
@@ -13,6 +14,7 @@
 #include <hash.h>
 #include <validation.h>
 #include <tinyformat.h>
+#include <ui_interface.h>
 #include <uint256.h>
 
 #include <univalue.h>
@@ -23,11 +25,13 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 typedef boost::multiprecision::cpp_dec_float_100 dec_float;
 typedef boost::multiprecision::checked_int128_t int128_t;
@@ -40,16 +44,72 @@ using namespace mastercore;
 //! Global map for price and order data
 md_PropertiesMap mastercore::metadex;
 
-md_PricesMap* mastercore::get_Prices(uint32_t prop)
+/** Position of an open order in the MetaDEx maps. */
+struct MetaDEx_OrderRef
 {
-    md_PropertiesMap::iterator it = metadex.find(prop);
+    md_PropertyPair pair;
+    price_t price;
+    int block;
+    unsigned int idx;
+};
+
+//! Index of the open orders by transaction hash
+static std::map<uint256, MetaDEx_OrderRef> metadex_txids;
+
+md_PricesMap* mastercore::get_Prices(uint32_t prop, uint32_t desprop)
+{
+    md_PropertiesMap::iterator it = metadex.find(md_PropertyPair(prop, desprop));
 
     if (it != metadex.end()) return &(it->second);
 
     return static_cast<md_PricesMap*>(nullptr);
 }
 
-md_Set* mastercore::get_Indexes(md_PricesMap* p, rational_t price)
+//! Checks, whether there ever was an order book for the property for sale
+static bool MetaDEx_hasPrices(uint32_t prop)
+{
+    md_PropertiesMap::const_iterator it = metadex.lower_bound(md_PropertyPair(prop, 0));
+
+    return (it != metadex.end() && it->first.first == prop);
+}
+
+//! Adds an order, which was inserted into the MetaDEx maps, to the txid index
+static void MetaDEx_indexOrder(const CMPMetaDEx& obj)
+{
+    MetaDEx_OrderRef& ref = metadex_txids[obj.getHash()];
+    ref.pair = md_PropertyPair(obj.getProperty(), obj.getDesProperty());
+    ref.price = obj.unitPrice();
+    ref.block = obj.getBlock();
+    ref.idx = obj.getIdx();
+}
+
+//! Removes an order, which is about to be erased from the MetaDEx maps, from the txid index
+static void MetaDEx_unindexOrder(const CMPMetaDEx& obj)
+{
+    metadex_txids.erase(obj.getHash());
+}
+
+//! Locates an open order via the txid index
+static const CMPMetaDEx* MetaDEx_findOrder(const uint256& txid)
+{
+    std::map<uint256, MetaDEx_OrderRef>::const_iterator it = metadex_txids.find(txid);
+    if (it == metadex_txids.end()) return nullptr;
+
+    const MetaDEx_OrderRef& ref = it->second;
+    md_PricesMap* prices = get_Prices(ref.pair.first, ref.pair.second);
+    if (!prices) return nullptr;
+    md_Set* indexes = get_Indexes(prices, ref.price);
+    if (!indexes) return nullptr;
+
+    // orders are sorted by block and position, which is all the lookup needs
+    const CMPMetaDEx key("", ref.block, 0, 0, 0, 0, txid, ref.idx, 0);
+    md_Set::const_iterator itOrder = indexes->find(key);
+    if (itOrder == indexes->end() || itOrder->getHash() != txid) return nullptr;
+
+    return &(*itOrder);
+}
+
+md_Set* mastercore::get_Indexes(md_PricesMap* p, const price_t& price)
 {
     md_PricesMap::iterator it = p->find(price);
 
@@ -126,6 +186,11 @@ std::string xToString(const rational_t& value)
     }
 }
 
+std::string xToString(const price_t& value)
+{
+    return xToString(value.toRational());
+}
+
 // find the best match on the market
 // NOTE: sometimes I refer to the older order as seller & the newer order as buyer, in this trade
 // INPUT: property, desprop, desprice = of the new order being inserted; the new object being processed
@@ -140,7 +205,8 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
     if (msc_debug_metadex1) PrintToLog("%s(%s: prop=%d, desprop=%d, desprice= %s);newo: %s\n",
         __FUNCTION__, pnew->getAddr(), propertyForSale, propertyDesired, xToString(pnew->inversePrice()), pnew->ToString());
 
-    md_PricesMap* const ppriceMap = get_Prices(propertyDesired);
+    // the order book of the inverse pair holds all offers, which may match
+    md_PricesMap* const ppriceMap = get_Prices(propertyDesired, propertyForSale);
 
     // nothing for the desired property exists in the market, sorry!
     if (!ppriceMap) {
@@ -148,35 +214,31 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
         return NewReturn;
     }
 
-    // within the desired property map (given one property) iterate over the items looking at prices
-    for (md_PricesMap::iterator priceIt = ppriceMap->begin(); priceIt != ppriceMap->end(); ++priceIt) { // check all prices
-        const rational_t sellersPrice = priceIt->first;
+    // within the order book of the pair iterate over the items looking at prices, starting with the best
+    md_PricesMap::iterator priceIt = ppriceMap->begin();
+    while (priceIt != ppriceMap->end()) { // check all prices
+        const price_t& sellersPrice = priceIt->first;
 
         if (msc_debug_metadex2) PrintToLog("comparing prices: desprice %s needs to be GREATER THAN OR EQUAL TO %s\n",
             xToString(pnew->inversePrice()), xToString(sellersPrice));
 
         // Is the desired price check satisfied? The buyer's inverse price must be larger than that of the seller.
+        // Prices are sorted in ascending order, so none of the remaining price levels can match either.
         if (pnew->inversePrice() < sellersPrice) {
-            continue;
+            break;
         }
 
         md_Set* const pofferSet = &(priceIt->second);
 
-        // at good (single) price level and property iterate over offers looking at all parameters to find the match
+        // at good (single) price level and property pair iterate over offers looking at all parameters to find the match
         md_Set::iterator offerIt = pofferSet->begin();
-        while (offerIt != pofferSet->end()) { // specific price, check all properties
+        while (offerIt != pofferSet->end()) { // specific price, check all offers
             const CMPMetaDEx* const pold = &(*offerIt);
             assert(pold->unitPrice() == sellersPrice);
 
             if (msc_debug_metadex1) PrintToLog("Looking at existing: %s (its prop= %d, its des prop= %d) = %s\n",
                 xToString(sellersPrice), pold->getProperty(), pold->getDesProperty(), pold->ToString());
 
-            // does the desired property match?
-            if (pold->getDesProperty() != propertyForSale) {
-                ++offerIt;
-                continue;
-            }
-
             if (msc_debug_metadex1) PrintToLog("MATCH FOUND, Trade: %s = %s\n", xToString(sellersPrice), pold->ToString());
 
             // match found, execute trade now!
@@ -230,7 +292,7 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             // If the resulting adjusted unit price is higher than Alice' price, the
             // orders shall not execute, and no representable fill is made
-            const rational_t xEffectivePrice(nWouldPay, nCouldBuy);
+            const price_t xEffectivePrice(nWouldPay, nCouldBuy);
 
             if (xEffectivePrice > pnew->inversePrice()) {
                 if (msc_debug_metadex1) PrintToLog(
@@ -309,23 +371,37 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             // record the trade in MPTradeList
             pDbTradeList->recordMatchedTrade(pold->getHash(), pnew->getHash(), // < might just pass pold, pnew
-                pold->getAddr(), pnew->getAddr(), pold->getDesProperty(), pnew->getDesProperty(), seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock(), tradingFee);
+                pold->getAddr(), pnew->getAddr(), pold->getDesProperty(), pnew->getDesProperty(), seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock(), pnew->getIdx(), tradingFee);
+
+            uiInterface.CounosTradeMatched(pnew->getHash(), pold->getHash(), pnew->getProperty(), pnew->getDesProperty(),
+                seller_amountGot, buyer_amountGotAfterFee, pnew->getBlock());
 
             if (msc_debug_metadex1) PrintToLog("++ erased old: %s\n", offerIt->ToString());
             // erase the old seller element
+            UpdateStateHash(*offerIt, false);
+            MetaDEx_unindexOrder(*offerIt);
             pofferSet->erase(offerIt++);
 
             // insert the updated one in place of the old
             if (0 < seller_replacement.getAmountRemaining()) {
                 PrintToLog("++ inserting seller_replacement: %s\n", seller_replacement.ToString());
                 pofferSet->insert(seller_replacement);
+                MetaDEx_indexOrder(seller_replacement);
+                UpdateStateHash(seller_replacement, true);
             }
 
             if (bBuyerSatisfied) {
                 assert(buyer_amountLeft == 0);
                 break;
             }
-        } // specific price, check all properties
+        } // specific price, check all offers
+
+        // drop price levels without offers, so they are not visited again
+        if (pofferSet->empty()) {
+            ppriceMap->erase(priceIt++);
+        } else {
+            ++priceIt;
+        }
 
         if (bBuyerSatisfied) break;
     } // check all prices
@@ -344,10 +420,10 @@ std::string CMPMetaDEx::displayUnitPrice() const
 {
      rational_t tmpDisplayPrice;
      if (getDesProperty() == COUNOS_PROPERTY_MSC || getDesProperty() == COUNOS_PROPERTY_TMSC) {
-         tmpDisplayPrice = unitPrice();
+         tmpDisplayPrice = unitPrice().toRational();
          if (isPropertyDivisible(getProperty())) tmpDisplayPrice = tmpDisplayPrice * COIN;
      } else {
-         tmpDisplayPrice = inversePrice();
+         tmpDisplayPrice = inversePrice().toRational();
          if (isPropertyDivisible(getDesProperty())) tmpDisplayPrice = tmpDisplayPrice * COIN;
      }
 
@@ -369,7 +445,7 @@ std::string CMPMetaDEx::displayUnitPrice() const
  */
 std::string CMPMetaDEx::displayFullUnitPrice() const
 {
-    rational_t tempUnitPrice = unitPrice();
+    rational_t tempUnitPrice = unitPrice().toRational();
 
     /* Matching types require no action (divisible/divisible or indivisible/indivisible)
        Non-matching types require adjustment for display purposes
@@ -383,17 +459,17 @@ std::string CMPMetaDEx::displayFullUnitPrice() const
     return unitPriceStr;
 }
 
-rational_t CMPMetaDEx::unitPrice() const
+price_t CMPMetaDEx::unitPrice() const
 {
-    rational_t effectivePrice;
-    if (amount_forsale) effectivePrice = rational_t(amount_desired, amount_forsale);
+    price_t effectivePrice;
+    if (amount_forsale) effectivePrice = price_t(amount_desired, amount_forsale);
     return effectivePrice;
 }
 
-rational_t CMPMetaDEx::inversePrice() const
+price_t CMPMetaDEx::inversePrice() const
 {
-    rational_t inversePrice;
-    if (amount_desired) inversePrice = rational_t(amount_forsale, amount_desired);
+    price_t inversePrice;
+    if (amount_desired) inversePrice = price_t(amount_forsale, amount_desired);
     return inversePrice;
 }
 
@@ -424,7 +500,7 @@ std::string CMPMetaDEx::ToString() const
         property, FormatMP(property, amount_forsale), desired_property, FormatMP(desired_property, amount_desired));
 }
 
-void CMPMetaDEx::saveOffer(std::ofstream& file, CHash256 &hasher) const
+void CMPMetaDEx::saveOffer(std::ostream& file, CHash256 &hasher) const
 {
     std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s,%d",
         addr,
@@ -454,39 +530,30 @@ bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) c
 
 bool mastercore::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
 {
-    // Create an empty price map (to use in case price map for this property does not already exist)
-    md_PricesMap temp_prices;
-    // Attempt to obtain the price map for the property
-    md_PricesMap *p_prices = get_Prices(objMetaDEx.getProperty());
-
-    // Create an empty set of metadex objects (to use in case no set currently exists at this price)
-    md_Set temp_indexes;
-    md_Set *p_indexes = nullptr;
-
-    // Prepare for return code
-    std::pair <md_Set::iterator, bool> ret;
-
-    // Attempt to obtain a set of metadex objects for this price from the price map
-    if (p_prices) p_indexes = get_Indexes(p_prices, objMetaDEx.unitPrice());
-    // See if the set was populated, if not no set exists at this price level, use the empty set that we created earlier
-    if (!p_indexes) p_indexes = &temp_indexes;
-
-    // Attempt to insert the metadex object into the set
-    ret = p_indexes->insert(objMetaDEx);
-    if (false == ret.second) return false;
+    // Obtain the set of metadex objects at this price, in the order book for this pair
+    md_PricesMap& prices = metadex[md_PropertyPair(objMetaDEx.getProperty(), objMetaDEx.getDesProperty())];
+    md_Set& indexes = prices[objMetaDEx.unitPrice()];
 
-    // If a prices map did not exist for this property, set p_prices to the temp empty price map
-    if (!p_prices) p_prices = &temp_prices;
+    // Attempt to insert the metadex object into the set; orders usually arrive in block order
+    size_t nBefore = indexes.size();
+    indexes.insert(indexes.end(), objMetaDEx);
+    if (indexes.size() == nBefore) return false;
 
-    // Update the prices map with the new set at this price
-    (*p_prices)[objMetaDEx.unitPrice()] = *p_indexes;
-
-    // Set the metadex map for the property to the updated (or new if it didn't exist) price map
-    metadex[objMetaDEx.getProperty()] = *p_prices;
+    MetaDEx_indexOrder(objMetaDEx);
+    UpdateStateHash(objMetaDEx, true);
 
     return true;
 }
 
+/**
+ * Removes all orders from the MetaDEx maps, without any further processing.
+ */
+void mastercore::MetaDEx_CLEAR()
+{
+    metadex.clear();
+    metadex_txids.clear();
+}
+
 // pretty much directly linked to the ADD TX21 command off the wire
 int mastercore::MetaDEx_ADD(const std::string& sender_addr, uint32_t prop, int64_t amount, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx)
 {
@@ -497,7 +564,7 @@ int mastercore::MetaDEx_ADD(const std::string& sender_addr, uint32_t prop, int64
     if (msc_debug_metadex1) PrintToLog("%s(); buyer obj: %s\n", __FUNCTION__, new_mdex.ToString());
 
     // Ensure this is not a badly priced trade (for example due to zero amounts)
-    if (0 >= new_mdex.unitPrice()) return METADEX_ERROR -66;
+    if (new_mdex.unitPrice() <= price_t()) return METADEX_ERROR -66;
 
     // Match against existing trades, remainder of the order will be put into the order book
     if (msc_debug_metadex3) MetaDEx_debug_print();
@@ -527,32 +594,28 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
 {
     int rc = METADEX_ERROR -20;
     CMPMetaDEx mdex(sender_addr, 0, prop, amount, property_desired, amount_desired, uint256(), 0, CMPTransaction::CANCEL_AT_PRICE);
-    md_PricesMap* prices = get_Prices(prop);
+    md_PricesMap* prices = get_Prices(prop, property_desired);
     const CMPMetaDEx* p_mdex = nullptr;
 
     if (msc_debug_metadex1) PrintToLog("%s():%s\n", __FUNCTION__, mdex.ToString());
 
     if (msc_debug_metadex2) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!MetaDEx_hasPrices(prop)) {
         PrintToLog("%s() NOTHING FOUND for %s\n", __FUNCTION__, mdex.ToString());
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        rational_t sellers_price = my_it->first;
-
-        if (mdex.unitPrice() != sellers_price) continue;
-
-        md_Set* indexes = &(my_it->second);
+    // within the order book of the pair only the price level of the cancellation is relevant
+    md_Set* indexes = prices ? get_Indexes(prices, mdex.unitPrice()) : nullptr;
 
+    if (indexes) {
         for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
             p_mdex = &(*iitt);
 
             if (msc_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
+            if (p_mdex->getAddr() != sender_addr) {
                 ++iitt;
                 continue;
             }
@@ -568,6 +631,8 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
             bool bValid = true;
             pDbTransactionList->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
+            UpdateStateHash(*iitt, false);
+            MetaDEx_unindexOrder(*iitt);
             indexes->erase(iitt++);
         }
     }
@@ -580,19 +645,21 @@ int mastercore::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block,
 int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block, const std::string& sender_addr, uint32_t prop, uint32_t property_desired)
 {
     int rc = METADEX_ERROR -30;
-    md_PricesMap* prices = get_Prices(prop);
+    md_PricesMap* prices = get_Prices(prop, property_desired);
     const CMPMetaDEx* p_mdex = nullptr;
 
     PrintToLog("%s(%d,%d)\n", __FUNCTION__, prop, property_desired);
 
     if (msc_debug_metadex3) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!MetaDEx_hasPrices(prop)) {
         PrintToLog("%s() NOTHING FOUND\n", __FUNCTION__);
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
+    if (!prices) return rc;
+
+    // within the order book of the pair iterate over the items
     for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
         md_Set* indexes = &(my_it->second);
 
@@ -601,7 +668,7 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
 
             if (msc_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
+            if (p_mdex->getAddr() != sender_addr) {
                 ++iitt;
                 continue;
             }
@@ -617,6 +684,8 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
             bool bValid = true;
             pDbTransactionList->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
+            UpdateStateHash(*iitt, false);
+            MetaDEx_unindexOrder(*iitt);
             indexes->erase(iitt++);
         }
     }
@@ -626,8 +695,27 @@ int mastercore::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int bl
     return rc;
 }
 
+/** An order to cancel, and its position in the MetaDEx maps. */
+struct MetaDEx_CancelRef
+{
+    price_t price;
+    md_Set* indexes;
+    md_Set::iterator it;
+};
+
+//! Orders cancellations by price, block and position, as they are sorted within the order book of a property
+static bool MetaDEx_cancelBefore(const MetaDEx_CancelRef& lhs, const MetaDEx_CancelRef& rhs)
+{
+    if (lhs.price != rhs.price) return lhs.price < rhs.price;
+    return MetaDEx_compare()(*lhs.it, *rhs.it);
+}
+
 /**
  * Scans the orderbook and remove everything for an address.
+ *
+ * The orders of a property for sale are cancelled by price across all desired
+ * properties, so the cancellations are recorded in the same order as before
+ * the order books were split by property pair.
  */
 int mastercore::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block, const std::string& sender_addr, unsigned char ecosystem)
 {
@@ -639,43 +727,54 @@ int mastercore::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int bloc
 
     PrintToLog("<<<<<<\n");
 
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        unsigned int prop = my_it->first;
+    md_PropertiesMap::iterator my_it = metadex.begin();
+    while (my_it != metadex.end()) {
+        unsigned int prop = my_it->first.first;
 
         // skip property, if it is not in the expected ecosystem
-        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) continue;
-        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop)) continue;
+        if ((isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) ||
+                (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop))) {
+            while (my_it != metadex.end() && my_it->first.first == prop) ++my_it;
+            continue;
+        }
 
         PrintToLog(" ## property: %u\n", prop);
-        md_PricesMap& prices = my_it->second;
 
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
-            md_Set& indexes = it->second;
-
-            PrintToLog("  # Price Level: %s\n", xToString(price));
-
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                PrintToLog("%s= %s\n", xToString(price), it->ToString());
-
-                if (it->getAddr() != sender_addr) {
-                    ++it;
-                    continue;
+        // collect the orders of the address in all order books of the property
+        std::vector<MetaDEx_CancelRef> vecCancels;
+        for (; my_it != metadex.end() && my_it->first.first == prop; ++my_it) {
+            md_PricesMap& prices = my_it->second;
+            for (md_PricesMap::iterator itPrice = prices.begin(); itPrice != prices.end(); ++itPrice) {
+                md_Set& indexes = itPrice->second;
+                for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                    if (it->getAddr() != sender_addr) continue;
+                    MetaDEx_CancelRef ref;
+                    ref.price = itPrice->first;
+                    ref.indexes = &indexes;
+                    ref.it = it;
+                    vecCancels.push_back(ref);
                 }
+            }
+        }
+        std::sort(vecCancels.begin(), vecCancels.end(), MetaDEx_cancelBefore);
 
-                rc = 0;
-                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
+        for (std::vector<MetaDEx_CancelRef>::iterator ref = vecCancels.begin(); ref != vecCancels.end(); ++ref) {
+            md_Set::iterator it = ref->it;
 
-                // move from reserve to balance
-                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+            rc = 0;
+            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
 
-                // record the cancellation
-                bool bValid = true;
-                pDbTransactionList->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
+            // move from reserve to balance
+            assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
+            assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
 
-                indexes.erase(it++);
-            }
+            // record the cancellation
+            bool bValid = true;
+            pDbTransactionList->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
+
+            UpdateStateHash(*it, false);
+            MetaDEx_unindexOrder(*it);
+            ref->indexes->erase(it);
         }
     }
     PrintToLog(">>>>>>\n");
@@ -693,17 +792,19 @@ int mastercore::MetaDEx_SHUTDOWN_ALLPAIR()
     int rc = 0;
     PrintToLog("%s()\n", __FUNCTION__);
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PropertyPair& pair = my_it->first;
+        if (pair.first <= COUNOS_PROPERTY_TMSC || pair.second <= COUNOS_PROPERTY_TMSC) continue; // COUN/TCOUN side to the trade
         md_PricesMap& prices = my_it->second;
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
             md_Set& indexes = it->second;
             for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                if (it->getDesProperty() > COUNOS_PROPERTY_TMSC && it->getProperty() > COUNOS_PROPERTY_TMSC) { // no COUN/TCOUN side to the trade
-                    PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
-                    // move from reserve to balance
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                    assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                    indexes.erase(it++);
-                }
+                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
+                // move from reserve to balance
+                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
+                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+                UpdateStateHash(*it, false);
+                MetaDEx_unindexOrder(*it);
+                indexes.erase(it++);
             }
         }
     }
@@ -726,29 +827,23 @@ int mastercore::MetaDEx_SHUTDOWN()
                 // move from reserve to balance
                 assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                 assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
+                UpdateStateHash(*it, false);
                 indexes.erase(it++);
             }
         }
     }
+    metadex_txids.clear();
     return rc;
 }
 
 // searches the metadex maps to see if a trade is still open
-// allows search to be optimized if propertyIdForSale is specified
+// if propertyIdForSale is specified, the trade must also sell this property
 bool mastercore::MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale)
 {
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first) continue;
-        md_PricesMap & prices = my_it->second;
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            md_Set & indexes = (it->second);
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                CMPMetaDEx obj = *it;
-                if( obj.getHash().GetHex() == txid.GetHex() ) return true;
-            }
-        }
-    }
-    return false;
+    const CMPMetaDEx* obj = MetaDEx_findOrder(txid);
+    if (!obj) return false;
+    if (propertyIdForSale != 0 && propertyIdForSale != obj->getProperty()) return false;
+    return true;
 }
 
 /**
@@ -807,13 +902,13 @@ void mastercore::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
 {
     PrintToLog("<<<\n");
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        uint32_t prop = my_it->first;
+        const md_PropertyPair& pair = my_it->first;
 
-        PrintToLog(" ## property: %u\n", prop);
+        PrintToLog(" ## property: %u, desired property: %u\n", pair.first, pair.second);
         md_PricesMap& prices = my_it->second;
 
         for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
+            const price_t& price = it->first;
             md_Set& indexes = it->second;
 
             if (bShowPriceLevel) PrintToLog("  # Price Level: %s\n", xToString(price));
@@ -835,14 +930,5 @@ void mastercore::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
  */
 const CMPMetaDEx* mastercore::MetaDEx_RetrieveTrade(const uint256& txid)
 {
-    for (md_PropertiesMap::iterator propIter = metadex.begin(); propIter != metadex.end(); ++propIter) {
-        md_PricesMap & prices = propIter->second;
-        for (md_PricesMap::iterator pricesIter = prices.begin(); pricesIter != prices.end(); ++pricesIter) {
-            md_Set & indexes = pricesIter->second;
-            for (md_Set::iterator tradesIter = indexes.begin(); tradesIter != indexes.end(); ++tradesIter) {
-                if (txid == (*tradesIter).getHash()) return &(*tradesIter);
-            }
-        }
-    }
-    return static_cast<CMPMetaDEx*>(nullptr);
+    return MetaDEx_findOrder(txid);
 }
@@ -3,6 +3,7 @@
 
 #include <counoscore/tx.h>
 
+#include <serialize.h>
 #include <uint256.h>
 
 #include <boost/lexical_cast.hpp>
@@ -16,11 +17,67 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 
 class CHash256;
 
 typedef boost::rational<boost::multiprecision::checked_int128_t> rational_t;
 
+/** A price as ratio of two amounts, used to sort and match orders.
+ *
+ * Unlike rational_t, the ratio is not reduced, and prices are compared exactly
+ * by cross-multiplication of the 64 bit amounts in 128 bit integers, which
+ * avoids the normalization and overflow checks of rational_t. Equal prices
+ * with different amounts, such as 1/2 and 2/4, compare as equal.
+ */
+class price_t
+{
+private:
+#ifdef __SIZEOF_INT128__
+    typedef __int128 product_t;
+#else
+    typedef boost::multiprecision::int128_t product_t;
+#endif
+
+    int64_t num;
+    int64_t denom;
+
+    //! Returns a negative value, if lhs < rhs, zero, if equal, and a positive value otherwise
+    static int compare(const price_t& lhs, const price_t& rhs)
+    {
+        const product_t left = product_t(lhs.num) * rhs.denom;
+        const product_t right = product_t(rhs.num) * lhs.denom;
+        if (left < right) return -1;
+        return (right < left) ? 1 : 0;
+    }
+
+public:
+    price_t() : num(0), denom(1) {}
+
+    /** Creates a price; the denominator must not be zero. */
+    price_t(int64_t numerator, int64_t denominator) : num(numerator), denom(denominator)
+    {
+        // the sign is carried by the numerator, so the cross-multiplication preserves the order
+        if (denom < 0) {
+            num = -num;
+            denom = -denom;
+        }
+    }
+
+    int64_t numerator() const { return num; }
+    int64_t denominator() const { return denom; }
+
+    /** Returns the price as reduced fraction, for example for display purposes. */
+    rational_t toRational() const { return rational_t(num, denom); }
+
+    friend bool operator==(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) == 0; }
+    friend bool operator!=(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) != 0; }
+    friend bool operator<(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) < 0; }
+    friend bool operator<=(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) <= 0; }
+    friend bool operator>(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) > 0; }
+    friend bool operator>=(const price_t& lhs, const price_t& rhs) { return compare(lhs, rhs) >= 0; }
+};
+
 // MetaDEx trade statuses
 #define TRADE_INVALID                 -1
 #define TRADE_OPEN                    1
@@ -31,6 +88,7 @@ typedef boost::rational<boost::multiprecision::checked_int128_t> rational_t;
 
 /** Converts price to string. */
 std::string xToString(const rational_t& value);
+std::string xToString(const price_t& value);
 
 /** A trade on the distributed exchange.
  */
@@ -91,15 +149,31 @@ public:
 
     std::string ToString() const;
 
-    rational_t unitPrice() const;
-    rational_t inversePrice() const;
+    price_t unitPrice() const;
+    price_t inversePrice() const;
 
     /** Used for display of unit prices to 8 decimal places at UI layer. */
     std::string displayUnitPrice() const;
     /** Used for display of unit prices with 50 decimal places at RPC layer. */
     std::string displayFullUnitPrice() const;
 
-    void saveOffer(std::ofstream& file, CHash256 &hasher) const;
+    void saveOffer(std::ostream& file, CHash256 &hasher) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(block);
+        READWRITE(txid);
+        READWRITE(idx);
+        READWRITE(property);
+        READWRITE(amount_forsale);
+        READWRITE(desired_property);
+        READWRITE(amount_desired);
+        READWRITE(amount_remaining);
+        READWRITE(subaction);
+        READWRITE(addr);
+    }
 };
 
 namespace mastercore
@@ -113,16 +187,17 @@ struct MetaDEx_compare
 //! Set of objects sorted by block+idx
 typedef std::set<CMPMetaDEx, MetaDEx_compare> md_Set; 
 //! Map of prices; there is a set of sorted objects for each price
-typedef std::map<rational_t, md_Set> md_PricesMap;
-//! Map of properties; there is a map of prices for each property
-typedef std::map<uint32_t, md_PricesMap> md_PropertiesMap;
+typedef std::map<price_t, md_Set> md_PricesMap;
+//! Pair of properties; the property for sale, and the desired property
+typedef std::pair<uint32_t, uint32_t> md_PropertyPair;
+//! Map of property pairs; there is a map of prices for each pair
+typedef std::map<md_PropertyPair, md_PricesMap> md_PropertiesMap;
 
 //! Global map for price and order data
 extern md_PropertiesMap metadex;
 
-// TODO: explore a property-pair, instead of a single property as map's key........
-md_PricesMap* get_Prices(uint32_t prop);
-md_Set* get_Indexes(md_PricesMap* p, rational_t price);
+md_PricesMap* get_Prices(uint32_t prop, uint32_t desprop);
+md_Set* get_Indexes(md_PricesMap* p, const price_t& price);
 // ---------------
 
 int MetaDEx_ADD(const std::string& sender_addr, uint32_t, int64_t, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx);
@@ -132,6 +207,7 @@ int MetaDEx_CANCEL_EVERYTHING(const uint256& txid, uint32_t block, const std::st
 int MetaDEx_SHUTDOWN();
 int MetaDEx_SHUTDOWN_ALLPAIR();
 bool MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx);
+void MetaDEx_CLEAR();
 void MetaDEx_debug_print(bool bShowPriceLevel = false, bool bDisplay = false);
 bool MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale = 0);
 int MetaDEx_getStatus(const uint256& txid, uint32_t propertyIdForSale, int64_t amountForSale, int64_t totalSold = -1);
@@ -54,6 +54,17 @@ auto to_pair(std::tuple<T...>& t) -> decltype(std::make_pair(std::get<I>(t), std
 std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::GetRange(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type)
 {
     assert(pdb);
+
+    if (type == NonFungibleStorage::RangeIndex) {
+        LOCK(cs_nft);
+        const OwnedRanges& index = GetOwnedRanges(propertyId);
+        auto it = FindOwnedRange(index, tokenId);
+        if (it != index.ranges.end()) {
+            return std::make_pair(it->first, it->second.first);
+        }
+        return std::make_pair(0, 0); // token not found, return zero'd range
+    }
+
     CDBaseIterator it{NewIterator(), createNFTKey(propertyId, type)};
 
     for (; it; ++it) {
@@ -74,16 +85,12 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::GetRange(const uint32_t &prop
 std::string CMPNonFungibleTokensDB::GetNonFungibleTokenValueInRange(const uint32_t &propertyId, const int64_t &rangeStart, const int64_t &rangeEnd)
 {
     assert(pdb);
-    auto rangeIndex = NonFungibleStorage::RangeIndex;
-    CDBaseIterator it{NewIterator(), createNFTKey(propertyId, rangeIndex)};
-    for (; it; ++it) {
-        auto nkey = parseNFTKey(it->key().ToString());
-        if (to_pair<0, 1>(nkey) != std::make_pair(propertyId, rangeIndex)) {
-            break;
-        }
-        if (rangeStart >= std::get<2>(nkey) && rangeEnd <= std::get<3>(nkey)) {
-            return it->value().ToString();
-        }
+    LOCK(cs_nft);
+
+    const OwnedRanges& index = GetOwnedRanges(propertyId);
+    auto it = FindOwnedRange(index, rangeStart);
+    if (it != index.ranges.end() && rangeEnd <= it->second.first) {
+        return it->second.second;
     }
 
     return {}; // range doesn't exist
@@ -96,6 +103,7 @@ bool CMPNonFungibleTokensDB::MoveNonFungibleTokens(const uint32_t &propertyId, c
     if (msc_debug_nftdb) PrintToLog("%s(): %d:%d:%d:%s:%s, line %d, file: %s\n", __FUNCTION__, propertyId, tokenIdStart, tokenIdEnd, from, to, __LINE__, __FILE__);
 
     assert(pdb);
+    LOCK(cs_nft);
 
     // check that 'from' owns both the start and end token and that the range is contiguous (owns the entire range)
     std::string startOwner = GetNonFungibleTokenValueInRange(propertyId, tokenIdStart, tokenIdEnd);
@@ -123,34 +131,42 @@ bool CMPNonFungibleTokensDB::MoveNonFungibleTokens(const uint32_t &propertyId, c
         bToAdjacentRangeAfter = true;
     }
 
+    // all changes are looked up in the in-memory index, and written at once
+    leveldb::WriteBatch batch;
+
     // adjust 'from' ranges
-    DeleteRange(propertyId, senderTokenRange.first, senderTokenRange.second, NonFungibleStorage::RangeIndex);
+    DeleteRange(batch, propertyId, senderTokenRange.first, senderTokenRange.second, NonFungibleStorage::RangeIndex);
     if (bMovingCompleteRange != true) {
         if (senderTokenRange.first < tokenIdStart) {
-            AddRange(propertyId, senderTokenRange.first, tokenIdStart - 1, from, NonFungibleStorage::RangeIndex);
+            AddRange(batch, propertyId, senderTokenRange.first, tokenIdStart - 1, from, NonFungibleStorage::RangeIndex);
         }
         if (senderTokenRange.second > tokenIdEnd) {
-            AddRange(propertyId, tokenIdEnd + 1, senderTokenRange.second, from, NonFungibleStorage::RangeIndex);
+            AddRange(batch, propertyId, tokenIdEnd + 1, senderTokenRange.second, from, NonFungibleStorage::RangeIndex);
         }
     }
 
     // adjust 'to' ranges
     if (bToAdjacentRangeBefore == false && bToAdjacentRangeAfter == false) {
-        AddRange(propertyId, tokenIdStart, tokenIdEnd, to, NonFungibleStorage::RangeIndex);
+        AddRange(batch, propertyId, tokenIdStart, tokenIdEnd, to, NonFungibleStorage::RangeIndex);
     } else {
         int64_t newTokenIdStart = tokenIdStart;
         int64_t newTokenIdEnd = tokenIdEnd;
         if (bToAdjacentRangeBefore) {
             std::pair<int64_t,int64_t> oldRange = GetRange(propertyId, tokenIdStart-1, NonFungibleStorage::RangeIndex);
             newTokenIdStart = oldRange.first;
-            DeleteRange(propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
+            DeleteRange(batch, propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
         }
         if (bToAdjacentRangeAfter) {
             std::pair<int64_t,int64_t> oldRange = GetRange(propertyId, tokenIdEnd+1, NonFungibleStorage::RangeIndex);
             newTokenIdEnd = oldRange.second;
-            DeleteRange(propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
+            DeleteRange(batch, propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
         }
-        AddRange(propertyId, newTokenIdStart, newTokenIdEnd, to, NonFungibleStorage::RangeIndex);
+        AddRange(batch, propertyId, newTokenIdStart, newTokenIdEnd, to, NonFungibleStorage::RangeIndex);
+    }
+
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR: failed to write ranges: %s\n", __FUNCTION__, status.ToString());
     }
 
     return true;
@@ -209,8 +225,57 @@ bool CMPNonFungibleTokensDB::ChangeNonFungibleTokenData(const uint32_t &property
 int64_t CMPNonFungibleTokensDB::GetHighestRangeEnd(const uint32_t &propertyId)
 {
     assert(pdb);
+    LOCK(cs_nft);
 
-    int64_t tokenCount = 0;
+    LoadHighestRangeEnds();
+
+    std::map<uint32_t, int64_t>::const_iterator it = mapHighestRangeEnd.find(propertyId);
+    if (it == mapHighestRangeEnd.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+/* Loads the highest token range ends, once after opening or clearing the database
+ */
+void CMPNonFungibleTokensDB::LoadHighestRangeEnds()
+{
+    if (fHighestRangeEndLoaded) return;
+
+    mapHighestRangeEnd = ScanHighestRangeEnds();
+    fHighestRangeEndLoaded = true;
+}
+
+/* Iterates over all ranges to find the highest token range end of each property
+ */
+std::map<uint32_t, int64_t> CMPNonFungibleTokensDB::ScanHighestRangeEnds()
+{
+    assert(pdb);
+
+    std::map<uint32_t, int64_t> totals;
+
+    CDBaseIterator it{NewIterator()};
+    for (; it; ++it) {
+        auto nkey = parseNFTKey(it->key().ToString());
+        if (std::get<1>(nkey) != NonFungibleStorage::RangeIndex) continue;
+
+        auto& prop = totals[std::get<0>(nkey)];
+        prop = std::max(prop, std::max(std::get<2>(nkey), std::get<3>(nkey)));
+    }
+
+    return totals;
+}
+
+/* Gets the owned ranges of a property, which are loaded from the database when first used
+ */
+CMPNonFungibleTokensDB::OwnedRanges& CMPNonFungibleTokensDB::GetOwnedRanges(const uint32_t &propertyId)
+{
+    std::map<uint32_t, OwnedRanges>::iterator itIndex = mapOwnedRanges.find(propertyId);
+    if (itIndex != mapOwnedRanges.end()) {
+        return itIndex->second;
+    }
+
+    OwnedRanges& index = mapOwnedRanges[propertyId];
     auto rangeIndex = NonFungibleStorage::RangeIndex;
     CDBaseIterator it{NewIterator(), createNFTKey(propertyId, rangeIndex)};
 
@@ -219,9 +284,50 @@ int64_t CMPNonFungibleTokensDB::GetHighestRangeEnd(const uint32_t &propertyId)
         if (to_pair<0, 1>(nkey) != std::make_pair(propertyId, rangeIndex)) {
             break;
         }
-        tokenCount = std::max(tokenCount, std::max(std::get<2>(nkey), std::get<3>(nkey)));
+        std::string owner = it->value().ToString();
+        index.ranges[std::get<2>(nkey)] = std::make_pair(std::get<3>(nkey), owner);
+        index.owners[owner].insert(to_pair<2, 3>(nkey));
+    }
+
+    return index;
+}
+
+/* Loads the owned ranges of all properties, once after opening or clearing the database
+ */
+void CMPNonFungibleTokensDB::LoadAllOwnedRanges()
+{
+    if (fAllOwnedRangesLoaded) return;
+
+    // the loaded properties are replaced, which is fine, as they mirror the database
+    mapOwnedRanges.clear();
+
+    CDBaseIterator it{NewIterator()};
+    for (; it; ++it) {
+        auto nkey = parseNFTKey(it->key().ToString());
+        if (std::get<1>(nkey) != NonFungibleStorage::RangeIndex) continue;
+
+        OwnedRanges& index = mapOwnedRanges[std::get<0>(nkey)];
+        std::string owner = it->value().ToString();
+        index.ranges[std::get<2>(nkey)] = std::make_pair(std::get<3>(nkey), owner);
+        index.owners[owner].insert(to_pair<2, 3>(nkey));
+    }
+
+    fAllOwnedRangesLoaded = true;
+}
+
+/* Finds the owned range a token is in, which is the last range starting at or before the token
+ */
+std::map<int64_t, std::pair<int64_t, std::string>>::const_iterator CMPNonFungibleTokensDB::FindOwnedRange(const OwnedRanges& index, const int64_t &tokenId)
+{
+    auto it = index.ranges.upper_bound(tokenId);
+    if (it == index.ranges.begin()) {
+        return index.ranges.end();
+    }
+    --it;
+    if (tokenId > it->second.first) {
+        return index.ranges.end();
     }
-    return tokenCount;
+    return it;
 }
 
 /* Deletes a range of non-fungible tokens
@@ -229,8 +335,34 @@ int64_t CMPNonFungibleTokensDB::GetHighestRangeEnd(const uint32_t &propertyId)
 void CMPNonFungibleTokensDB::DeleteRange(const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const NonFungibleStorage type)
 {
     assert(pdb);
+    LOCK(cs_nft);
+
+    leveldb::WriteBatch batch;
+    DeleteRange(batch, propertyId, tokenIdStart, tokenIdEnd, type);
+    pdb->Write(leveldb::WriteOptions(), &batch);
+}
+
+/* Deletes a range of non-fungible tokens with the batch, and from the in-memory indexes
+ */
+void CMPNonFungibleTokensDB::DeleteRange(leveldb::WriteBatch& batch, const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const NonFungibleStorage type)
+{
     std::string key = createNFTKey(propertyId, type, tokenIdStart, tokenIdEnd);
-    pdb->Delete(leveldb::WriteOptions(), key);
+    batch.Delete(key);
+
+    // properties, which aren't loaded yet, are read from the database later
+    std::map<uint32_t, OwnedRanges>::iterator itIndex = mapOwnedRanges.find(propertyId);
+    if (type == NonFungibleStorage::RangeIndex && itIndex != mapOwnedRanges.end()) {
+        OwnedRanges& index = itIndex->second;
+        auto it = index.ranges.find(tokenIdStart);
+        if (it != index.ranges.end() && it->second.first == tokenIdEnd) {
+            auto itOwner = index.owners.find(it->second.second);
+            if (itOwner != index.owners.end()) {
+                itOwner->second.erase(std::make_pair(tokenIdStart, tokenIdEnd));
+                if (itOwner->second.empty()) index.owners.erase(itOwner);
+            }
+            index.ranges.erase(it);
+        }
+    }
 
     if (msc_debug_nftdb) PrintToLog("%s():%s, line %d, file: %s\n", __FUNCTION__, key, __LINE__, __FILE__);
 }
@@ -240,12 +372,38 @@ void CMPNonFungibleTokensDB::DeleteRange(const uint32_t &propertyId, const int64
 void CMPNonFungibleTokensDB::AddRange(const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const std::string &info, const NonFungibleStorage type)
 {
     assert(pdb);
+    LOCK(cs_nft);
+
+    leveldb::WriteBatch batch;
+    AddRange(batch, propertyId, tokenIdStart, tokenIdEnd, info, type);
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
 
+    if (msc_debug_nftdb) PrintToLog("%s():%s=%s:%s, line %d, file: %s\n", __FUNCTION__, createNFTKey(propertyId, type, tokenIdStart, tokenIdEnd), info, status.ToString(), __LINE__, __FILE__);
+}
+
+/* Adds a range of non-fungible tokens to the batch, and to the in-memory indexes
+ */
+void CMPNonFungibleTokensDB::AddRange(leveldb::WriteBatch& batch, const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const std::string &info, const NonFungibleStorage type)
+{
     std::string key = createNFTKey(propertyId, type, tokenIdStart, tokenIdEnd);
-    leveldb::Status status = pdb->Put(writeoptions, key, info);
+    batch.Put(key, info);
     ++nWritten;
 
-    if (msc_debug_nftdb) PrintToLog("%s():%s=%s:%s, line %d, file: %s\n", __FUNCTION__, key, info, status.ToString(), __LINE__, __FILE__);
+    if (type != NonFungibleStorage::RangeIndex) return;
+
+    // properties, which aren't loaded yet, are read from the database later
+    std::map<uint32_t, OwnedRanges>::iterator itIndex = mapOwnedRanges.find(propertyId);
+    if (itIndex != mapOwnedRanges.end()) {
+        OwnedRanges& index = itIndex->second;
+        index.ranges[tokenIdStart] = std::make_pair(tokenIdEnd, info);
+        index.owners[info].insert(std::make_pair(tokenIdStart, tokenIdEnd));
+    }
+
+    // ranges are only deleted to be split or merged, so the highest range end only grows when tokens are created
+    if (fHighestRangeEndLoaded) {
+        int64_t& highestRangeEnd = mapHighestRangeEnd[propertyId];
+        highestRangeEnd = std::max(highestRangeEnd, std::max(tokenIdStart, tokenIdEnd));
+    }
 }
 
 /* Creates a range of non-fungible tokens
@@ -259,6 +417,9 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::CreateNonFungibleTokens(const
         return {};
     }
 
+    assert(pdb);
+    LOCK(cs_nft);
+
     int64_t highestId = GetHighestRangeEnd(propertyId);
     int64_t newTokenStartId = highestId + 1;
     int64_t newTokenEndId = 0;
@@ -269,18 +430,24 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::CreateNonFungibleTokens(const
         newTokenEndId = highestId + amount;
     }
 
-    AddRange(propertyId, newTokenStartId, newTokenEndId, info, NonFungibleStorage::GrantData);
+    leveldb::WriteBatch batch;
+    AddRange(batch, propertyId, newTokenStartId, newTokenEndId, info, NonFungibleStorage::GrantData);
 
     std::pair<int64_t,int64_t> newRange = std::make_pair(newTokenStartId, newTokenEndId);
 
     std::string highestRangeOwner = GetNonFungibleTokenValue(propertyId, highestId, NonFungibleStorage::RangeIndex);
     if (highestRangeOwner == owner) {
         std::pair<int64_t,int64_t> oldRange = GetRange(propertyId, highestId, NonFungibleStorage::RangeIndex);
-        DeleteRange(propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
+        DeleteRange(batch, propertyId, oldRange.first, oldRange.second, NonFungibleStorage::RangeIndex);
         newTokenStartId = oldRange.first; // override range start to merge ranges from same owner
     }
 
-    AddRange(propertyId, newTokenStartId, newTokenEndId, owner, NonFungibleStorage::RangeIndex);
+    AddRange(batch, propertyId, newTokenStartId, newTokenEndId, owner, NonFungibleStorage::RangeIndex);
+
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR: failed to write ranges: %s\n", __FUNCTION__, status.ToString());
+    }
 
     return newRange;
 }
@@ -290,6 +457,17 @@ std::pair<int64_t,int64_t> CMPNonFungibleTokensDB::CreateNonFungibleTokens(const
 std::string CMPNonFungibleTokensDB::GetNonFungibleTokenValue(const uint32_t &propertyId, const int64_t &tokenId, const NonFungibleStorage type)
 {
     assert(pdb);
+
+    if (type == NonFungibleStorage::RangeIndex) {
+        LOCK(cs_nft);
+        const OwnedRanges& index = GetOwnedRanges(propertyId);
+        auto it = FindOwnedRange(index, tokenId);
+        if (it != index.ranges.end()) {
+            return it->second.second;
+        }
+        return {}; // not found
+    }
+
     CDBaseIterator it{NewIterator(), createNFTKey(propertyId, type)};
 
     for (; it; ++it) {
@@ -311,21 +489,21 @@ std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> CMPNonFungibleToken
 {
     std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> uniqueMap;
     assert(pdb);
-    auto rangeIndex = NonFungibleStorage::RangeIndex;
-    CDBaseIterator it{NewIterator(), createNFTKey(propertyId, rangeIndex)};
+    LOCK(cs_nft);
 
-    for (; it; ++it) {
-        auto nkey = parseNFTKey(it->key().ToString());
-        if (propertyId != 0 && to_pair<0, 1>(nkey) != std::make_pair(propertyId, rangeIndex)) {
-            break;
-        }
-        if (std::get<1>(nkey) != rangeIndex) {
-            continue;
-        }
-        std::string value = it->value().ToString();
-        if (value != address) continue;
+    if (propertyId != 0) {
+        GetOwnedRanges(propertyId);
+    } else {
+        LoadAllOwnedRanges();
+    }
+
+    for (std::map<uint32_t, OwnedRanges>::const_iterator itIndex = mapOwnedRanges.begin(); itIndex != mapOwnedRanges.end(); ++itIndex) {
+        if (propertyId != 0 && itIndex->first != propertyId) continue;
 
-        uniqueMap[std::get<0>(nkey)].emplace_back(std::get<2>(nkey), std::get<3>(nkey));
+        auto itOwner = itIndex->second.owners.find(address);
+        if (itOwner == itIndex->second.owners.end()) continue;
+
+        uniqueMap[itIndex->first].assign(itOwner->second.begin(), itOwner->second.end());
     }
 
     return uniqueMap;
@@ -338,49 +516,65 @@ std::vector<std::pair<std::string,std::pair<int64_t,int64_t>>> CMPNonFungibleTok
     std::vector<std::pair<std::string,std::pair<int64_t,int64_t>>> rangeMap;
 
     assert(pdb);
-    auto rangeIndex = NonFungibleStorage::RangeIndex;
-    CDBaseIterator it{NewIterator(), createNFTKey(propertyId, rangeIndex)};
+    LOCK(cs_nft);
 
-    for (; it; ++it) {
-        auto nkey = parseNFTKey(it->key().ToString());
-        if (to_pair<0, 1>(nkey) != std::make_pair(propertyId, rangeIndex)) {
-            break;
-        }
-        rangeMap.emplace_back(it->value().ToString(), to_pair<2, 3>(nkey));
+    const OwnedRanges& index = GetOwnedRanges(propertyId);
+    for (auto it = index.ranges.begin(); it != index.ranges.end(); ++it) {
+        rangeMap.emplace_back(it->second.second, std::make_pair(it->first, it->second.first));
     }
 
     return rangeMap;
 }
 
+void CMPNonFungibleTokensDB::Clear()
+{
+    LOCK(cs_nft);
+    CDBBase::Clear();
+    mapOwnedRanges.clear();
+    fAllOwnedRangesLoaded = false;
+    mapHighestRangeEnd.clear();
+    fHighestRangeEndLoaded = false;
+}
+
 void CMPNonFungibleTokensDB::SanityCheck()
 {
     assert(pdb);
+    LOCK(cs_nft);
 
-    std::string result;
-
-    std::map<uint32_t,int64_t> totals;
-
-    CDBaseIterator it{NewIterator()};
-    for (; it; ++it) {
-        auto nkey = parseNFTKey(it->key().ToString());
-        if (std::get<1>(nkey) != NonFungibleStorage::RangeIndex) continue;
+    LoadHighestRangeEnds();
 
-        auto& prop = totals[std::get<0>(nkey)];
-        prop = std::max(prop, std::get<3>(nkey));
-    }
+    std::string result;
 
-    for (std::map<uint32_t,int64_t>::iterator it = totals.begin(); it != totals.end(); ++it) {
-        if (mastercore::getTotalTokens(it->first) != it->second) {
-            std::string abortMsg = strprintf("Failed sanity check on property %d (%d != %d)\n", it->first, mastercore::getTotalTokens(it->first), it->second);
+    for (std::map<uint32_t,int64_t>::const_iterator it = mapHighestRangeEnd.begin(); it != mapHighestRangeEnd.end(); ++it) {
+        int64_t totalTokens = mastercore::getTotalTokens(it->first);
+        if (totalTokens != it->second) {
+            std::string abortMsg = strprintf("Failed sanity check on property %d (%d != %d)\n", it->first, totalTokens, it->second);
             AbortNode(abortMsg);
         } else if (msc_debug_nftdb) {
-            result += strprintf("%d:%d=%d,", it->first, mastercore::getTotalTokens(it->first), it->second);
+            result += strprintf("%d:%d=%d,", it->first, totalTokens, it->second);
         }
     }
 
     if (msc_debug_nftdb) PrintToLog("UTDB sanity check OK (%s)\n", result);
 }
 
+void CMPNonFungibleTokensDB::FullSanityCheck()
+{
+    assert(pdb);
+    LOCK(cs_nft);
+
+    LoadHighestRangeEnds();
+
+    std::map<uint32_t,int64_t> totals = ScanHighestRangeEnds();
+
+    if (totals != mapHighestRangeEnd) {
+        AbortNode("Failed sanity check of the tracked non-fungible token ranges\n");
+        return;
+    }
+
+    SanityCheck();
+}
+
 void CMPNonFungibleTokensDB::printStats()
 {
     PrintToLog("CMPTxList stats: nWritten= %d , nRead= %d\n", nWritten, nRead);
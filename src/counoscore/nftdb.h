@@ -9,7 +9,14 @@
 #include <counoscore/log.h>
 #include <counoscore/persistence.h>
 
+#include <sync.h>
+
 #include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 #include <boost/filesystem.hpp>
 
 enum class NonFungibleStorage : unsigned char
@@ -25,9 +32,44 @@ enum class NonFungibleStorage : unsigned char
  */
 class CMPNonFungibleTokensDB : public CDBBase
 {
+private:
+    /** The ranges of owned tokens of one property, by first token and by owner. */
+    struct OwnedRanges
+    {
+        //! Last token and owner of each range, by first token
+        std::map<int64_t, std::pair<int64_t, std::string>> ranges;
+        //! Ranges of each owner
+        std::map<std::string, std::set<std::pair<int64_t, int64_t>>> owners;
+    };
+
+    //! Guards the in-memory indexes, which are also used by RPC threads
+    RecursiveMutex cs_nft;
+    //! Owned ranges by property, mirroring the range index of the database
+    std::map<uint32_t, OwnedRanges> mapOwnedRanges;
+    //! Whether the owned ranges of all properties were loaded from the database
+    bool fAllOwnedRangesLoaded;
+    //! Highest token range end by property, which is the number of created tokens
+    std::map<uint32_t, int64_t> mapHighestRangeEnd;
+    //! Whether the highest range ends were loaded from the database
+    bool fHighestRangeEndLoaded;
+
+    // Loads the highest token range ends of all properties from the database
+    void LoadHighestRangeEnds();
+    // Scans the database for the highest token range end of each property
+    std::map<uint32_t, int64_t> ScanHighestRangeEnds();
+    // Gets the owned ranges of a property, which are loaded from the database when first used
+    OwnedRanges& GetOwnedRanges(const uint32_t &propertyId);
+    // Loads the owned ranges of all properties from the database
+    void LoadAllOwnedRanges();
+    // Finds the owned range a token is in
+    static std::map<int64_t, std::pair<int64_t, std::string>>::const_iterator FindOwnedRange(const OwnedRanges& index, const int64_t &tokenId);
+    // Adds a range to the batch, and to the in-memory indexes
+    void AddRange(leveldb::WriteBatch& batch, const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const std::string &info, const NonFungibleStorage type);
+    // Deletes a range with the batch, and from the in-memory indexes
+    void DeleteRange(leveldb::WriteBatch& batch, const uint32_t &propertyId, const int64_t &tokenIdStart, const int64_t &tokenIdEnd, const NonFungibleStorage type);
 
 public:
-    CMPNonFungibleTokensDB(const boost::filesystem::path& path, bool fWipe)
+    CMPNonFungibleTokensDB(const boost::filesystem::path& path, bool fWipe) : fAllOwnedRangesLoaded(false), fHighestRangeEndLoaded(false)
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToConsole("Loading non-fungible tokens database: %s\n", status.ToString());
@@ -63,8 +105,12 @@ public:
     std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> GetAddressNonFungibleTokens(const uint32_t &propertyId, const std::string &address);
     // Gets the non-fungible token ranges for a property ID
     std::vector<std::pair<std::string,std::pair<int64_t,int64_t>>> GetNonFungibleTokenRanges(const uint32_t &propertyId);
-    // Sanity checks the token counts
+    // Deletes all entries, and resets the highest token range ends
+    void Clear();
+    // Sanity checks the token counts against the tracked highest token range ends
     void SanityCheck();
+    // Sanity checks the token counts and the tracked highest token range ends against the whole database
+    void FullSanityCheck();
 };
 
 namespace mastercore
@@ -1,5 +1,6 @@
 #include <counoscore/pending.h>
 
+#include <counoscore/counoscore.h>
 #include <counoscore/log.h>
 #include <counoscore/sp.h>
 
@@ -9,8 +10,10 @@
 #include <txmempool.h>
 #include <uint256.h>
 #include <ui_interface.h>
+#include <validationinterface.h>
 
 #include <string>
+#include <vector>
 
 namespace mastercore
 {
@@ -76,19 +79,19 @@ void PendingDelete(const uint256& txid)
  * Performs a check to ensure all pending transactions are still in the mempool.
  *
  * NOTE: Transactions no longer in the mempool (eg orphaned) are deleted from
- *       the pending map and credited back to the pending tally.
+ *       the pending map and credited back to the pending tally. Removals are
+ *       usually handled as they happen, see CMPPendingNotifications, so this
+ *       only catches transactions, which never made it into the mempool.
  */
 void PendingCheck()
 {
     LOCK(cs_pending);
 
-    std::vector<uint256> vecMemPoolTxids;
     std::vector<uint256> txidsForDeletion;
-    mempool.queryHashes(vecMemPoolTxids);
 
     for (PendingMap::iterator it = my_pending.begin(); it != my_pending.end(); ++it) {
         const uint256& txid = it->first;
-        if (std::find(vecMemPoolTxids.begin(), vecMemPoolTxids.end(), txid) == vecMemPoolTxids.end()) {
+        if (!mempool.exists(txid)) {
             PrintToLog("WARNING: Pending transaction %s is no longer in this nodes mempool and will be discarded\n", txid.GetHex());
             txidsForDeletion.push_back(txid);
         }
@@ -98,6 +101,48 @@ void PendingCheck()
         PendingDelete(txid);
 }
 
+/**
+ * Deletes pending transactions, when they are removed from the mempool for
+ * any other reason than being included in a block (e.g. expiry, eviction,
+ * replacement or conflicts).
+ *
+ * NOTE: transactions included in a block are deleted by the transaction handler.
+ */
+class CMPPendingNotifications : public CValidationInterface
+{
+protected:
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason) override
+    {
+        const uint256& txid = tx->GetHash();
+
+        // cs_tally is locked first, as done by the block and transaction handlers
+        LOCK2(cs_tally, cs_pending);
+        if (my_pending.find(txid) == my_pending.end()) return;
+
+        PrintToLog("WARNING: Pending transaction %s was removed from this nodes mempool and will be discarded\n", txid.GetHex());
+        PendingDelete(txid);
+    }
+};
+
+//! Handler for mempool removals
+static CMPPendingNotifications pendingNotifications;
+
+/**
+ * Subscribes to mempool removals, so pending transactions are deleted as soon as they are dropped.
+ */
+void PendingRegisterNotifications()
+{
+    RegisterValidationInterface(&pendingNotifications);
+}
+
+/**
+ * Unsubscribes from mempool removals.
+ */
+void PendingUnregisterNotifications()
+{
+    UnregisterValidationInterface(&pendingNotifications);
+}
+
 } // namespace mastercore
 
 /**
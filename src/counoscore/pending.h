@@ -28,6 +28,12 @@ void PendingDelete(const uint256& txid);
 /** Performs a check to ensure all pending transactions are still in the mempool. */
 void PendingCheck();
 
+/** Subscribes to mempool removals, so pending transactions are deleted as soon as they are dropped. */
+void PendingRegisterNotifications();
+
+/** Unsubscribes from mempool removals. */
+void PendingUnregisterNotifications();
+
 }
 
 /** Structure to hold information about pending transactions.
@@ -6,6 +6,7 @@
 
 #include <counoscore/persistence.h>
 
+#include <counoscore/consensushash.h>
 #include <counoscore/dex.h>
 #include <counoscore/log.h>
 #include <counoscore/mdex.h>
@@ -13,10 +14,15 @@
 #include <counoscore/sp.h>
 #include <counoscore/tally.h>
 #include <counoscore/utilscounosh.h>
+#include <counoscore/walletcache.h>
 
 #include <chain.h>
+#include <clientversion.h>
 #include <fs.h>
 #include <hash.h>
+#include <serialize.h>
+#include <streams.h>
+#include <sync.h>
 #include <validation.h>
 #include <tinyformat.h>
 #include <uint256.h>
@@ -27,10 +33,27 @@
 #include <boost/lexical_cast.hpp>
 
 #include <stdint.h>
-
+#include <string.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <ios>
+#include <limits>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -62,6 +85,18 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     "mdexorders",
 };
 
+//! Maximum number of states, which are queued to be written to disk
+static const size_t MAX_PENDING_STATE_WRITES = 2;
+
+//! Minimum size of a state file, for which the hash is verified by a separate thread while it's parsed
+static const size_t MIN_PARALLEL_HASH_SIZE = 1024 * 1024;
+
+//! Prefix, extension, magic and version of binary state snapshots
+static char const * const SNAPSHOT_PREFIX = "snapshot";
+static char const * const SNAPSHOT_EXTENSION = "bin";
+static const uint32_t SNAPSHOT_MAGIC = 0x53534e43; // "CNSS"
+static const uint32_t SNAPSHOT_VERSION = 1;
+
 static bool is_state_prefix(std::string const &str)
 {
     for (int i = 0; i < NUM_FILETYPES; ++i) {
@@ -73,22 +108,36 @@ static bool is_state_prefix(std::string const &str)
     return false;
 }
 
-static int write_msc_balances(std::ofstream& file, CHash256& hasher)
+/**
+ * Checks whether the parts of a file name, split at "-" and ".", belong to a
+ * text state file or to a binary state snapshot.
+ */
+static bool is_state_file(const std::vector<std::string>& vstr)
 {
-    std::unordered_map<std::string, CMPTally>::iterator iter;
+    if (vstr.size() != 3) return false;
+
+    if (is_state_prefix(vstr[0]) && boost::equals(vstr[2], "dat")) {
+        return true;
+    }
+
+    return boost::equals(vstr[0], SNAPSHOT_PREFIX) && boost::equals(vstr[2], SNAPSHOT_EXTENSION);
+}
+
+static int write_msc_balances(std::ostream& file, CHash256& hasher)
+{
+    std::unordered_map<AddressId, CMPTally>::iterator iter;
     for (iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
         bool emptyWallet = true;
 
-        std::string lineOut = (*iter).first;
+        std::string lineOut = addressTable.GetAddress((*iter).first);
         lineOut.append("=");
-        CMPTally& curAddr = (*iter).second;
-        curAddr.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = curAddr.next())) {
-            int64_t balance = (*iter).second.getMoney(propertyId, BALANCE);
-            int64_t sellReserved = (*iter).second.getMoney(propertyId, SELLOFFER_RESERVE);
-            int64_t acceptReserved = (*iter).second.getMoney(propertyId, ACCEPT_RESERVE);
-            int64_t metadexReserved = (*iter).second.getMoney(propertyId, METADEX_RESERVE);
+        const CMPTally& curAddr = (*iter).second;
+        for (CMPTally::const_iterator pit = curAddr.begin(); pit != curAddr.end(); ++pit) {
+            uint32_t propertyId = pit->propertyId;
+            int64_t balance = pit->balance[BALANCE];
+            int64_t sellReserved = pit->balance[SELLOFFER_RESERVE];
+            int64_t acceptReserved = pit->balance[ACCEPT_RESERVE];
+            int64_t metadexReserved = pit->balance[METADEX_RESERVE];
 
             // we don't allow 0 balances to read in, so if we don't write them
             // it makes things match up better between persisted state and processed state
@@ -118,7 +167,7 @@ static int write_msc_balances(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_offers(std::ofstream& file, CHash256& hasher)
+static int write_mp_offers(std::ostream& file, CHash256& hasher)
 {
     OfferMap::const_iterator iter;
     for (iter = my_offers.begin(); iter != my_offers.end(); ++iter) {
@@ -132,7 +181,7 @@ static int write_mp_offers(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_accepts(std::ofstream& file, CHash256& hasher)
+static int write_mp_accepts(std::ostream& file, CHash256& hasher)
 {
     AcceptMap::const_iterator iter;
     for (iter = my_accepts.begin(); iter != my_accepts.end(); ++iter) {
@@ -146,7 +195,7 @@ static int write_mp_accepts(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_globals_state(std::ofstream& file, CHash256& hasher)
+static int write_globals_state(std::ostream& file, CHash256& hasher)
 {
     uint32_t nextSPID = pDbSpInfo->peekNextSPID(COUNOS_PROPERTY_MSC);
     uint32_t nextTestSPID = pDbSpInfo->peekNextSPID(COUNOS_PROPERTY_TMSC);
@@ -164,7 +213,7 @@ static int write_globals_state(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_crowdsales(std::ofstream& file, CHash256& hasher)
+static int write_mp_crowdsales(std::ostream& file, CHash256& hasher)
 {
     for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
         // decompose the key for address
@@ -175,7 +224,7 @@ static int write_mp_crowdsales(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_metadex(std::ofstream &file, CHash256& hasher)
+static int write_mp_metadex(std::ostream &file, CHash256& hasher)
 {
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         md_PricesMap& prices = my_it->second;
@@ -191,46 +240,93 @@ static int write_mp_metadex(std::ofstream &file, CHash256& hasher)
     return 0;
 }
 
-static int input_msc_balances_string(const std::string& s)
+/**
+ * Parses a decimal number at the cursor and advances it behind the last digit.
+ *
+ * Unlike boost::lexical_cast, no string is constructed for each field.
+ */
+static bool parse_decimal(const char*& p, const char* end, int64_t& value)
 {
-    // "address=propertybalancedata"
-    std::vector<std::string> addrData;
-    boost::split(addrData, s, boost::is_any_of("="), boost::token_compress_on);
-    if (addrData.size() != 2) return -1;
+    bool fNegative = false;
+    if (p != end && *p == '-') {
+        fNegative = true;
+        ++p;
+    }
+    if (p == end || *p < '0' || *p > '9') return false;
+
+    const uint64_t nLimit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (fNegative ? 1 : 0);
+    uint64_t n = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        const uint64_t digit = *p - '0';
+        if (n > (nLimit - digit) / 10) return false;
+        n = n * 10 + digit;
+    }
+
+    if (!fNegative) {
+        value = static_cast<int64_t>(n);
+    } else if (n == nLimit) {
+        value = std::numeric_limits<int64_t>::min();
+    } else {
+        value = -static_cast<int64_t>(n);
+    }
 
-    std::string strAddress = addrData[0];
+    return true;
+}
 
-    // split the tuples of properties
-    std::vector<std::string> vProperties;
-    boost::split(vProperties, addrData[1], boost::is_any_of(";"), boost::token_compress_on);
+/**
+ * Loads the balances of one address directly into the tally map.
+ *
+ * The line is parsed in place, and the tally, holder index, totals and state
+ * hash are updated once per property, instead of through update_tally_map()
+ * for each amount.
+ */
+static int input_msc_balances_buffer(const char* begin, const char* end)
+{
+    static const TallyType tallyTypes[] = {BALANCE, SELLOFFER_RESERVE, ACCEPT_RESERVE, METADEX_RESERVE};
 
-    std::vector<std::string>::const_iterator iter;
-    for (iter = vProperties.begin(); iter != vProperties.end(); ++iter) {
-        if ((*iter).empty()) {
+    // "address=propertybalancedata"
+    const char* p = std::find(begin, end, '=');
+    if (p == begin || p == end) return -1;
+
+    const std::string strAddress(begin, p++);
+    const AddressId id = addressTable.Intern(strAddress);
+    std::pair<std::unordered_map<AddressId, CMPTally>::iterator, bool> inserted = mp_tally_map.insert(std::make_pair(id, CMPTally()));
+    CMPTally& tally = inserted.first->second;
+
+    while (p != end) {
+        // skip empty tuples
+        if (*p == ';') {
+            ++p;
             continue;
         }
 
-        // "propertyid:balancedata"
-        std::vector<std::string> curProperty;
-        boost::split(curProperty, *iter, boost::is_any_of(":"), boost::token_compress_on);
-        if (curProperty.size() != 2) return -1;
-
-        // "balance,sellreserved,acceptreserved,metadexreserved"
-        std::vector<std::string> curBalance;
-        boost::split(curBalance, curProperty[1], boost::is_any_of(","), boost::token_compress_on);
-        if (curBalance.size() != 4) return -1;
+        // "propertyid:balance,sellreserved,acceptreserved,metadexreserved"
+        int64_t nPropertyId = 0;
+        if (!parse_decimal(p, end, nPropertyId) || p == end || *p++ != ':') return -1;
+        if (nPropertyId < 0 || nPropertyId > std::numeric_limits<uint32_t>::max()) return -1;
+        const uint32_t propertyId = static_cast<uint32_t>(nPropertyId);
 
-        uint32_t propertyId = boost::lexical_cast<uint32_t>(curProperty[0]);
+        int64_t amounts[4];
+        for (int n = 0; n < 4; ++n) {
+            if (n > 0 && (p == end || *p++ != ',')) return -1;
+            if (!parse_decimal(p, end, amounts[n])) return -1;
+        }
+        if (p != end && *p != ';') return -1;
 
-        int64_t balance = boost::lexical_cast<int64_t>(curBalance[0]);
-        int64_t sellReserved = boost::lexical_cast<int64_t>(curBalance[1]);
-        int64_t acceptReserved = boost::lexical_cast<int64_t>(curBalance[2]);
-        int64_t metadexReserved = boost::lexical_cast<int64_t>(curBalance[3]);
+        // the address is usually new, so there is no previous record to replace in the state hash
+        if (!inserted.second) UpdateStateHash(tally, strAddress, propertyId, false);
+        for (int n = 0; n < 4; ++n) {
+            if (amounts[n] && tally.updateMoney(propertyId, amounts[n], tallyTypes[n])) {
+                mp_property_totals[propertyId] += amounts[n];
+            }
+        }
+        UpdateStateHash(tally, strAddress, propertyId, true);
 
-        if (balance) update_tally_map(strAddress, propertyId, balance, BALANCE);
-        if (sellReserved) update_tally_map(strAddress, propertyId, sellReserved, SELLOFFER_RESERVE);
-        if (acceptReserved) update_tally_map(strAddress, propertyId, acceptReserved, ACCEPT_RESERVE);
-        if (metadexReserved) update_tally_map(strAddress, propertyId, metadexReserved, METADEX_RESERVE);
+        int64_t held = 0;
+        for (int n = 0; n < 4; ++n) {
+            held += tally.getMoney(propertyId, tallyTypes[n]);
+        }
+        if (held != 0) mp_property_holders[propertyId].insert(CPropertyHolder(id));
     }
 
     return 0;
@@ -264,6 +360,7 @@ static int input_mp_offers_string(const std::string& s)
     CMPOffer newOffer(offerBlock, amountOriginal, prop, btcDesired, minFee, blocktimelimit, txid);
 
     if (!my_offers.insert(std::make_pair(combo, newOffer)).second) return -1;
+    UpdateStateHash(newOffer, sellerAddr, true);
 
     return 0;
 }
@@ -298,6 +395,7 @@ static int input_mp_accepts_string(const std::string& s)
     const std::string combo = STR_ACCEPT_ADDR_PROP_ADDR_COMBO(sellerAddr, buyerAddr, prop);
     CMPAccept newAccept(amountOriginal, amountRemaining, nBlock, blocktimelimit, prop, offerOriginal, btcDesired, uint256S(txidStr));
     if (my_accepts.insert(std::make_pair(combo, newAccept)).second) {
+        UpdateStateHash(newAccept, buyerAddr, true);
         return 0;
     } else {
         return -1;
@@ -366,6 +464,7 @@ static int input_mp_crowdsale_string(const std::string& s)
     if (!my_crowds.insert(std::make_pair(sellerAddr, newCrowdsale)).second) {
         return -1;
     }
+    UpdateStateHash(newCrowdsale, sellerAddr, true);
 
     return 0;
 }
@@ -399,13 +498,13 @@ static int input_mp_mdexorder_string(const std::string& s)
     return 0;
 }
 
-static int write_state_file(const CBlockIndex* pBlockIndex, int what)
+/**
+ * Renders the state of the given type in the text format, which is written to
+ * disk later.
+ */
+static int write_state_file(int what, std::string& strOut)
 {
-    fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
-    const std::string strFile = path.string();
-
-    std::ofstream file;
-    file.open(strFile.c_str());
+    std::ostringstream file;
 
     CHash256 hasher;
 
@@ -442,64 +541,591 @@ static int write_state_file(const CBlockIndex* pBlockIndex, int what)
     hasher.Finalize(hash.begin());
     file << "!" << hash.ToString() << std::endl;
 
-    file.flush();
-    file.close();
+    strOut = file.str();
     return result;
 }
 
-static void prune_state_files(const CBlockIndex* topIndex)
+/** A balance record of a binary state snapshot. */
+struct SnapshotBalance
+{
+    uint32_t propertyId;
+    int64_t balance;
+    int64_t sellReserved;
+    int64_t acceptReserved;
+    int64_t metadexReserved;
+
+    SnapshotBalance()
+      : propertyId(0), balance(0), sellReserved(0), acceptReserved(0), metadexReserved(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(propertyId);
+        READWRITE(balance);
+        READWRITE(sellReserved);
+        READWRITE(acceptReserved);
+        READWRITE(metadexReserved);
+    }
+};
+
+/** Reads serialized data from a block of memory. */
+class CSnapshotReader
 {
-    // build a set of blockHashes for which we have any state files
-    std::set<uint256> statefulBlockHashes;
+private:
+    const unsigned char* pcur;
+    const unsigned char* pend;
 
-    fs::directory_iterator dIter(pathStateFiles);
-    fs::directory_iterator endIter;
-    for (; dIter != endIter; ++dIter) {
-        std::string fName = dIter->path().empty() ? "<invalid>" : (*--dIter->path().end()).string();
-        if (false == fs::is_regular_file(dIter->status())) {
-            // skip funny business
-            PrintToLog("Non-regular file found in persistence directory : %s\n", fName);
-            continue;
+public:
+    CSnapshotReader(const unsigned char* pbegin, size_t nSize)
+      : pcur(pbegin), pend(pbegin + nSize) {}
+
+    int GetType() const { return SER_DISK; }
+    int GetVersion() const { return CLIENT_VERSION; }
+
+    bool empty() const { return pcur == pend; }
+
+    void read(char* pch, size_t nSize)
+    {
+        if (nSize > static_cast<size_t>(pend - pcur)) {
+            throw std::ios_base::failure("CSnapshotReader::read(): end of data");
         }
+        memcpy(pch, pcur, nSize);
+        pcur += nSize;
+    }
 
-        std::vector<std::string> vstr;
-        boost::split(vstr, fName, boost::is_any_of("-."), boost::token_compress_on);
-        if (vstr.size() == 3 &&
-                is_state_prefix(vstr[0]) &&
-                boost::equals(vstr[2], "dat")) {
-            uint256 blockHash;
-            blockHash.SetHex(vstr[1]);
-            statefulBlockHashes.insert(blockHash);
-        } else {
-            PrintToLog("None state file found in persistence directory : %s\n", fName);
+    template<typename T>
+    CSnapshotReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
+/** Maps a file into memory for reading, or reads it, if mapping isn't available. */
+class CMappedFile
+{
+private:
+    const unsigned char* pdata;
+    size_t nSize;
+#ifdef WIN32
+    std::vector<unsigned char> vch;
+#else
+    void* pmap;
+#endif
+
+public:
+    explicit CMappedFile(const fs::path& path)
+      : pdata(nullptr), nSize(0)
+#ifndef WIN32
+      , pmap(nullptr)
+#endif
+    {
+#ifdef WIN32
+        std::ifstream file(path.string().c_str(), std::ios::in | std::ios::binary);
+        if (!file.is_open()) return;
+        vch.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        pdata = vch.data();
+        nSize = vch.size();
+#else
+        int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                pmap = p;
+                pdata = static_cast<const unsigned char*>(p);
+                nSize = st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~CMappedFile()
+    {
+#ifndef WIN32
+        if (pmap) munmap(pmap, nSize);
+#endif
+    }
+
+    const unsigned char* data() const { return pdata; }
+    size_t size() const { return nSize; }
+};
+
+static fs::path GetSnapshotPath(const uint256& blockHash)
+{
+    return pathStateFiles / strprintf("%s-%s.%s", SNAPSHOT_PREFIX, blockHash.ToString(), SNAPSHOT_EXTENSION);
+}
+
+/**
+ * Serializes the in-memory state as binary snapshot in one pass.
+ *
+ * The snapshot consists of a header, the balances, DEx offers and accepts, the
+ * global state, crowdsales and MetaDEx orders. The double SHA256 hash of all
+ * data, which terminates the file, is added when it's written to disk.
+ */
+static void serialize_state_snapshot(const uint256& blockHash, std::vector<unsigned char>& vch)
+{
+    CVectorWriter writer(SER_DISK, CLIENT_VERSION, vch, 0);
+    writer << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << blockHash;
+
+    WriteCompactSize(writer, mp_tally_map.size());
+    std::vector<SnapshotBalance> balances;
+    for (std::unordered_map<AddressId, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        balances.clear();
+        const CMPTally& tally = it->second;
+        for (CMPTally::const_iterator pit = tally.begin(); pit != tally.end(); ++pit) {
+            SnapshotBalance record;
+            record.propertyId = pit->propertyId;
+            record.balance = pit->balance[BALANCE];
+            record.sellReserved = pit->balance[SELLOFFER_RESERVE];
+            record.acceptReserved = pit->balance[ACCEPT_RESERVE];
+            record.metadexReserved = pit->balance[METADEX_RESERVE];
+
+            if (0 == record.balance && 0 == record.sellReserved && 0 == record.acceptReserved && 0 == record.metadexReserved) {
+                continue;
+            }
+            balances.push_back(record);
+        }
+        writer << addressTable.GetAddress(it->first) << balances;
+    }
+
+    WriteCompactSize(writer, my_offers.size());
+    for (OfferMap::const_iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
+        const std::string& sellCombo = it->first;
+        writer << sellCombo.substr(0, sellCombo.find('-')) << it->second;
+    }
+
+    WriteCompactSize(writer, my_accepts.size());
+    for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
+        const std::string& acceptCombo = it->first;
+        writer << acceptCombo.substr(0, acceptCombo.find('-'));
+        writer << acceptCombo.substr(acceptCombo.find('+') + 1);
+        writer << it->second;
+    }
+
+    writer << exodus_prev;
+    writer << pDbSpInfo->peekNextSPID(COUNOS_PROPERTY_MSC);
+    writer << pDbSpInfo->peekNextSPID(COUNOS_PROPERTY_TMSC);
+
+    WriteCompactSize(writer, my_crowds.size());
+    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
+        writer << it->first << it->second;
+    }
+
+    size_t nTrades = 0;
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        for (md_PricesMap::const_iterator it = my_it->second.begin(); it != my_it->second.end(); ++it) {
+            nTrades += it->second.size();
+        }
+    }
+    WriteCompactSize(writer, nTrades);
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PricesMap& prices = my_it->second;
+        for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const md_Set& indexes = it->second;
+            for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                writer << *it;
+            }
+        }
+    }
+}
+
+/**
+ * Restores the in-memory state from the binary snapshot of the given block.
+ *
+ * The file is mapped into memory and verified against the trailing checksum,
+ * before the tally map is reserved upfront and the balances and MetaDEx orders
+ * are constructed directly, without the bookkeeping of regular updates.
+ */
+static int restore_state_snapshot(const uint256& blockHash)
+{
+    const fs::path path = GetSnapshotPath(blockHash);
+
+    CMappedFile mapped(path);
+    if (mapped.data() == nullptr) {
+        if (msc_debug_persistence) PrintToLog("%s(): snapshot %s not found\n", __func__, path.string());
+        return -1;
+    }
+
+    if (mapped.size() < sizeof(uint256)) {
+        PrintToLog("%s(): ERROR: snapshot %s is truncated\n", __func__, path.string());
+        return -1;
+    }
+
+    const size_t nPayloadSize = mapped.size() - sizeof(uint256);
+    const uint256 hash = Hash(mapped.data(), mapped.data() + nPayloadSize);
+    if (memcmp(hash.begin(), mapped.data() + nPayloadSize, sizeof(uint256)) != 0) {
+        PrintToLog("%s(): ERROR: snapshot %s failed checksum validation\n", __func__, path.string());
+        return -1;
+    }
+
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    addressTable.Clear();
+    WalletCacheMarkAllDirty();
+    my_offers.clear();
+    my_accepts.clear();
+    my_crowds.clear();
+    MetaDEx_CLEAR();
+    for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+        ClearStateHash(static_cast<StateHashPart>(part));
+    }
+
+    size_t nAddresses = 0;
+    size_t nTrades = 0;
+
+    try {
+        CSnapshotReader reader(mapped.data(), nPayloadSize);
+
+        uint32_t nMagic = 0;
+        uint32_t nVersion = 0;
+        uint256 snapshotBlockHash;
+        reader >> nMagic >> nVersion >> snapshotBlockHash;
+        if (nMagic != SNAPSHOT_MAGIC || nVersion != SNAPSHOT_VERSION || snapshotBlockHash != blockHash) {
+            PrintToLog("%s(): ERROR: snapshot %s has an unexpected header\n", __func__, path.string());
+            return -1;
+        }
+
+        nAddresses = ReadCompactSize(reader);
+        mp_tally_map.reserve(nAddresses);
+        std::string address;
+        std::vector<SnapshotBalance> balances;
+        for (size_t n = 0; n < nAddresses; ++n) {
+            reader >> address >> balances;
+            if (balances.empty()) continue;
+
+            AddressId id = addressTable.Intern(address);
+            CMPTally& tally = mp_tally_map[id];
+            for (std::vector<SnapshotBalance>::const_iterator it = balances.begin(); it != balances.end(); ++it) {
+                if (it->balance) tally.updateMoney(it->propertyId, it->balance, BALANCE);
+                if (it->sellReserved) tally.updateMoney(it->propertyId, it->sellReserved, SELLOFFER_RESERVE);
+                if (it->acceptReserved) tally.updateMoney(it->propertyId, it->acceptReserved, ACCEPT_RESERVE);
+                if (it->metadexReserved) tally.updateMoney(it->propertyId, it->metadexReserved, METADEX_RESERVE);
+
+                // only non-empty records are stored, so each one is held
+                mp_property_holders[it->propertyId].insert(CPropertyHolder(id));
+                mp_property_totals[it->propertyId] += it->balance + it->sellReserved + it->acceptReserved + it->metadexReserved;
+                UpdateStateHash(tally, address, it->propertyId, true);
+            }
+        }
+
+        size_t nOffers = ReadCompactSize(reader);
+        for (size_t n = 0; n < nOffers; ++n) {
+            std::string seller;
+            CMPOffer offer;
+            reader >> seller >> offer;
+            const std::string combo = STR_SELLOFFER_ADDR_PROP_COMBO(seller, offer.getProperty());
+            if (!my_offers.insert(std::make_pair(combo, offer)).second) return -1;
+            UpdateStateHash(offer, seller, true);
+        }
+
+        size_t nAccepts = ReadCompactSize(reader);
+        for (size_t n = 0; n < nAccepts; ++n) {
+            std::string seller;
+            std::string buyer;
+            CMPAccept accept;
+            reader >> seller >> buyer >> accept;
+            const std::string combo = STR_ACCEPT_ADDR_PROP_ADDR_COMBO(seller, buyer, accept.getProperty());
+            if (!my_accepts.insert(std::make_pair(combo, accept)).second) return -1;
+            UpdateStateHash(accept, buyer, true);
+        }
+
+        int64_t exodusPrev = 0;
+        uint32_t nextSPID = 0;
+        uint32_t nextTestSPID = 0;
+        reader >> exodusPrev >> nextSPID >> nextTestSPID;
+        exodus_prev = exodusPrev;
+        pDbSpInfo->init(nextSPID, nextTestSPID);
+
+        size_t nCrowds = ReadCompactSize(reader);
+        for (size_t n = 0; n < nCrowds; ++n) {
+            std::string issuer;
+            CMPCrowd crowd;
+            reader >> issuer >> crowd;
+            if (!my_crowds.insert(std::make_pair(issuer, crowd)).second) return -1;
+            UpdateStateHash(crowd, issuer, true);
+        }
+
+        // orders go through MetaDEx_INSERT, which indexes them and adds them to the state hash,
+        // and as they are stored in book order, its hint appends each one at the end of its set
+        nTrades = ReadCompactSize(reader);
+        for (size_t n = 0; n < nTrades; ++n) {
+            CMPMetaDEx trade;
+            reader >> trade;
+            if (!MetaDEx_INSERT(trade)) return -1;
+        }
+
+        if (!reader.empty()) {
+            PrintToLog("%s(): ERROR: snapshot %s has trailing data\n", __func__, path.string());
+            return -1;
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): ERROR: failed to read %s: %s\n", __func__, path.string(), e.what());
+        return -1;
+    }
+
+    PrintToLog("%s(%s), loaded addresses= %d, trades= %d\n", __func__, path.string(), nAddresses, nTrades);
+
+    return 0;
+}
+
+/** The serialized state of a block, which is written to disk in the background. */
+struct CStateWriteJob
+{
+    uint256 blockHash;
+    //! The binary snapshot, without the terminating hash
+    std::vector<unsigned char> vchSnapshot;
+    //! The optional text export, one file per file type
+    std::vector<std::string> vTextFiles;
+    //! Blocks, whose state is removed, once the new state is written
+    std::vector<uint256> vPrunedBlocks;
+};
+
+/**
+ * Writes the data to a temporary file, which is synced and then replaces the
+ * target, so an interrupted write never leaves a partial file behind.
+ */
+static bool write_file_atomically(const fs::path& path, const unsigned char* pch, size_t nSize)
+{
+    const fs::path pathTmp = path.string() + ".new";
+
+    FILE* file = fsbridge::fopen(pathTmp, "wb");
+    if (file == nullptr) {
+        PrintToLog("%s(): ERROR: failed to open %s\n", __func__, pathTmp.string());
+        return false;
+    }
+
+    bool fSuccess = (nSize == 0 || fwrite(pch, 1, nSize, file) == nSize);
+    fSuccess = fSuccess && FileCommit(file);
+    fclose(file);
+
+    if (!fSuccess) {
+        PrintToLog("%s(): ERROR: failed to write %s\n", __func__, pathTmp.string());
+        fs::remove(pathTmp);
+        return false;
+    }
+
+    if (!RenameOver(pathTmp, path)) {
+        PrintToLog("%s(): ERROR: failed to rename %s\n", __func__, pathTmp.string());
+        return false;
+    }
+
+    return true;
+}
+
+/** Removes the binary snapshot and text files of the given block. */
+static void remove_state_files(const uint256& blockHash)
+{
+    std::string strBlockHash = blockHash.ToString();
+    for (int i = 0; i < NUM_FILETYPES; ++i) {
+        fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], strBlockHash);
+        fs::remove(path);
+    }
+    fs::remove(GetSnapshotPath(blockHash));
+}
+
+/**
+ * Writes the serialized state and removes the state of pruned blocks.
+ *
+ * @return True, if all files of the new state were written
+ */
+static bool write_state_job(CStateWriteJob& job)
+{
+    // the hash is calculated here, so it's not done while the state is locked
+    const uint256 hash = Hash(job.vchSnapshot.begin(), job.vchSnapshot.end());
+    job.vchSnapshot.insert(job.vchSnapshot.end(), hash.begin(), hash.end());
+    bool fSuccess = write_file_atomically(GetSnapshotPath(job.blockHash), job.vchSnapshot.data(), job.vchSnapshot.size());
+
+    for (size_t i = 0; i < job.vTextFiles.size(); ++i) {
+        const std::string& strFile = job.vTextFiles[i];
+        fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], job.blockHash.ToString());
+        fSuccess &= write_file_atomically(path, reinterpret_cast<const unsigned char*>(strFile.data()), strFile.size());
+    }
+
+    for (std::vector<uint256>::const_iterator it = job.vPrunedBlocks.begin(); it != job.vPrunedBlocks.end(); ++it) {
+        remove_state_files(*it);
+    }
+
+    return fSuccess;
+}
+
+/**
+ * Writes the serialized state of blocks to disk on a background thread.
+ *
+ * The state is serialized into memory, while it's locked, so connecting blocks
+ * only waits for disk access, if MAX_PENDING_STATE_WRITES states are queued.
+ *
+ * The watermark of the SP database is set to a block, after its state was
+ * written and renamed into place.
+ */
+class CStateWriter
+{
+private:
+    Mutex cs_writer;
+    std::condition_variable condWriter;
+
+    //! States, which are waiting to be written
+    std::deque<std::shared_ptr<CStateWriteJob> > jobs;
+    //! Whether a state is currently written
+    bool fBusy;
+    //! Whether the thread should stop, once all states are written
+    bool fStop;
+
+    std::thread thread;
+
+    void ThreadWrite()
+    {
+        while (true) {
+            std::shared_ptr<CStateWriteJob> job;
+            {
+                WAIT_LOCK(cs_writer, lock);
+                while (!fStop && jobs.empty()) {
+                    condWriter.wait(lock);
+                }
+                if (jobs.empty()) return;
+                job = jobs.front();
+                jobs.pop_front();
+                fBusy = true;
+            }
+            condWriter.notify_all();
+
+            // the watermark only advances to blocks, whose state can be restored
+            if (write_state_job(*job)) {
+                pDbSpInfo->setWatermark(job->blockHash);
+            }
+
+            {
+                LOCK(cs_writer);
+                fBusy = false;
+            }
+            condWriter.notify_all();
+        }
+    }
+
+public:
+    CStateWriter() : fBusy(false), fStop(false) {}
+
+    ~CStateWriter()
+    {
+        Stop();
+    }
+
+    /** Queues the state for writing, and waits, if too many states are queued already. */
+    void Push(const std::shared_ptr<CStateWriteJob>& job)
+    {
+        {
+            WAIT_LOCK(cs_writer, lock);
+            if (!thread.joinable()) {
+                fStop = false;
+                thread = std::thread(std::bind(&TraceThread<std::function<void()> >, "counospersist",
+                        std::function<void()>(std::bind(&CStateWriter::ThreadWrite, this))));
+            }
+            while (jobs.size() >= MAX_PENDING_STATE_WRITES) {
+                condWriter.wait(lock);
+            }
+            jobs.push_back(job);
         }
+        condWriter.notify_all();
     }
 
-    // for each blockHash in the set, determine the distance from the given block
-    std::set<uint256>::const_iterator iter;
-    for (iter = statefulBlockHashes.begin(); iter != statefulBlockHashes.end(); ++iter) {
-        // look up the CBlockIndex for height info
-        CBlockIndex const *curIndex = GetBlockIndex(*iter);
+    /** Waits until all queued states are written. */
+    void Flush()
+    {
+        WAIT_LOCK(cs_writer, lock);
+        while (fBusy || !jobs.empty()) {
+            condWriter.wait(lock);
+        }
+    }
+
+    /** Writes all queued states, and joins the thread. */
+    void Stop()
+    {
+        {
+            LOCK(cs_writer);
+            fStop = true;
+        }
+        condWriter.notify_all();
+
+        if (thread.joinable()) thread.join();
+    }
+};
+
+static CStateWriter stateWriter;
+
+//! Heights of the blocks with persisted state, only accessed with cs_tally held
+static std::map<uint256, int> mapPersistedBlocks;
+//! Whether the persistence directory was scanned for the state of earlier runs
+static bool fPersistedBlocksScanned = false;
+
+/**
+ * Selects the persisted blocks, whose state is no longer needed.
+ *
+ * The persistence directory is scanned only once, and afterwards the blocks
+ * with persisted state are tracked in memory.
+ */
+static std::vector<uint256> prune_state_files(const CBlockIndex* topIndex)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_tally);
+
+    if (!fPersistedBlocksScanned) {
+        fs::directory_iterator dIter(pathStateFiles);
+        fs::directory_iterator endIter;
+        for (; dIter != endIter; ++dIter) {
+            std::string fName = dIter->path().empty() ? "<invalid>" : (*--dIter->path().end()).string();
+            if (false == fs::is_regular_file(dIter->status())) {
+                // skip funny business
+                PrintToLog("Non-regular file found in persistence directory : %s\n", fName);
+                continue;
+            }
+
+            std::vector<std::string> vstr;
+            boost::split(vstr, fName, boost::is_any_of("-."), boost::token_compress_on);
+            if (is_state_file(vstr)) {
+                uint256 blockHash;
+                blockHash.SetHex(vstr[1]);
+                // blocks, which are not in the index, are removed
+                CBlockIndex const *curIndex = GetBlockIndex(blockHash);
+                mapPersistedBlocks[blockHash] = (curIndex != nullptr) ? curIndex->nHeight : -1;
+            } else {
+                PrintToLog("None state file found in persistence directory : %s\n", fName);
+            }
+        }
+        fPersistedBlocksScanned = true;
+    }
+
+    mapPersistedBlocks[topIndex->GetBlockHash()] = topIndex->nHeight;
+
+    // for each persisted block, determine the distance from the given block
+    std::vector<uint256> vPrunedBlocks;
+    std::map<uint256, int>::iterator iter = mapPersistedBlocks.begin();
+    while (iter != mapPersistedBlocks.end()) {
+        int nHeight = iter->second;
 
         // if we have nothing int the index, or this block is too old..
-        if (nullptr == curIndex || (((topIndex->nHeight - curIndex->nHeight) > MAX_STATE_HISTORY)
-                && (curIndex->nHeight % STORE_EVERY_N_BLOCK != 0))) {
+        if (nHeight < 0 || (((topIndex->nHeight - nHeight) > MAX_STATE_HISTORY)
+                && (nHeight % STORE_EVERY_N_BLOCK != 0))) {
             if (msc_debug_persistence) {
-                if (curIndex) {
-                    PrintToLog("State from Block:%s is no longer need, removing files (age-from-tip: %d)\n", (*iter).ToString(), topIndex->nHeight - curIndex->nHeight);
+                if (nHeight >= 0) {
+                    PrintToLog("State from Block:%s is no longer need, removing files (age-from-tip: %d)\n", iter->first.ToString(), topIndex->nHeight - nHeight);
                 } else {
-                    PrintToLog("State from Block:%s is no longer need, removing files (not in index)\n", (*iter).ToString());
+                    PrintToLog("State from Block:%s is no longer need, removing files (not in index)\n", iter->first.ToString());
                 }
             }
 
-            // destroy the associated files!
-            std::string strBlockHash = iter->ToString();
-            for (int i = 0; i < NUM_FILETYPES; ++i) {
-                fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], strBlockHash);
-                fs::remove(path);
-            }
+            vPrunedBlocks.push_back(iter->first);
+            mapPersistedBlocks.erase(iter++);
+        } else {
+            ++iter;
         }
     }
+
+    return vPrunedBlocks;
 }
 
 /**
@@ -540,48 +1166,93 @@ bool IsPersistenceEnabled(int blockHeight)
 
 /**
  * Stores the in-memory state in files.
+ *
+ * The state is only serialized into memory here, and then written to disk by
+ * a background thread, after the locks are released.
  */
 int PersistInMemoryState(const CBlockIndex* pBlockIndex)
 {
-    // write the new state as of the given block
-    write_state_file(pBlockIndex, FILETYPE_BALANCES);
-    write_state_file(pBlockIndex, FILETYPE_OFFERS);
-    write_state_file(pBlockIndex, FILETYPE_ACCEPTS);
-    write_state_file(pBlockIndex, FILETYPE_GLOBALS);
-    write_state_file(pBlockIndex, FILETYPE_CROWDSALES);
-    write_state_file(pBlockIndex, FILETYPE_MDEXORDERS);
+    static const bool fTextExport = gArgs.GetBoolArg("-counospersisttext", false);
+
+    std::shared_ptr<CStateWriteJob> job = std::make_shared<CStateWriteJob>();
+    job->blockHash = pBlockIndex->GetBlockHash();
+
+    // serialize the new state as of the given block
+    serialize_state_snapshot(job->blockHash, job->vchSnapshot);
 
-    // clean-up the directory
-    prune_state_files(pBlockIndex);
+    // optionally export the state in the text format
+    if (fTextExport) {
+        job->vTextFiles.resize(NUM_FILETYPES);
+        for (int i = 0; i < NUM_FILETYPES; ++i) {
+            write_state_file(i, job->vTextFiles[i]);
+        }
+    }
 
-    pDbSpInfo->setWatermark(pBlockIndex->GetBlockHash());
+    // clean-up the directory, once the new state is written
+    job->vPrunedBlocks = prune_state_files(pBlockIndex);
+
+    // the watermark is updated by the writer, once the state is on disk
+    stateWriter.Push(job);
 
     return 0;
 }
 
+/**
+ * Waits until the state of all blocks is written to disk.
+ */
+void FlushStatePersistence()
+{
+    stateWriter.Flush();
+}
+
+/**
+ * Writes the remaining state to disk, and stops the background writer.
+ */
+void StopStatePersistence()
+{
+    stateWriter.Stop();
+
+    // the directory may be changed before the next start
+    LOCK(cs_tally);
+    mapPersistedBlocks.clear();
+    fPersistedBlocksScanned = false;
+}
+
 /**
  * Loads and retrieves state from a file.
+ *
+ * The whole file is mapped into memory and split into lines, which are parsed
+ * in place. Large files are hashed by a separate thread in the meantime, and
+ * balances are loaded into a tally map, which is sized for all addresses.
  */
 int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
 {
     int lines = 0;
     int (*inputLineFunc)(const std::string&) = nullptr;
+    int (*inputBufferFunc)(const char*, const char*) = nullptr;
 
     CHash256 hasher;
 
     switch (what) {
         case FILETYPE_BALANCES:
             mp_tally_map.clear();
-            inputLineFunc = input_msc_balances_string;
+            mp_property_holders.clear();
+            mp_property_totals.clear();
+            addressTable.Clear();
+            WalletCacheMarkAllDirty();
+            ClearStateHash(STATEHASH_BALANCES);
+            inputBufferFunc = input_msc_balances_buffer;
             break;
 
         case FILETYPE_OFFERS:
             my_offers.clear();
+            ClearStateHash(STATEHASH_DEX_OFFERS);
             inputLineFunc = input_mp_offers_string;
             break;
 
         case FILETYPE_ACCEPTS:
             my_accepts.clear();
+            ClearStateHash(STATEHASH_DEX_ACCEPTS);
             inputLineFunc = input_mp_accepts_string;
             break;
 
@@ -591,15 +1262,13 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
 
         case FILETYPE_CROWDSALES:
             my_crowds.clear();
+            ClearStateHash(STATEHASH_CROWDSALES);
             inputLineFunc = input_mp_crowdsale_string;
             break;
 
         case FILETYPE_MDEXORDERS:
-            // FIXME
-            // memory leak ... gotta unallocate inner layers first....
-            // TODO
-            // ...
-            metadex.clear();
+            MetaDEx_CLEAR();
+            ClearStateHash(STATEHASH_METADEX);
             inputLineFunc = input_mp_mdexorder_string;
             break;
 
@@ -612,46 +1281,80 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
         PrintToLog("%s(%s), line %d, file: %s\n", __FUNCTION__, filename, __LINE__, __FILE__);
     }
 
-    std::ifstream file;
-    file.open(filename.c_str());
-    if (!file.is_open()) {
+    const fs::path path(filename);
+    CMappedFile mapped(path);
+    if (mapped.data() == nullptr && !fs::exists(path)) {
         if (msc_debug_persistence) LogPrintf("%s(%s): file not found, line %d, file: %s\n", __FUNCTION__, filename, __LINE__, __FILE__);
         return -1;
     }
 
     int res = 0;
 
+    // split the file into lines, and record and skip hashes in the file
+    const char* pbegin = reinterpret_cast<const char*>(mapped.data());
+    const char* pend = pbegin + mapped.size();
+    std::vector<std::pair<const char*, const char*> > vLines;
     std::string fileHash;
-    while (file.good()) {
-        std::string line;
-        std::getline(file, line);
-        if (line.empty() || line[0] == '#') continue;
+    for (const char* p = pbegin; p < pend; ) {
+        const char* pnext = std::find(p, pend, '\n');
+        const char* pline = p;
+        const char* pline_end = pnext;
+        p = (pnext == pend) ? pend : pnext + 1;
 
         // remove \r if the file came from Windows
-        line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+        if (pline_end != pline && *(pline_end - 1) == '\r') --pline_end;
+        if (pline == pline_end || *pline == '#') continue;
 
-        // record and skip hashes in the file
-        if (line[0] == '!') {
-            fileHash = line.substr(1);
+        if (*pline == '!') {
+            fileHash.assign(pline + 1, pline_end);
             continue;
         }
 
-        // update hash?
-        if (verifyHash) {
-            hasher.Write((unsigned char*)line.c_str(), line.length());
+        vLines.push_back(std::make_pair(pline, pline_end));
+    }
+
+    if (what == FILETYPE_BALANCES) {
+        mp_tally_map.reserve(vLines.size());
+    }
+
+    // the hash covers all lines in order, so it can't be split, but it can be calculated alongside parsing
+    auto hashLines = [&hasher, &vLines]() {
+        for (std::vector<std::pair<const char*, const char*> >::const_iterator it = vLines.begin(); it != vLines.end(); ++it) {
+            hasher.Write(reinterpret_cast<const unsigned char*>(it->first), it->second - it->first);
+        }
+    };
+    std::thread hashThread;
+    if (verifyHash) {
+        if (mapped.size() >= MIN_PARALLEL_HASH_SIZE) {
+            hashThread = std::thread(hashLines);
+        } else {
+            hashLines();
         }
+    }
 
-        if (inputLineFunc) {
-            if (inputLineFunc(line) < 0) {
-                res = -1;
-                break;
+    for (std::vector<std::pair<const char*, const char*> >::const_iterator it = vLines.begin(); it != vLines.end(); ++it) {
+        try {
+            if (inputBufferFunc) {
+                res = inputBufferFunc(it->first, it->second);
+            } else if (inputLineFunc) {
+                res = inputLineFunc(std::string(it->first, it->second));
             }
+        } catch (const std::exception& e) {
+            // the hashing thread must be joined, before leaving
+            PrintToLog("%s(%s): ERROR: failed to parse line %d: %s\n", __FUNCTION__, filename, lines + 1, e.what());
+            res = -1;
+        }
+        if (res < 0) {
+            res = -1;
+            break;
         }
 
         ++lines;
     }
 
-    file.close();
+    if (hashThread.joinable()) {
+        hashThread.join();
+    }
 
     if (verifyHash && res == 0) {
         // generate and write the double hash of all the contents written
@@ -675,6 +1378,9 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
  */
 int LoadMostRelevantInMemoryState()
 {
+    // the state of the latest blocks may still be written
+    FlushStatePersistence();
+
     int res = -1;
     uint256 spWatermark;
     {
@@ -712,7 +1418,7 @@ int LoadMostRelevantInMemoryState()
             std::string fName = (*--dIter->path().end()).string();
             std::vector<std::string> vstr;
             boost::split(vstr, fName, boost::is_any_of("-."), boost::token_compress_on);
-            if (vstr.size() == 3 && boost::equals(vstr[2], "dat")) {
+            if (is_state_file(vstr)) {
                 uint256 blockHash;
                 blockHash.SetHex(vstr[1]);
                 CBlockIndex *pBlockIndex = GetBlockIndex(blockHash);
@@ -770,8 +1476,7 @@ int LoadMostRelevantInMemoryState()
             std::string fName = (*--dIter->path().end()).string();
             std::vector<std::string> vstr;
             boost::split(vstr, fName, boost::is_any_of("-."), boost::token_compress_on);
-            if (vstr.size() == 3 &&
-                    boost::equals(vstr[2], "dat")) {
+            if (is_state_file(vstr)) {
                 uint256 blockHash;
                 blockHash.SetHex(vstr[1]);
                 CBlockIndex *pBlockIndex = GetBlockIndex(blockHash);
@@ -797,16 +1502,19 @@ int LoadMostRelevantInMemoryState()
         }
         while (nullptr != curTip && persistedBlocks.size() > 0 && curTip->nHeight > abortRollBackBlock ) {
             if (persistedBlocks.find(curTip->GetBlockHash()) != persistedBlocks.end()) {
-                int success = -1;
-                for (int i = 0; i < NUM_FILETYPES; ++i) {
-                    fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
-                    const std::string strFile = path.string();
-                    success = RestoreInMemoryState(strFile, i, true);
-                    if (success < 0) {
-                        PrintToConsole("Found a state inconsistency at block height %d. "
-                                "Reverting up to %d blocks.. this may take a few minutes.\n",
-                                curTip->nHeight, (curTip->nHeight - abortRollBackBlock - 1));
-                        break;
+                // prefer the binary snapshot, and fall back to the text files
+                int success = restore_state_snapshot(curTip->GetBlockHash());
+                if (success < 0) {
+                    for (int i = 0; i < NUM_FILETYPES; ++i) {
+                        fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
+                        const std::string strFile = path.string();
+                        success = RestoreInMemoryState(strFile, i, true);
+                        if (success < 0) {
+                            PrintToConsole("Found a state inconsistency at block height %d. "
+                                    "Reverting up to %d blocks.. this may take a few minutes.\n",
+                                    curTip->nHeight, (curTip->nHeight - abortRollBackBlock - 1));
+                            break;
+                        }
                     }
                 }
 
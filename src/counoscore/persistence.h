@@ -11,6 +11,12 @@ bool IsPersistenceEnabled(int blockHeight);
 /** Stores the in-memory state in files. */
 int PersistInMemoryState(const CBlockIndex* pBlockIndex);
 
+/** Waits until the state of all blocks is written to disk. */
+void FlushStatePersistence();
+
+/** Writes the remaining state to disk, and stops the background writer. */
+void StopStatePersistence();
+
 /** Loads and retrieves state from a file. */
 int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash = false);
 
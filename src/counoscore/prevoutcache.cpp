@@ -0,0 +1,97 @@
+/**
+ * @file prevoutcache.cpp
+ *
+ * This file contains the cache of outputs spent by Counos transactions.
+ */
+
+#include <counoscore/prevoutcache.h>
+
+#include <coins.h>
+#include <primitives/transaction.h>
+
+#include <stddef.h>
+
+CPrevoutCache::CPrevoutCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn), nHits(0), nMisses(0)
+{
+}
+
+/**
+ * Retrieves a coin, and marks it as recently used.
+ */
+bool CPrevoutCache::Get(const COutPoint& outpoint, Coin& coin)
+{
+    std::unordered_map<COutPoint, EntryList::iterator, SaltedOutpointHasher>::iterator it = mapEntries.find(outpoint);
+    if (it == mapEntries.end()) {
+        ++nMisses;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    coin = it->second->second;
+    ++nHits;
+
+    return true;
+}
+
+/**
+ * Adds a coin, and evicts the least recently used coins, if the cache is full.
+ */
+void CPrevoutCache::Add(const COutPoint& outpoint, const Coin& coin)
+{
+    if (nMaxSize == 0) return;
+
+    std::unordered_map<COutPoint, EntryList::iterator, SaltedOutpointHasher>::iterator it = mapEntries.find(outpoint);
+    if (it != mapEntries.end()) {
+        it->second->second = coin;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    entries.push_front(std::make_pair(outpoint, coin));
+    mapEntries.emplace(outpoint, entries.begin());
+
+    while (entries.size() > nMaxSize) {
+        mapEntries.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+/**
+ * Removes all coins, which were created at or above the given height.
+ *
+ * Used when blocks are disconnected, as the transactions of those blocks may not
+ * be part of the chain anymore.
+ */
+void CPrevoutCache::RemoveAbove(int nHeight)
+{
+    EntryList::iterator it = entries.begin();
+    while (it != entries.end()) {
+        if (static_cast<int>(it->second.nHeight) >= nHeight) {
+            mapEntries.erase(it->first);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Removes all coins.
+ */
+void CPrevoutCache::Clear()
+{
+    mapEntries.clear();
+    entries.clear();
+}
+
+/**
+ * Sets the maximum number of entries, and evicts coins, if necessary.
+ */
+void CPrevoutCache::SetMaxSize(size_t nMaxSizeIn)
+{
+    nMaxSize = nMaxSizeIn;
+    while (entries.size() > nMaxSize) {
+        mapEntries.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef COUNOSH_COUNOSCORE_PREVOUTCACHE_H
+#define COUNOSH_COUNOSCORE_PREVOUTCACHE_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/** Bounded least-recently-used cache of the outputs spent by Counos transactions.
+ *
+ * The cache holds the coins, which are needed to identify the sender of a
+ * transaction. It outlives the coins view cache, which is flushed entirely,
+ * once it grows too large, so repeated lookups of the same funding transactions
+ * don't hit the transaction index again.
+ */
+class CPrevoutCache
+{
+private:
+    typedef std::list<std::pair<COutPoint, Coin> > EntryList;
+
+    //! Entries, with the most recently used entry first
+    EntryList entries;
+    //! Position of the entries in the list
+    std::unordered_map<COutPoint, EntryList::iterator, SaltedOutpointHasher> mapEntries;
+    //! Maximum number of entries
+    size_t nMaxSize;
+    //! Number of successful lookups
+    uint64_t nHits;
+    //! Number of failed lookups
+    uint64_t nMisses;
+
+public:
+    explicit CPrevoutCache(size_t nMaxSizeIn);
+
+    /** Retrieves a coin, and marks it as recently used. */
+    bool Get(const COutPoint& outpoint, Coin& coin);
+
+    /** Adds a coin, and evicts the least recently used coins, if the cache is full. */
+    void Add(const COutPoint& outpoint, const Coin& coin);
+
+    /** Removes all coins, which were created at or above the given height. */
+    void RemoveAbove(int nHeight);
+
+    /** Removes all coins. */
+    void Clear();
+
+    /** Sets the maximum number of entries. */
+    void SetMaxSize(size_t nMaxSizeIn);
+
+    size_t GetSize() const { return entries.size(); }
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetMisses() const { return nMisses; }
+};
+
+#endif // COUNOSH_COUNOSCORE_PREVOUTCACHE_H
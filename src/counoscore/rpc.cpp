@@ -7,6 +7,7 @@
 #include <counoscore/rpc.h>
 
 #include <counoscore/activation.h>
+#include <counoscore/addressindex.h>
 #include <counoscore/consensushash.h>
 #include <counoscore/convert.h>
 #include <counoscore/dbfees.h>
@@ -59,10 +60,15 @@
 #include <univalue.h>
 
 #include <stdint.h>
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <stdexcept>
 #include <string>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/algorithm/string.hpp> // boost::split
 
@@ -149,13 +155,9 @@ void MetaDexObjectsToJSON(std::vector<CMPMetaDEx>& vMetaDexObjs, UniValue& respo
     }
 }
 
-bool BalanceToJSON(const std::string& address, uint32_t property, UniValue& balance_obj, bool divisible)
+/** Adds the given amounts to the balance object. */
+static void BalanceAmountsToJSON(int64_t nAvailable, int64_t nReserved, int64_t nFrozen, UniValue& balance_obj, bool divisible)
 {
-    // confirmed balance minus unconfirmed, spent amounts
-    int64_t nAvailable = GetAvailableTokenBalance(address, property);
-    int64_t nReserved = GetReservedTokenBalance(address, property);
-    int64_t nFrozen = GetFrozenTokenBalance(address, property);
-
     if (divisible) {
         balance_obj.pushKV("balance", FormatDivisibleMP(nAvailable));
         balance_obj.pushKV("reserved", FormatDivisibleMP(nReserved));
@@ -165,10 +167,40 @@ bool BalanceToJSON(const std::string& address, uint32_t property, UniValue& bala
         balance_obj.pushKV("reserved", FormatIndivisibleMP(nReserved));
         balance_obj.pushKV("frozen", FormatIndivisibleMP(nFrozen));
     }
+}
+
+bool BalanceToJSON(const std::string& address, uint32_t property, UniValue& balance_obj, bool divisible)
+{
+    // confirmed balance minus unconfirmed, spent amounts
+    int64_t nAvailable = GetAvailableTokenBalance(address, property);
+    int64_t nReserved = GetReservedTokenBalance(address, property);
+    int64_t nFrozen = GetFrozenTokenBalance(address, property);
+
+    BalanceAmountsToJSON(nAvailable, nReserved, nFrozen, balance_obj, divisible);
 
     return (nAvailable || nReserved || nFrozen);
 }
 
+/** Parses the maximum number of entries per page; zero returns all entries at once. */
+static uint32_t ParsePageLimit(const UniValue& value)
+{
+    if (value.isNull()) return 0;
+    int64_t limit = value.get_int64();
+    if (limit < 0 || limit > std::numeric_limits<uint32_t>::max()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is out of range");
+    }
+    return static_cast<uint32_t>(limit);
+}
+
+/** Wraps one page of entries; the cursor of the next page is empty once all entries were returned. */
+static UniValue PageToJSON(const UniValue& results, const std::string& cursor)
+{
+    UniValue page(UniValue::VOBJ);
+    page.pushKV("results", results);
+    page.pushKV("cursor", cursor);
+    return page;
+}
+
 // display the non-fungible tokens owned by an address for a property
 UniValue counos_getnonfungibletokens(const JSONRPCRequest& request)
 {
@@ -888,8 +920,8 @@ static UniValue mscrpc(const JSONRPCRequest& request)
             LOCK(cs_tally);
             int64_t total = 0;
             // display all balances
-            for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-                PrintToConsole("%34s => ", my_it->first);
+            for (std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+                PrintToConsole("%34s => ", addressTable.GetAddress(my_it->first));
                 total += (my_it->second).print(extra2, bDivisible);
             }
             PrintToConsole("total for property %d  = %X is %s\n", extra2, extra2, FormatDivisibleMP(total));
@@ -915,8 +947,8 @@ static UniValue mscrpc(const JSONRPCRequest& request)
             LOCK(cs_tally);
             uint32_t id = 0;
             // for each address display all currencies it holds
-            for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-                PrintToConsole("%34s => ", my_it->first);
+            for (std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+                PrintToConsole("%34s => ", addressTable.GetAddress(my_it->first));
                 (my_it->second).print(extra2);
                 (my_it->second).init();
                 while (0 != (id = (my_it->second).next())) {
@@ -1067,11 +1099,16 @@ static UniValue counos_getbalance(const JSONRPCRequest& request)
 static UniValue counos_getallbalancesforid(const JSONRPCRequest& request)
 {
     RPCHelpMan{"counos_getallbalancesforid",
-       "\nReturns a list of token balances for a given currency or property identifier.\n",
+       "\nReturns a list of token balances for a given currency or property identifier.\n"
+       "\nThe balances are ordered by address. With a limit, one page of balances is returned, and the\n"
+       "returned cursor is used to continue with the next page.\n",
        {
            {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, "the property identifier"},
+           {"cursor", RPCArg::Type::STR, /* default */ "\"\"", "the cursor returned with the previous page, or the address to start at"},
+           {"limit", RPCArg::Type::NUM, /* default */ "0", "the maximum number of balances to return, or 0 for all of them"},
        },
-       RPCResult{
+       RPCResults{
+           RPCResult{"for limit = 0",
            RPCResult::Type::ARR, "", "",
            {
                {RPCResult::Type::OBJ, "", "",
@@ -1081,46 +1118,71 @@ static UniValue counos_getallbalancesforid(const JSONRPCRequest& request)
                    {RPCResult::Type::STR_AMOUNT, "reserved", "the amount reserved by sell offers and accepts"},
                    {RPCResult::Type::STR_AMOUNT, "frozen", "the amount frozen by the issuer (applies to managed properties only)"},
                }},
-           }
+           }},
+           RPCResult{"for limit > 0",
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::ARR, "results", "the balances of this page, as above",
+               {
+                   {RPCResult::Type::ELISION, "", ""},
+               }},
+               {RPCResult::Type::STR, "cursor", "the cursor of the next page, or empty, if there are no more balances"},
+           }},
        },
        RPCExamples{
            HelpExampleCli("counos_getallbalancesforid", "1")
+           + HelpExampleCli("counos_getallbalancesforid", "1 \"\" 100")
            + HelpExampleRpc("counos_getallbalancesforid", "1")
        }
     }.Check(request);
 
     uint32_t propertyId = ParsePropertyId(request.params[0]);
+    std::string cursor = request.params[1].isNull() ? "" : request.params[1].get_str();
+    uint32_t limit = ParsePageLimit(request.params[2]);
 
     RequireExistingProperty(propertyId);
 
-    UniValue response(UniValue::VARR);
     bool isDivisible = isPropertyDivisible(propertyId); // we want to check this BEFORE the loop
 
-    LOCK(cs_tally);
-
-    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-        uint32_t id = 0;
-        bool includeAddress = false;
-        std::string address = it->first;
-        (it->second).init();
-        while (0 != (id = (it->second).next())) {
-            if (id == propertyId) {
-                includeAddress = true;
-                break;
+    // the holders are ordered by address, so a page starts at the cursor, and only the balances
+    // of the page are collected with the lock held
+    struct HolderBalance { std::string address; int64_t nAvailable; int64_t nReserved; int64_t nFrozen; };
+    std::vector<HolderBalance> balances;
+    std::string nextCursor;
+    {
+        LOCK(cs_tally);
+        std::unordered_map<uint32_t, PropertyHolderSet>::const_iterator itHolders = mp_property_holders.find(propertyId);
+        if (itHolders != mp_property_holders.end()) {
+            PropertyHolderSet::const_iterator it = itHolders->second.lower_bound(CPropertyHolder(cursor));
+            for (; it != itHolders->second.end(); ++it) {
+                if (limit > 0 && balances.size() >= limit) {
+                    nextCursor = *it->address;
+                    break;
+                }
+                // confirmed balance minus unconfirmed, spent amounts
+                HolderBalance balance;
+                balance.address = *it->address;
+                balance.nAvailable = GetAvailableTokenBalance(balance.address, propertyId);
+                balance.nReserved = GetReservedTokenBalance(balance.address, propertyId);
+                balance.nFrozen = GetFrozenTokenBalance(balance.address, propertyId);
+
+                if (balance.nAvailable || balance.nReserved || balance.nFrozen) {
+                    balances.push_back(balance);
+                }
             }
         }
-        if (!includeAddress) {
-            continue; // ignore this address, has never transacted in this propertyId
-        }
-        UniValue balanceObj(UniValue::VOBJ);
-        balanceObj.pushKV("address", address);
-        bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible);
+    }
 
-        if (nonEmptyBalance) {
-            response.push_back(balanceObj);
-        }
+    UniValue response(UniValue::VARR);
+    for (std::vector<HolderBalance>::const_iterator it = balances.begin(); it != balances.end(); ++it) {
+        UniValue balanceObj(UniValue::VOBJ);
+        balanceObj.pushKV("address", it->address);
+        BalanceAmountsToJSON(it->nAvailable, it->nReserved, it->nFrozen, balanceObj, isDivisible);
+        response.push_back(balanceObj);
     }
 
+    if (limit > 0) return PageToJSON(response, nextCursor);
+
     return response;
 }
 
@@ -1476,9 +1538,14 @@ static UniValue counos_getproperty(const JSONRPCRequest& request)
 static UniValue counos_listproperties(const JSONRPCRequest& request)
 {
     RPCHelpMan{"counos_listproperties",
-       "\nLists all tokens or smart properties. To get the total number of tokens, please use counos_getproperty.\n",
-       {},
-       RPCResult{
+       "\nLists all tokens or smart properties. To get the total number of tokens, please use counos_getproperty.\n"
+       "\nWith a limit, one page of tokens is returned, and the returned cursor is used to continue with the next page.\n",
+       {
+           {"cursor", RPCArg::Type::STR, /* default */ "\"\"", "the cursor returned with the previous page, or the property identifier to start at"},
+           {"limit", RPCArg::Type::NUM, /* default */ "0", "the maximum number of tokens to return, or 0 for all of them"},
+       },
+       RPCResults{
+           RPCResult{"for limit = 0",
            RPCResult::Type::ARR, "", "",
            {
                {RPCResult::Type::OBJ, "", "",
@@ -1495,42 +1562,69 @@ static UniValue counos_listproperties(const JSONRPCRequest& request)
                     {RPCResult::Type::BOOL, "fixedissuance", "whether the token supply is fixed"},
                     {RPCResult::Type::BOOL, "managedissuance", "whether the token supply is managed"},
                }},
-           }
+           }},
+           RPCResult{"for limit > 0",
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::ARR, "results", "the tokens of this page, as above",
+               {
+                   {RPCResult::Type::ELISION, "", ""},
+               }},
+               {RPCResult::Type::STR, "cursor", "the cursor of the next page, or empty, if there are no more tokens"},
+           }},
        },
        RPCExamples{
            HelpExampleCli("counos_listproperties", "")
+           + HelpExampleCli("counos_listproperties", "\"\" 100")
            + HelpExampleRpc("counos_listproperties", "")
        }
     }.Check(request);
 
-    UniValue response(UniValue::VARR);
-
-    LOCK(cs_tally);
+    uint32_t startId = 1;
+    if (!request.params[0].isNull() && !request.params[0].get_str().empty()) {
+        if (!ParseUInt32(request.params[0].get_str(), &startId)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+    }
+    uint32_t limit = ParsePageLimit(request.params[1]);
 
-    uint32_t nextSPID = pDbSpInfo->peekNextSPID(1);
-    for (uint32_t propertyId = 1; propertyId < nextSPID; propertyId++) {
-        CMPSPInfo::Entry sp;
-        if (pDbSpInfo->getSP(propertyId, sp)) {
-            UniValue propertyObj(UniValue::VOBJ);
-            propertyObj.pushKV("propertyid", (uint64_t) propertyId);
-            PropertyToJSON(sp, propertyObj); // name, category, subcategory, ...
+    // the entries are copied, so the lock isn't held while the response is built
+    std::vector<std::pair<uint32_t, CMPSPInfo::Entry> > properties;
+    uint32_t nextId = 0;
+    {
+        LOCK(cs_tally);
 
-            response.push_back(propertyObj);
+        uint32_t nextSPID = pDbSpInfo->peekNextSPID(1);
+        uint32_t nextTestSPID = pDbSpInfo->peekNextSPID(2);
+        for (uint32_t propertyId = std::max(startId, 1U); propertyId < nextTestSPID; propertyId++) {
+            // continue with the test ecosystem, once the main ecosystem is done
+            if (propertyId >= nextSPID && propertyId < TEST_ECO_PROPERTY_1) {
+                propertyId = TEST_ECO_PROPERTY_1;
+                if (propertyId >= nextTestSPID) break;
+            }
+            if (limit > 0 && properties.size() >= limit) {
+                nextId = propertyId;
+                break;
+            }
+            CMPSPInfo::Entry sp;
+            if (pDbSpInfo->getSP(propertyId, sp)) {
+                properties.emplace_back(propertyId, sp);
+            }
         }
     }
 
-    uint32_t nextTestSPID = pDbSpInfo->peekNextSPID(2);
-    for (uint32_t propertyId = TEST_ECO_PROPERTY_1; propertyId < nextTestSPID; propertyId++) {
-        CMPSPInfo::Entry sp;
-        if (pDbSpInfo->getSP(propertyId, sp)) {
-            UniValue propertyObj(UniValue::VOBJ);
-            propertyObj.pushKV("propertyid", (uint64_t) propertyId);
-            PropertyToJSON(sp, propertyObj); // name, category, subcategory, ...
+    UniValue response(UniValue::VARR);
 
-            response.push_back(propertyObj);
-        }
+    for (std::vector<std::pair<uint32_t, CMPSPInfo::Entry> >::const_iterator it = properties.begin(); it != properties.end(); ++it) {
+        UniValue propertyObj(UniValue::VOBJ);
+        propertyObj.pushKV("propertyid", (uint64_t) it->first);
+        PropertyToJSON(it->second, propertyObj); // name, category, subcategory, ...
+
+        response.push_back(propertyObj);
     }
 
+    if (limit > 0) return PageToJSON(response, nextId ? strprintf("%d", nextId) : "");
+
     return response;
 }
 
@@ -1859,15 +1953,26 @@ static UniValue counos_getgrants(const JSONRPCRequest& request)
     return response;
 }
 
+/** Returns the cursor, which continues the order book with the given order. */
+static std::string OrderBookCursor(const CMPMetaDEx& obj)
+{
+    const price_t price = obj.unitPrice();
+    return strprintf("%d:%d:%d:%d:%d", obj.getDesProperty(), price.numerator(), price.denominator(), obj.getBlock(), obj.getIdx());
+}
+
 static UniValue counos_getorderbook(const JSONRPCRequest& request)
 {
     RPCHelpMan{"counos_getorderbook",
-       "\nList active offers on the distributed token exchange.\n",
+       "\nList active offers on the distributed token exchange.\n"
+       "\nWith a limit, one page of offers is returned, and the returned cursor is used to continue with the next page.\n",
        {
            {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, "filter orders by property identifier for sale"},
            {"propertyiddesired", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "filter orders by property identifier desired"},
+           {"cursor", RPCArg::Type::STR, /* default */ "\"\"", "the cursor returned with the previous page"},
+           {"limit", RPCArg::Type::NUM, /* default */ "0", "the maximum number of offers to return, or 0 for all of them"},
        },
-       RPCResult{
+       RPCResults{
+           RPCResult{"for limit = 0",
            RPCResult::Type::ARR, "", "",
            {
                {RPCResult::Type::OBJ, "", "",
@@ -1887,17 +1992,28 @@ static UniValue counos_getorderbook(const JSONRPCRequest& request)
                     {RPCResult::Type::NUM, "block", "the index of the block that contains the transaction"},
                     {RPCResult::Type::NUM, "blocktime", "the timestamp of the block that contains the transaction"},
                }},
-           }
+           }},
+           RPCResult{"for limit > 0",
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::ARR, "results", "the offers of this page, as above",
+               {
+                   {RPCResult::Type::ELISION, "", ""},
+               }},
+               {RPCResult::Type::STR, "cursor", "the cursor of the next page, or empty, if there are no more offers"},
+           }},
        },
        RPCExamples{
            HelpExampleCli("counos_getorderbook", "2")
+           + HelpExampleCli("counos_getorderbook", "2 null \"\" 100")
            + HelpExampleRpc("counos_getorderbook", "2")
        }
     }.Check(request);
 
-    bool filterDesired = (request.params.size() > 1);
+    bool filterDesired = !request.params[1].isNull();
     uint32_t propertyIdForSale = ParsePropertyId(request.params[0]);
     uint32_t propertyIdDesired = 0;
+    uint32_t limit = ParsePageLimit(request.params[3]);
 
     RequireExistingProperty(propertyIdForSale);
 
@@ -1909,17 +2025,49 @@ static UniValue counos_getorderbook(const JSONRPCRequest& request)
         RequireDifferentIds(propertyIdForSale, propertyIdDesired);
     }
 
+    // the cursor is the position of the first order of the page: desired property, price, block and index
+    bool fCursor = false;
+    uint32_t cursorDesired = 0;
+    int64_t cursorNumerator = 0;
+    int64_t cursorDenominator = 1;
+    int cursorBlock = 0;
+    uint32_t cursorIdx = 0;
+    if (!request.params[2].isNull() && !request.params[2].get_str().empty()) {
+        std::vector<std::string> vstr;
+        boost::split(vstr, request.params[2].get_str(), boost::is_any_of(":"));
+        if (vstr.size() != 5 || !ParseUInt32(vstr[0], &cursorDesired) || !ParseInt64(vstr[1], &cursorNumerator) ||
+                !ParseInt64(vstr[2], &cursorDenominator) || cursorDenominator <= 0 || !ParseInt32(vstr[3], &cursorBlock) ||
+                !ParseUInt32(vstr[4], &cursorIdx)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        fCursor = true;
+    }
+    const price_t cursorPrice(cursorNumerator, cursorDenominator);
+
     std::vector<CMPMetaDEx> vecMetaDexObjects;
+    std::string nextCursor;
     {
         LOCK(cs_tally);
-        for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        // the order books of all pairs with the property for sale are adjacent
+        uint32_t firstDesired = filterDesired ? propertyIdDesired : 0;
+        if (fCursor) firstDesired = std::max(firstDesired, cursorDesired);
+        md_PropertiesMap::const_iterator my_it = metadex.lower_bound(md_PropertyPair(propertyIdForSale, firstDesired));
+        for (; my_it != metadex.end() && my_it->first.first == propertyIdForSale && nextCursor.empty(); ++my_it) {
+            if (filterDesired && my_it->first.second != propertyIdDesired) break;
             const md_PricesMap& prices = my_it->second;
-            for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const bool fCursorPair = fCursor && my_it->first.second == cursorDesired;
+            md_PricesMap::const_iterator it = fCursorPair ? prices.lower_bound(cursorPrice) : prices.begin();
+            for (; it != prices.end() && nextCursor.empty(); ++it) {
+                const bool fCursorPrice = fCursorPair && it->first == cursorPrice;
                 const md_Set& indexes = it->second;
-                for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                    const CMPMetaDEx& obj = *it;
-                    if (obj.getProperty() != propertyIdForSale) continue;
-                    if (!filterDesired || obj.getDesProperty() == propertyIdDesired) vecMetaDexObjects.push_back(obj);
+                for (md_Set::const_iterator obj = indexes.begin(); obj != indexes.end(); ++obj) {
+                    // orders at the price of the cursor, which were on earlier pages, are skipped
+                    if (fCursorPrice && (obj->getBlock() < cursorBlock || (obj->getBlock() == cursorBlock && obj->getIdx() < cursorIdx))) continue;
+                    if (limit > 0 && vecMetaDexObjects.size() >= limit) {
+                        nextCursor = OrderBookCursor(*obj);
+                        break;
+                    }
+                    vecMetaDexObjects.push_back(*obj);
                 }
             }
         }
@@ -1927,6 +2075,9 @@ static UniValue counos_getorderbook(const JSONRPCRequest& request)
 
     UniValue response(UniValue::VARR);
     MetaDexObjectsToJSON(vecMetaDexObjects, response);
+
+    if (limit > 0) return PageToJSON(response, nextCursor);
+
     return response;
 }
 
@@ -2342,6 +2493,102 @@ static UniValue counos_gettransaction(const JSONRPCRequest& request)
     return txobj;
 }
 
+static UniValue counos_listaddresstransactions(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"counos_listaddresstransactions",
+       "\nLists the Counos transactions of any address, ordered by block and position in the block.\n"
+       "\nThe transactions are looked up with the address index, which requires -counosaddressindex. "
+       "Transactions are listed, if the address is the sender or reference, a Send To Many receiver, "
+       "a Send To Owners recipient, or the counterparty of a matched trade.\n"
+       "\nOne page of transactions is returned, and the returned cursor is used to continue with the next page.\n",
+       {
+           {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "the address to look up"},
+           {"startblock", RPCArg::Type::NUM, /* default */ "0", "first block to begin the search"},
+           {"endblock", RPCArg::Type::NUM, /* default */ "999999999", "last block to include in the search"},
+           {"cursor", RPCArg::Type::STR, /* default */ "\"\"", "the cursor returned with the previous page"},
+           {"limit", RPCArg::Type::NUM, /* default */ "100", "the maximum number of transactions to return, at most 1000"},
+       },
+       RPCResult{
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::ARR, "results", "",
+               {
+                   {RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::STR_HEX, "txid", "the hex-encoded hash of the transaction"},
+                       {RPCResult::Type::STR, "sendingaddress", "the CounosH address of the sender"},
+                       {RPCResult::Type::STR, "referenceaddress", "a CounosH address used as reference (if any)"},
+                       {RPCResult::Type::BOOL, "ismine", "whether the transaction involes an address in the wallet"},
+                       {RPCResult::Type::NUM, "confirmations", "the number of transaction confirmations"},
+                       {RPCResult::Type::STR_AMOUNT, "fee", "the transaction fee in counoshs"},
+                       {RPCResult::Type::STR_AMOUNT, "blocktime", "the timestamp of the block that contains the transaction"},
+                       {RPCResult::Type::BOOL, "valid", "whether the transaction is valid"},
+                       {RPCResult::Type::NUM, "type_int", "the transaction type as number"},
+                       {RPCResult::Type::STR, "type", "the transaction type as string"},
+                       {RPCResult::Type::ELISION, "", "other transaction type specific properties"},
+                   }},
+               }},
+               {RPCResult::Type::STR, "cursor", "the cursor of the next page, or empty, if there are no more transactions"},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("counos_listaddresstransactions", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\"")
+           + HelpExampleCli("counos_listaddresstransactions", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\" 0 999999999 \"\" 500")
+           + HelpExampleRpc("counos_listaddresstransactions", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\"")
+       }
+    }.Check(request);
+
+    std::string address = ParseAddress(request.params[0]);
+    int64_t nStartBlock = request.params[1].isNull() ? 0 : request.params[1].get_int64();
+    if (nStartBlock < 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative start block");
+    int64_t nEndBlock = request.params[2].isNull() ? 999999999 : request.params[2].get_int64();
+    if (nEndBlock < 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative end block");
+    int64_t nLimit = request.params[4].isNull() ? 100 : request.params[4].get_int64();
+    if (nLimit < 1 || nLimit > 1000) throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is out of range");
+
+    // the cursor is the block and position of the first transaction of the page
+    uint32_t nStartPosition = 0;
+    if (!request.params[3].isNull() && !request.params[3].get_str().empty()) {
+        std::vector<std::string> vstr;
+        boost::split(vstr, request.params[3].get_str(), boost::is_any_of(":"));
+        int32_t nCursorBlock = 0;
+        if (vstr.size() != 2 || !ParseInt32(vstr[0], &nCursorBlock) || nCursorBlock < 0 || !ParseUInt32(vstr[1], &nStartPosition)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        nStartBlock = nCursorBlock;
+    }
+
+    if (!g_counos_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is not enabled; use -counosaddressindex to enable it");
+    }
+    if (!g_counos_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is still being built; please try again later");
+    }
+
+    // one more entry is looked up to obtain the cursor of the next page
+    std::vector<CCounosAddressIndexEntry> entries;
+    if (nStartBlock <= nEndBlock && !g_counos_addressindex->FindTransactions(address, nStartBlock, nStartPosition,
+            std::min<int64_t>(nEndBlock, std::numeric_limits<int>::max()), nLimit + 1, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+    }
+
+    std::string nextCursor;
+    if (entries.size() > static_cast<size_t>(nLimit)) {
+        nextCursor = strprintf("%d:%d", entries.back().nHeight, entries.back().nPosition);
+        entries.pop_back();
+    }
+
+    UniValue response(UniValue::VARR);
+    for (const CCounosAddressIndexEntry& entry : entries) {
+        UniValue txobj(UniValue::VOBJ);
+        if (populateRPCTransactionObject(entry.txid, txobj) == 0) {
+            response.push_back(txobj);
+        }
+    }
+
+    return PageToJSON(response, nextCursor);
+}
+
 #ifdef ENABLE_WALLET
 static UniValue counos_listtransactions(const JSONRPCRequest& request)
 {
@@ -2778,6 +3025,7 @@ static UniValue counos_getcurrentconsensushash(const JSONRPCRequest& request)
                {RPCResult::Type::NUM, "block", "the index of the block this consensus hash applies to"},
                {RPCResult::Type::STR_HEX, "blockhash", "the hash of the corresponding block"},
                {RPCResult::Type::STR_HEX, "consensushash", "the consensus hash for the block"},
+               {RPCResult::Type::STR_HEX, "statehash", "the incrementally maintained hash of balances, DEx, MetaDEx and crowdsale state"},
            }
        },
        RPCExamples{
@@ -2794,11 +3042,13 @@ static UniValue counos_getcurrentconsensushash(const JSONRPCRequest& request)
     uint256 blockHash = pblockindex->GetBlockHash();
 
     uint256 consensusHash = GetConsensusHash();
+    uint256 stateHash = GetStateHash();
 
     UniValue response(UniValue::VOBJ);
     response.pushKV("block", block);
     response.pushKV("blockhash", blockHash.GetHex());
     response.pushKV("consensushash", consensusHash.GetHex());
+    response.pushKV("statehash", stateHash.GetHex());
 
     return response;
 }
@@ -2895,21 +3145,22 @@ static const CRPCCommand commands[] =
   //  ------------------------------------ ------------------------------- ------------------------------ ----------
     { "counos layer (data retrieval)", "counos_getinfo",                   &counos_getinfo,                    {} },
     { "counos layer (data retrieval)", "counos_getactivations",            &counos_getactivations,             {} },
-    { "counos layer (data retrieval)", "counos_getallbalancesforid",       &counos_getallbalancesforid,        {"propertyid"} },
+    { "counos layer (data retrieval)", "counos_getallbalancesforid",       &counos_getallbalancesforid,        {"propertyid", "cursor", "limit"} },
     { "counos layer (data retrieval)", "counos_getbalance",                &counos_getbalance,                 {"address", "propertyid"} },
     { "counos layer (data retrieval)", "counos_gettransaction",            &counos_gettransaction,             {"txid"} },
     { "counos layer (data retrieval)", "counos_getproperty",               &counos_getproperty,                {"propertyid"} },
-    { "counos layer (data retrieval)", "counos_listproperties",            &counos_listproperties,             {} },
+    { "counos layer (data retrieval)", "counos_listproperties",            &counos_listproperties,             {"cursor", "limit"} },
     { "counos layer (data retrieval)", "counos_getcrowdsale",              &counos_getcrowdsale,               {"propertyid", "verbose"} },
     { "counos layer (data retrieval)", "counos_getgrants",                 &counos_getgrants,                  {"propertyid"} },
     { "counos layer (data retrieval)", "counos_getactivedexsells",         &counos_getactivedexsells,          {"address"} },
     { "counos layer (data retrieval)", "counos_getactivecrowdsales",       &counos_getactivecrowdsales,        {} },
-    { "counos layer (data retrieval)", "counos_getorderbook",              &counos_getorderbook,               {"propertyid", "propertyid"} },
+    { "counos layer (data retrieval)", "counos_getorderbook",              &counos_getorderbook,               {"propertyid", "propertyiddesired", "cursor", "limit"} },
     { "counos layer (data retrieval)", "counos_gettrade",                  &counos_gettrade,                   {"txid"} },
     { "counos layer (data retrieval)", "counos_getsto",                    &counos_getsto,                     {"txid", "recipientfilter"} },
     { "counos layer (data retrieval)", "counos_listblocktransactions",     &counos_listblocktransactions,      {"index"} },
     { "counos layer (data retrieval)", "counos_listblockstransactions",    &counos_listblockstransactions,     {"firstblock", "lastblock"} },
     { "counos layer (data retrieval)", "counos_listpendingtransactions",   &counos_listpendingtransactions,    {"address"} },
+    { "counos layer (data retrieval)", "counos_listaddresstransactions",   &counos_listaddresstransactions,    {"address", "startblock", "endblock", "cursor", "limit"} },
     { "counos layer (data retrieval)", "counos_getallbalancesforaddress",  &counos_getallbalancesforaddress,   {"address"} },
     { "counos layer (data retrieval)", "counos_gettradehistoryforaddress", &counos_gettradehistoryforaddress,  {"address", "count", "propertyid"} },
     { "counos layer (data retrieval)", "counos_gettradehistoryforpair",    &counos_gettradehistoryforpair,     {"propertyid", "propertyidsecond", "count"} },
@@ -2939,15 +3190,15 @@ static const CRPCCommand commands[] =
     { "hidden",                      "getinfo_MP",                     &counos_getinfo,                    {}  },
     { "hidden",                      "getbalance_MP",                  &counos_getbalance,                 {"address", "propertyid"} },
     { "hidden",                      "getallbalancesforaddress_MP",    &counos_getallbalancesforaddress,   {"address"} },
-    { "hidden",                      "getallbalancesforid_MP",         &counos_getallbalancesforid,        {"propertyid"} },
+    { "hidden",                      "getallbalancesforid_MP",         &counos_getallbalancesforid,        {"propertyid", "cursor", "limit"} },
     { "hidden",                      "getproperty_MP",                 &counos_getproperty,                {"propertyid"} },
-    { "hidden",                      "listproperties_MP",              &counos_listproperties,             {} },
+    { "hidden",                      "listproperties_MP",              &counos_listproperties,             {"cursor", "limit"} },
     { "hidden",                      "getcrowdsale_MP",                &counos_getcrowdsale,               {"propertyid", "verbose"} },
     { "hidden",                      "getgrants_MP",                   &counos_getgrants,                  {"propertyid"} },
     { "hidden",                      "getactivedexsells_MP",           &counos_getactivedexsells,          {"address"} },
     { "hidden",                      "getactivecrowdsales_MP",         &counos_getactivecrowdsales,        {} },
     { "hidden",                      "getsto_MP",                      &counos_getsto,                     {"txid", "recipientfilter"} },
-    { "hidden",                      "getorderbook_MP",                &counos_getorderbook,               {"propertyid", "propertyiddesired"} },
+    { "hidden",                      "getorderbook_MP",                &counos_getorderbook,               {"propertyid", "propertyiddesired", "cursor", "limit"} },
     { "hidden",                      "gettrade_MP",                    &counos_gettrade,                   {"txid"} },
     { "hidden",                      "gettransaction_MP",              &counos_gettransaction,             {"txid"} },
     { "hidden",                      "listblocktransactions_MP",       &counos_listblocktransactions,      {"index"} },
@@ -70,8 +70,8 @@ void RequireEmptyDelegate(uint32_t propertyId)
 void RequireSenderDelegateBeforeIssuer(uint32_t propertyId, const std::string& address)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (sp.delegate.empty()) {
@@ -88,8 +88,8 @@ void RequireSenderDelegateBeforeIssuer(uint32_t propertyId, const std::string& a
 void RequireSenderDelegateOrIssuer(uint32_t propertyId, const std::string& address)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (address != sp.issuer && address != sp.delegate) {
@@ -100,8 +100,8 @@ void RequireSenderDelegateOrIssuer(uint32_t propertyId, const std::string& addre
 void RequireMatchingDelegate(uint32_t propertyId, const std::string& address)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (sp.delegate != address) {
@@ -126,8 +126,8 @@ void RequireDifferentIds(uint32_t propertyId, uint32_t otherId)
 void RequireCrowdsale(uint32_t propertyId)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (sp.fixed || sp.manual) {
@@ -146,8 +146,8 @@ void RequireActiveCrowdsale(uint32_t propertyId)
 void RequireManagedProperty(uint32_t propertyId)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (sp.fixed || !sp.manual) {
@@ -158,8 +158,8 @@ void RequireManagedProperty(uint32_t propertyId)
 void RequireNonFungibleProperty(uint32_t propertyId)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (!sp.unique) {
@@ -170,8 +170,8 @@ void RequireNonFungibleProperty(uint32_t propertyId)
 void RequireTokenIssuer(const std::string& address, uint32_t propertyId)
 {
     LOCK(cs_tally);
-    CMPSPInfo::Entry sp;
-    if (!mastercore::pDbSpInfo->getSP(propertyId, sp)) {
+    CMPSPInfo::Summary sp;
+    if (!mastercore::pDbSpInfo->getSPSummary(propertyId, sp)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to retrieve property");
     }
     if (address != sp.issuer) {
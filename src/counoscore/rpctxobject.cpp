@@ -43,6 +43,127 @@
 // Namespaces
 using namespace mastercore;
 
+/**
+ * Retrieves the transaction, as it was decoded when its block was connected.
+ *
+ * Decoded transactions of blocks, which are no longer part of the active chain,
+ * are removed.
+ */
+static bool GetDecodedTransaction(const uint256& txid, CDecodedTransactionRecord& decoded)
+{
+    {
+        LOCK(cs_tally);
+        if (nullptr == pDbTransaction || !pDbTransaction->FetchDecodedTransaction(txid, decoded)) return false;
+    }
+
+    bool fActive = false;
+    {
+        LOCK(cs_main);
+        CBlockIndex* pBlockIndex = LookupBlockIndex(decoded.blockHash);
+        fActive = (nullptr != pBlockIndex && ::ChainActive().Contains(pBlockIndex));
+    }
+
+    if (!fActive) {
+        LOCK(cs_tally);
+        pDbTransaction->EraseDecodedTransaction(txid);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Populates the RPC object of an interpreted transaction.
+ *
+ * Validity and position in block are taken from the decoded transaction, if
+ * available, and otherwise looked up.
+ */
+static int populateRPCTransactionObject(CMPTransaction& mp_obj, const uint256& blockHash, int64_t blockTime, int blockHeight, int confirmations, const CDecodedTransactionRecord* pDecoded, UniValue& txobj, const std::string& filterAddress, bool extendedDetails, const std::string& extendedDetailsFilter, interfaces::Wallet* iWallet)
+{
+    const uint256& txid = mp_obj.getHash();
+    int positionInBlock = 0;
+
+    // check if we're filtering from listtransactions_MP, and if so whether we have a non-match we want to skip
+    if (!filterAddress.empty() && mp_obj.getSender() != filterAddress && mp_obj.getReceiver() != filterAddress) return -1;
+
+    // parse packet and populate mp_obj
+    if (!mp_obj.interpret_Transaction()) return MP_TX_IS_NOT_COUNOS_PROTOCOL;
+
+    // obtain validity - only confirmed transactions can be valid
+    bool valid = false;
+    std::string invalidReason;
+    if (confirmations > 0) {
+        if (pDecoded) {
+            valid = (0 <= pDecoded->nProcessingResult);
+            positionInBlock = pDecoded->nPosition;
+            if (!valid) invalidReason = error_str(pDecoded->nProcessingResult);
+        } else {
+            LOCK(cs_tally);
+            valid = pDbTransactionList->getValidMPTX(txid);
+            positionInBlock = pDbTransaction->FetchTransactionPosition(txid);
+            if (!valid) invalidReason = pDbTransaction->FetchInvalidReason(txid);
+        }
+    }
+
+    // populate some initial info for the transaction
+    bool fMine = false;
+    if (IsMyAddress(mp_obj.getSender(), iWallet) || IsMyAddress(mp_obj.getReceiver(), iWallet)) fMine = true;
+    txobj.pushKV("txid", txid.GetHex());
+    txobj.pushKV("fee", FormatDivisibleMP(mp_obj.getFeePaid()));
+    txobj.pushKV("sendingaddress", mp_obj.getSender());
+    if (showRefForTx(mp_obj.getType())) txobj.pushKV("referenceaddress", mp_obj.getReceiver());
+    txobj.pushKV("ismine", fMine);
+    txobj.pushKV("version", (uint64_t)mp_obj.getVersion());
+    txobj.pushKV("type_int", (uint64_t)mp_obj.getType());
+    if (mp_obj.getType() != MSC_TYPE_SIMPLE_SEND) { // Type 0 will add "Type" attribute during populateRPCTypeSimpleSend
+        txobj.pushKV("type", mp_obj.getTypeString());
+    }
+
+    // populate type specific info and extended details if requested
+    // extended details are not available for unconfirmed transactions
+    if (confirmations <= 0) extendedDetails = false;
+    populateRPCTypeInfo(mp_obj, txobj, mp_obj.getType(), extendedDetails, extendedDetailsFilter, confirmations, iWallet);
+
+    // state and chain related information
+    if (confirmations != 0 && !blockHash.IsNull()) {
+        txobj.pushKV("valid", valid);
+        if (!valid) {
+            txobj.pushKV("invalidreason", invalidReason);
+        }
+        txobj.pushKV("blockhash", blockHash.GetHex());
+        txobj.pushKV("blocktime", blockTime);
+        txobj.pushKV("positioninblock", positionInBlock);
+    }
+    if (confirmations != 0) {
+        txobj.pushKV("block", blockHeight);
+    }
+    txobj.pushKV("confirmations", confirmations);
+
+    // finished
+    return 0;
+}
+
+/**
+ * Populates the RPC object of a transaction, as it was decoded when its block was connected.
+ */
+static int populateRPCTransactionObject(const uint256& txid, const CDecodedTransactionRecord& decoded, UniValue& txobj, const std::string& filterAddress, bool extendedDetails, const std::string& extendedDetailsFilter, int blockHeight, interfaces::Wallet* iWallet)
+{
+    if (blockHeight == 0) {
+        blockHeight = GetHeight();
+    }
+    int confirmations = 1 + blockHeight - decoded.nBlock;
+
+    CMPTransaction mp_obj;
+    mp_obj.Set(decoded.sender, decoded.reference, 0, txid, decoded.nBlock, decoded.nPosition,
+            const_cast<unsigned char*>(decoded.payload.data()), decoded.payload.size(), decoded.nEncodingClass, decoded.nFee);
+    mp_obj.Set(txid, decoded.nBlock, decoded.nPosition, decoded.nBlockTime);
+    for (std::map<uint8_t, std::string>::const_iterator it = decoded.stmAddresses.begin(); it != decoded.stmAddresses.end(); ++it) {
+        mp_obj.addValidStmAddress(it->first, it->second);
+    }
+
+    return populateRPCTransactionObject(mp_obj, decoded.blockHash, decoded.nBlockTime, decoded.nBlock, confirmations, &decoded, txobj, filterAddress, extendedDetails, extendedDetailsFilter, iWallet);
+}
+
 /**
  * Function to standardize RPC output for transactions into a JSON object in either basic or extended mode.
  *
@@ -50,9 +171,17 @@ using namespace mastercore;
  * Use extended mode for transaction specific calls (e.g. counos_getsto, counos_gettrade etc.)
  *
  * DEx payments and the extended mode are only available for confirmed transactions.
+ *
+ * Confirmed transactions are served from the transactions decoded when their
+ * blocks were connected, so they are neither looked up, nor parsed again.
  */
 int populateRPCTransactionObject(const uint256& txid, UniValue& txobj, std::string filterAddress, bool extendedDetails, std::string extendedDetailsFilter, interfaces::Wallet* iWallet)
 {
+    CDecodedTransactionRecord decoded;
+    if (GetDecodedTransaction(txid, decoded)) {
+        return populateRPCTransactionObject(txid, decoded, txobj, filterAddress, extendedDetails, extendedDetailsFilter, 0, iWallet);
+    }
+
     bool f_txindex_ready = false;
     if (g_txindex) {
         f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
@@ -76,7 +205,12 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
 {
     int confirmations = 0;
     int64_t blockTime = 0;
-    int positionInBlock = 0;
+
+    // confirmed transactions, which were decoded in the same block, don't need to be parsed again
+    CDecodedTransactionRecord decoded;
+    if (!blockHash.IsNull() && GetDecodedTransaction(tx.GetHash(), decoded) && decoded.blockHash == blockHash) {
+        return populateRPCTransactionObject(tx.GetHash(), decoded, txobj, filterAddress, extendedDetails, extendedDetailsFilter, blockHeight, iWallet);
+    }
 
     if (blockHeight == 0) {
         blockHeight = GetHeight();
@@ -128,56 +262,7 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
         return 0;
     }
 
-    // check if we're filtering from listtransactions_MP, and if so whether we have a non-match we want to skip
-    if (!filterAddress.empty() && mp_obj.getSender() != filterAddress && mp_obj.getReceiver() != filterAddress) return -1;
-
-    // parse packet and populate mp_obj
-    if (!mp_obj.interpret_Transaction()) return MP_TX_IS_NOT_COUNOS_PROTOCOL;
-
-    // obtain validity - only confirmed transactions can be valid
-    bool valid = false;
-    if (confirmations > 0) {
-        LOCK(cs_tally);
-        valid = pDbTransactionList->getValidMPTX(txid);
-        positionInBlock = pDbTransaction->FetchTransactionPosition(txid);
-    }
-
-    // populate some initial info for the transaction
-    bool fMine = false;
-    if (IsMyAddress(mp_obj.getSender(), iWallet) || IsMyAddress(mp_obj.getReceiver(), iWallet)) fMine = true;
-    txobj.pushKV("txid", txid.GetHex());
-    txobj.pushKV("fee", FormatDivisibleMP(mp_obj.getFeePaid()));
-    txobj.pushKV("sendingaddress", mp_obj.getSender());
-    if (showRefForTx(mp_obj.getType())) txobj.pushKV("referenceaddress", mp_obj.getReceiver());
-    txobj.pushKV("ismine", fMine);
-    txobj.pushKV("version", (uint64_t)mp_obj.getVersion());
-    txobj.pushKV("type_int", (uint64_t)mp_obj.getType());
-    if (mp_obj.getType() != MSC_TYPE_SIMPLE_SEND) { // Type 0 will add "Type" attribute during populateRPCTypeSimpleSend
-        txobj.pushKV("type", mp_obj.getTypeString());
-    }
-
-    // populate type specific info and extended details if requested
-    // extended details are not available for unconfirmed transactions
-    if (confirmations <= 0) extendedDetails = false;
-    populateRPCTypeInfo(mp_obj, txobj, mp_obj.getType(), extendedDetails, extendedDetailsFilter, confirmations, iWallet);
-
-    // state and chain related information
-    if (confirmations != 0 && !blockHash.IsNull()) {
-        txobj.pushKV("valid", valid);
-        if (!valid) {
-            txobj.pushKV("invalidreason", pDbTransaction->FetchInvalidReason(txid));
-        }
-        txobj.pushKV("blockhash", blockHash.GetHex());
-        txobj.pushKV("blocktime", blockTime);
-        txobj.pushKV("positioninblock", positionInBlock);
-    }
-    if (confirmations != 0) {
-        txobj.pushKV("block", blockHeight);
-    }
-    txobj.pushKV("confirmations", confirmations);
-
-    // finished
-    return 0;
+    return populateRPCTransactionObject(mp_obj, blockHash, blockTime, blockHeight, confirmations, nullptr, txobj, filterAddress, extendedDetails, extendedDetailsFilter, iWallet);
 }
 
 /* Function to call respective populators based on message type
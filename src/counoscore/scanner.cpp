@@ -0,0 +1,317 @@
+/**
+ * @file scanner.cpp
+ *
+ * This file provides the read-ahead stage of the initial scan.
+ */
+
+#include <counoscore/scanner.h>
+
+#include <counoscore/counoscore.h>
+#include <counoscore/log.h>
+#include <counoscore/seedblocks.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <sync.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace mastercore;
+
+namespace {
+/** The transactions of a block, which are flagged in ranges by the calling thread and the workers. */
+class CFlagJob
+{
+private:
+    const CBlock& block;
+    const int nBlock;
+    const size_t nRanges;
+    const size_t nRangeSize;
+
+    //! The next range to flag
+    std::atomic<size_t> nNextRange;
+
+    Mutex cs_done;
+    std::condition_variable condDone;
+    //! Number of ranges, which were flagged
+    size_t nDone;
+
+public:
+    //! std::vector<bool> packs the flags, so they are collected per byte, before they are handed out
+    std::vector<char> vFlags;
+
+    CFlagJob(const CBlock& blockIn, int nBlockIn, size_t nRangesIn)
+      : block(blockIn), nBlock(nBlockIn), nRanges(nRangesIn),
+        nRangeSize((blockIn.vtx.size() + nRangesIn - 1) / nRangesIn),
+        nNextRange(0), nDone(0), vFlags(blockIn.vtx.size(), 0) {}
+
+    /** Flags ranges, until none is left. The block is only accessed, while the caller waits. */
+    void Run()
+    {
+        size_t nRange;
+        while ((nRange = nNextRange++) < nRanges) {
+            size_t nBegin = nRange * nRangeSize;
+            size_t nEnd = std::min(nBegin + nRangeSize, vFlags.size());
+            for (size_t n = nBegin; n < nEnd; ++n) {
+                vFlags[n] = MayHaveMarker(*block.vtx[n], nBlock);
+            }
+            {
+                LOCK(cs_done);
+                ++nDone;
+            }
+            condDone.notify_all();
+        }
+    }
+
+    /** Waits, until all ranges were flagged. */
+    void Wait()
+    {
+        WAIT_LOCK(cs_done, lock);
+        while (nDone < nRanges) {
+            condDone.wait(lock);
+        }
+    }
+};
+
+/** Persistent worker threads, which help to flag the transactions of large connected blocks. */
+class CFlagWorkerPool
+{
+private:
+    Mutex cs_workers;
+    std::condition_variable condWorkers;
+
+    //! Jobs, which wait for a worker to join
+    std::deque<std::shared_ptr<CFlagJob> > jobs;
+    //! Whether the workers should stop
+    bool fStop;
+
+    std::vector<std::thread> vWorkers;
+
+    void ThreadFlag()
+    {
+        while (true) {
+            std::shared_ptr<CFlagJob> job;
+            {
+                WAIT_LOCK(cs_workers, lock);
+                while (!fStop && jobs.empty()) {
+                    condWorkers.wait(lock);
+                }
+                if (fStop) return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            job->Run();
+        }
+    }
+
+public:
+    CFlagWorkerPool() : fStop(false) {}
+
+    ~CFlagWorkerPool()
+    {
+        Stop();
+    }
+
+    void Start(int nThreads)
+    {
+        LOCK(cs_workers);
+        if (!vWorkers.empty()) return;
+
+        fStop = false;
+        for (int i = 0; i < nThreads; ++i) {
+            vWorkers.emplace_back(std::bind(&TraceThread<std::function<void()> >, "counosflag",
+                    std::function<void()>(std::bind(&CFlagWorkerPool::ThreadFlag, this))));
+        }
+    }
+
+    void Stop()
+    {
+        std::vector<std::thread> vStopped;
+        {
+            LOCK(cs_workers);
+            fStop = true;
+            jobs.clear();
+            vStopped.swap(vWorkers);
+        }
+        condWorkers.notify_all();
+
+        for (std::thread& worker : vStopped) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    /** Asks up to the given number of workers to join the job, and returns the number of workers asked. */
+    size_t Submit(const std::shared_ptr<CFlagJob>& job, size_t nHelpers)
+    {
+        {
+            LOCK(cs_workers);
+            nHelpers = std::min(nHelpers, vWorkers.size());
+            for (size_t i = 0; i < nHelpers; ++i) {
+                jobs.push_back(job);
+            }
+        }
+        condWorkers.notify_all();
+
+        return nHelpers;
+    }
+};
+
+CFlagWorkerPool flagWorkers;
+}
+
+void mastercore::StartFlagWorkers(int nThreads)
+{
+    flagWorkers.Start(nThreads);
+}
+
+void mastercore::StopFlagWorkers()
+{
+    flagWorkers.Stop();
+}
+
+/**
+ * Flags the transactions of a block, which may carry a marker.
+ *
+ * The check doesn't depend on the state, so large blocks are split into
+ * ranges of transactions, which are checked by the calling thread, and
+ * the persistent flag workers, if they were started.
+ *
+ * Small blocks, and blocks flagged while the workers are busy, are checked
+ * by the calling thread alone.
+ */
+std::vector<bool> mastercore::FlagMarkerTransactions(const CBlock& block, int nBlock, int nThreads)
+{
+    const size_t nTxs = block.vtx.size();
+    const size_t nRanges = std::min<size_t>(std::max(nThreads, 1), std::max<size_t>(nTxs / MIN_FLAG_TXS_PER_THREAD, 1));
+
+    if (nRanges < 2) {
+        std::vector<bool> vFlags(nTxs);
+        for (size_t n = 0; n < nTxs; ++n) {
+            vFlags[n] = MayHaveMarker(*block.vtx[n], nBlock);
+        }
+        return vFlags;
+    }
+
+    // workers, which pick up the job after all ranges were taken, return without accessing the block
+    std::shared_ptr<CFlagJob> job = std::make_shared<CFlagJob>(block, nBlock, nRanges);
+    flagWorkers.Submit(job, nRanges - 1);
+    job->Run();
+    job->Wait();
+
+    return std::vector<bool>(job->vFlags.begin(), job->vFlags.end());
+}
+
+CBlockPrefetcher::CBlockPrefetcher(int nFirstBlock, int nLastBlockIn, int nThreads, bool fSeedBlockFilterIn)
+  : nNextBlock(nFirstBlock), nLastBlock(nLastBlockIn), nWantedBlock(nFirstBlock),
+    fSeedBlockFilter(fSeedBlockFilterIn), fStop(false)
+{
+    if (nThreads < 1) nThreads = 1;
+
+    for (int i = 0; i < nThreads; ++i) {
+        vWorkers.emplace_back(std::bind(&TraceThread<std::function<void()> >, "counosscan",
+                std::function<void()>(std::bind(&CBlockPrefetcher::ThreadPrefetch, this))));
+    }
+}
+
+CBlockPrefetcher::~CBlockPrefetcher()
+{
+    Stop();
+}
+
+void CBlockPrefetcher::Stop()
+{
+    {
+        LOCK(cs_prefetch);
+        fStop = true;
+    }
+    condPrefetch.notify_all();
+
+    for (std::thread& worker : vWorkers) {
+        if (worker.joinable()) worker.join();
+    }
+    vWorkers.clear();
+}
+
+/**
+ * Reads a block from disk, and flags the transactions, which may carry a marker.
+ */
+std::shared_ptr<CPrefetchedBlock> CBlockPrefetcher::ReadBlock(int nBlock) const
+{
+    std::shared_ptr<CPrefetchedBlock> pBlock = std::make_shared<CPrefetchedBlock>();
+    {
+        LOCK(cs_main);
+        pBlock->pBlockIndex = ::ChainActive()[nBlock];
+    }
+
+    if (nullptr == pBlock->pBlockIndex) return pBlock;
+
+    if (fSeedBlockFilter && SkipBlock(nBlock)) {
+        pBlock->fSkipped = true;
+        return pBlock;
+    }
+
+    if (!ReadBlockFromDisk(pBlock->block, pBlock->pBlockIndex, Params().GetConsensus())) {
+        PrintToLog("%s(): failed to read block %d from disk\n", __func__, nBlock);
+        return pBlock;
+    }
+    pBlock->fRead = true;
+
+    // blocks are already read by multiple workers, so each block is checked by a single thread
+    pBlock->vMayHaveMarker = FlagMarkerTransactions(pBlock->block, nBlock, 1);
+
+    return pBlock;
+}
+
+void CBlockPrefetcher::ThreadPrefetch()
+{
+    while (true) {
+        int nBlock;
+        {
+            WAIT_LOCK(cs_prefetch, lock);
+            while (!fStop && nNextBlock <= nLastBlock && nNextBlock >= nWantedBlock + MAX_SCAN_BLOCKS_AHEAD) {
+                condPrefetch.wait(lock);
+            }
+            if (fStop || nNextBlock > nLastBlock) return;
+            nBlock = nNextBlock++;
+        }
+
+        std::shared_ptr<CPrefetchedBlock> pBlock = ReadBlock(nBlock);
+
+        {
+            LOCK(cs_prefetch);
+            mapBlocks[nBlock] = pBlock;
+        }
+        condPrefetch.notify_all();
+    }
+}
+
+std::shared_ptr<CPrefetchedBlock> CBlockPrefetcher::GetBlock(int nBlock)
+{
+    std::shared_ptr<CPrefetchedBlock> pBlock;
+    {
+        WAIT_LOCK(cs_prefetch, lock);
+        assert(nBlock == nWantedBlock);
+        assert(nBlock <= nLastBlock);
+
+        std::map<int, std::shared_ptr<CPrefetchedBlock> >::iterator it;
+        while ((it = mapBlocks.find(nBlock)) == mapBlocks.end()) {
+            condPrefetch.wait(lock);
+        }
+        pBlock = it->second;
+        mapBlocks.erase(it);
+        nWantedBlock = nBlock + 1;
+    }
+    condPrefetch.notify_all();
+
+    return pBlock;
+}
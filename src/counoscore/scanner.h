@@ -0,0 +1,95 @@
+#ifndef COUNOSH_COUNOSCORE_SCANNER_H
+#define COUNOSH_COUNOSCORE_SCANNER_H
+
+#include <primitives/block.h>
+#include <sync.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+
+namespace mastercore
+{
+//! Default number of threads used to read blocks ahead during the initial scan
+static const int DEFAULT_SCAN_THREADS = 2;
+//! Maximum number of blocks read ahead of the block, which is currently processed
+static const int MAX_SCAN_BLOCKS_AHEAD = 32;
+//! Minimum number of transactions checked per thread, when the transactions of a block are flagged
+static const size_t MIN_FLAG_TXS_PER_THREAD = 256;
+
+/** Flags the transactions of a block, which may carry a marker, using up to the given number of threads. */
+std::vector<bool> FlagMarkerTransactions(const CBlock& block, int nBlock, int nThreads);
+
+/** Starts the worker threads, which help to flag the transactions of large blocks. */
+void StartFlagWorkers(int nThreads);
+
+/** Stops and joins the worker threads, which help to flag the transactions of large blocks. */
+void StopFlagWorkers();
+
+/** A block of the initial scan, read ahead of processing.
+ */
+struct CPrefetchedBlock
+{
+    //! The block index, or nullptr, if the block isn't part of the active chain
+    const CBlockIndex* pBlockIndex;
+    //! Whether the block was skipped by the seed block filter
+    bool fSkipped;
+    //! Whether the block was read from disk successfully
+    bool fRead;
+    //! The block, if it was read
+    CBlock block;
+    //! Whether a transaction of the block may carry a marker, see MayHaveMarker()
+    std::vector<bool> vMayHaveMarker;
+
+    CPrefetchedBlock() : pBlockIndex(nullptr), fSkipped(false), fRead(false) {}
+};
+
+/** Reads and deserializes the blocks of the initial scan ahead of processing.
+ *
+ * A pool of worker threads reads blocks from disk, and flags the transactions,
+ * which may carry a marker. The work done by the workers doesn't depend on the
+ * state, so it can overlap with the in-order processing of previous blocks.
+ *
+ * At most MAX_SCAN_BLOCKS_AHEAD blocks are held in memory.
+ */
+class CBlockPrefetcher
+{
+private:
+    Mutex cs_prefetch;
+    std::condition_variable condPrefetch;
+
+    //! Blocks, which were read, but not yet retrieved
+    std::map<int, std::shared_ptr<CPrefetchedBlock> > mapBlocks;
+    //! The next block to read
+    int nNextBlock;
+    //! The last block to read
+    const int nLastBlock;
+    //! The next block to be retrieved
+    int nWantedBlock;
+    //! Whether blocks skipped by the seed block filter are read
+    const bool fSeedBlockFilter;
+    //! Whether the workers should stop
+    bool fStop;
+
+    std::vector<std::thread> vWorkers;
+
+    void ThreadPrefetch();
+    std::shared_ptr<CPrefetchedBlock> ReadBlock(int nBlock) const;
+
+public:
+    CBlockPrefetcher(int nFirstBlock, int nLastBlock, int nThreads, bool fSeedBlockFilter);
+    ~CBlockPrefetcher();
+
+    /** Waits for the block at the given height, and hands it over. Blocks must be retrieved in order. */
+    std::shared_ptr<CPrefetchedBlock> GetBlock(int nBlock);
+
+    /** Stops and joins the worker threads. */
+    void Stop();
+};
+}
+
+#endif // COUNOSH_COUNOSCORE_SCANNER_H
@@ -2,6 +2,7 @@
 
 #include <counoscore/sp.h>
 
+#include <counoscore/consensushash.h>
 #include <counoscore/log.h>
 #include <counoscore/counoscore.h>
 #include <counoscore/uint256_extensions.h>
@@ -54,7 +55,7 @@ void CMPCrowd::print(const std::string& address, FILE* fp) const
     fprintf(fp, "%s\n", toString(address).c_str());
 }
 
-void CMPCrowd::saveCrowdSale(std::ofstream& file, const std::string& addr, CHash256& hasher) const
+void CMPCrowd::saveCrowdSale(std::ostream& file, const std::string& addr, CHash256& hasher) const
 {
     // compose the outputline
     // addr,propertyId,nValue,property_desired,deadline,early_bird,percentage,created,mined
@@ -122,18 +123,18 @@ bool mastercore::IsPropertyIdValid(uint32_t propertyId)
 
 bool mastercore::isPropertyNonFungible(uint32_t propertyId)
 {
-    CMPSPInfo::Entry sp;
+    CMPSPInfo::Summary sp;
 
-    if (pDbSpInfo->getSP(propertyId, sp)) return sp.unique;
+    if (pDbSpInfo->getSPSummary(propertyId, sp)) return sp.unique;
 
     return false;
 }
 
 bool mastercore::HasDelegate(uint32_t propertyId)
 {
-    CMPSPInfo::Entry sp;
+    CMPSPInfo::Summary sp;
 
-    if (pDbSpInfo->getSP(propertyId, sp)) {
+    if (pDbSpInfo->getSPSummary(propertyId, sp)) {
         return !sp.delegate.empty();
     }
 
@@ -142,9 +143,9 @@ bool mastercore::HasDelegate(uint32_t propertyId)
 
 std::string mastercore::GetDelegate(uint32_t propertyId)
 {
-    CMPSPInfo::Entry sp;
+    CMPSPInfo::Summary sp;
 
-    if (pDbSpInfo->getSP(propertyId, sp)) {
+    if (pDbSpInfo->getSPSummary(propertyId, sp)) {
         return sp.delegate;
     }
 
@@ -153,18 +154,17 @@ std::string mastercore::GetDelegate(uint32_t propertyId)
 
 bool mastercore::isPropertyDivisible(uint32_t propertyId)
 {
-    // TODO: is a lock here needed
-    CMPSPInfo::Entry sp;
+    CMPSPInfo::Summary sp;
 
-    if (pDbSpInfo->getSP(propertyId, sp)) return sp.isDivisible();
+    if (pDbSpInfo->getSPSummary(propertyId, sp)) return sp.divisible;
 
     return true;
 }
 
 std::string mastercore::getPropertyName(uint32_t propertyId)
 {
-    CMPSPInfo::Entry sp;
-    if (pDbSpInfo->getSP(propertyId, sp)) return sp.name;
+    CMPSPInfo::Summary sp;
+    if (pDbSpInfo->getSPSummary(propertyId, sp)) return sp.name;
     return "Property Name Not Found";
 }
 
@@ -389,6 +389,7 @@ void mastercore::eraseMaxedCrowdsale(const std::string& address, int64_t blockTi
         assert(pDbSpInfo->updateSP(crowdsale.getPropertyId(), sp));
 
         // no calculate fractional calls here, no more tokens (at MAX)
+        UpdateStateHash(crowdsale, address, false);
         my_crowds.erase(it);
     }
 }
@@ -435,6 +436,7 @@ unsigned int mastercore::eraseExpiredCrowdsale(const CBlockIndex* pBlockIndex)
                 assert(update_tally_map(sp.issuer, crowdsale.getPropertyId(), missedTokens, BALANCE));
             }
 
+            UpdateStateHash(crowdsale, address, false);
             my_crowds.erase(my_it++);
 
             ++how_many_erased;
@@ -5,9 +5,11 @@
 #include <counoscore/dbspinfo.h>
 #include <counoscore/log.h>
 
+#include <serialize.h>
+#include <uint256.h>
+
 class CBlockIndex;
 class CHash256;
-class uint256;
 
 #include <stdint.h>
 #include <stdio.h>
@@ -61,7 +63,22 @@ public:
 
     std::string toString(const std::string& address) const;
     void print(const std::string& address, FILE* fp = stdout) const;
-    void saveCrowdSale(std::ofstream& file, const std::string& addr, CHash256 &hasher) const;
+    void saveCrowdSale(std::ostream& file, const std::string& addr, CHash256 &hasher) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(propertyId);
+        READWRITE(nValue);
+        READWRITE(property_desired);
+        READWRITE(deadline);
+        READWRITE(early_bird);
+        READWRITE(percentage);
+        READWRITE(u_created);
+        READWRITE(i_created);
+        READWRITE(txFundraiserData);
+    }
 };
 
 namespace mastercore
@@ -13,6 +13,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 namespace mastercore
@@ -30,7 +31,8 @@ bool SendToOwners_compare::operator()(const std::pair<int64_t, std::string>& p1,
 /**
  * Determines the receivers and amounts to distribute.
  *
- * The sender is excluded from the result set.
+ * The sender is excluded from the result set. Only holders of the property
+ * are visited, based on the index maintained by update_tally_map().
  */
 OwnerAddrType STO_GetReceivers(const std::string& sender, uint32_t property, int64_t amount)
 {
@@ -40,29 +42,35 @@ OwnerAddrType STO_GetReceivers(const std::string& sender, uint32_t property, int
 
     {
         LOCK(cs_tally);
-        std::unordered_map<std::string, CMPTally>::iterator it;
-
-        for (it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const std::string& address = it->first;
-            const CMPTally& tally = it->second;
-
-            int64_t tokens = 0;
-            tokens += tally.getMoney(property, BALANCE);
-            tokens += tally.getMoney(property, SELLOFFER_RESERVE);
-            tokens += tally.getMoney(property, ACCEPT_RESERVE);
-            tokens += tally.getMoney(property, METADEX_RESERVE);
-
-            // Do not include the sender
-            if (address == sender) {
-                senderTokens = tokens;
-                continue;
-            }
-
-            totalTokens += tokens;
-
-            // Only holders with balance are relevant
-            if (0 < tokens) {
-                ownerAddrSet.insert(std::make_pair(tokens, address));
+        std::unordered_map<uint32_t, PropertyHolderSet>::const_iterator itHolders = mp_property_holders.find(property);
+
+        if (itHolders != mp_property_holders.end()) {
+            AddressId senderId;
+            bool fSenderKnown = addressTable.Lookup(sender, senderId);
+            PropertyHolderSet::const_iterator it;
+
+            for (it = itHolders->second.begin(); it != itHolders->second.end(); ++it) {
+                const CMPTally* tally = getTally(it->id);
+                assert(tally != nullptr);
+
+                int64_t tokens = 0;
+                tokens += tally->getMoney(property, BALANCE);
+                tokens += tally->getMoney(property, SELLOFFER_RESERVE);
+                tokens += tally->getMoney(property, ACCEPT_RESERVE);
+                tokens += tally->getMoney(property, METADEX_RESERVE);
+
+                // Do not include the sender
+                if (fSenderKnown && it->id == senderId) {
+                    senderTokens = tokens;
+                    continue;
+                }
+
+                totalTokens += tokens;
+
+                // Only holders with balance are relevant
+                if (0 < tokens) {
+                    ownerAddrSet.insert(std::make_pair(tokens, *it->address));
+                }
             }
         }
     }
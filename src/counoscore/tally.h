@@ -1,8 +1,10 @@
 #ifndef COUNOSH_COUNOSCORE_TALLY_H
 #define COUNOSH_COUNOSCORE_TALLY_H
 
+#include <prevector.h>
+
+#include <stddef.h>
 #include <stdint.h>
-#include <map>
 
 //! Balance record types
 enum TallyType {
@@ -15,20 +17,39 @@ enum TallyType {
 };
 
 /** Balance records of a single entity.
+ *
+ * The records are kept in a vector sorted by property identifier. Most entities
+ * hold only a few properties, so the records are stored inline, without any
+ * further heap allocation, up to TALLY_INLINE_RECORDS records.
  */
 class CMPTally
 {
-private:
-    typedef struct {
+public:
+    //! Balances of a single property
+    struct BalanceRecord {
+        uint32_t propertyId;
         int64_t balance[TALLY_TYPE_COUNT];
-    } BalanceRecord;
+    };
 
-    //! Map of balance records
-    typedef std::map<uint32_t, BalanceRecord> TokenMap;
+    //! Number of records stored without heap allocation
+    static const unsigned int TALLY_INLINE_RECORDS = 3;
+
+    //! Sorted vector of balance records
+    typedef prevector<TALLY_INLINE_RECORDS, BalanceRecord> TokenVector;
+    //! Iterator over the balance records, sorted by property identifier
+    typedef TokenVector::const_iterator const_iterator;
+
+private:
     //! Balance records for different tokens
-    TokenMap mp_token;
-    //! Internal iterator pointing to a balance record
-    TokenMap::iterator my_it;
+    TokenVector mp_token;
+    //! Position of the internal iterator
+    uint32_t my_pos;
+
+    /** Returns the record of the property, or nullptr, if there is none. */
+    const BalanceRecord* find(uint32_t propertyId) const;
+
+    /** Returns the record of the property, and inserts an empty one, if there is none. */
+    BalanceRecord& findOrInsert(uint32_t propertyId);
 
 public:
     /** Creates an empty tally. */
@@ -40,6 +61,15 @@ public:
     /** Advances the internal iterator. */
     uint32_t next();
 
+    /** Returns an iterator to the first balance record, without changing the tally. */
+    const_iterator begin() const { return mp_token.begin(); }
+
+    /** Returns an iterator past the last balance record. */
+    const_iterator end() const { return mp_token.end(); }
+
+    /** Returns the number of balance records. */
+    size_t size() const { return mp_token.size(); }
+
     /** Updates the number of tokens for the given tally type. */
     bool updateMoney(uint32_t propertyId, int64_t amount, TallyType ttype);
 
@@ -0,0 +1,321 @@
+#include <counoscore/addressindex.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/createpayload.h>
+#include <counoscore/dbstolist.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/dbtransaction.h>
+#include <counoscore/parsing.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <key.h>
+#include <key_io.h>
+#include <miner.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <rpc/server.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <univalue.h>
+#include <util/memory.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+namespace {
+/** Provides a chain of 100 blocks, and the Counos Core databases read by the index. */
+struct AddressIndexTestingSetup : public TestingSetup
+{
+    CKey coinbaseKey;
+    std::vector<CTransactionRef> m_coinbase_txns;
+    int64_t nMockTime;
+    CCounosTransactionDB* pDbTransactionSaved;
+    CMPTradeList* pDbTradeListSaved;
+    CMPSTOList* pDbStoListSaved;
+
+    AddressIndexTestingSetup() : nMockTime(Params().GenesisBlock().GetBlockTime())
+    {
+        coinbaseKey.MakeNewKey(true);
+        const CScript scriptPubKey = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
+        for (int i = 0; i < 100; ++i) {
+            m_coinbase_txns.push_back(MineBlock(scriptPubKey).vtx[0]);
+        }
+
+        LOCK(cs_tally);
+        pDbTransactionSaved = pDbTransaction;
+        pDbTradeListSaved = pDbTradeList;
+        pDbStoListSaved = pDbStoList;
+        pDbTransaction = new CCounosTransactionDB(GetDataDir() / "COUNOS_txdb_addressindex", true);
+        pDbTradeList = new CMPTradeList(GetDataDir() / "COUNOS_tradelist_addressindex", true);
+        pDbStoList = new CMPSTOList(GetDataDir() / "COUNOS_stolist_addressindex", true);
+    }
+
+    ~AddressIndexTestingSetup()
+    {
+        SetMockTime(0);
+        LOCK(cs_tally);
+        delete pDbTransaction;
+        delete pDbTradeList;
+        delete pDbStoList;
+        pDbTransaction = pDbTransactionSaved;
+        pDbTradeList = pDbTradeListSaved;
+        pDbStoList = pDbStoListSaved;
+    }
+
+    /** Mines a block on top of the chain. Blocks are at least 90 seconds apart, so the time is advanced. */
+    CBlock MineBlock(const CScript& scriptPubKey)
+    {
+        nMockTime += 100;
+        SetMockTime(nMockTime);
+
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+        }
+        while (!CheckProofOfWork(block.GetHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, std::make_shared<const CBlock>(block), true, nullptr));
+        return block;
+    }
+
+    /** Records the coinbase transaction of the block at the given height as Counos transaction. */
+    uint256 RecordDecoded(int nHeight, uint32_t nPosition, const std::string& sender, const std::string& reference = "")
+    {
+        CDecodedTransactionRecord decoded;
+        {
+            LOCK(cs_main);
+            decoded.blockHash = ::ChainActive()[nHeight]->GetBlockHash();
+            decoded.nBlockTime = ::ChainActive()[nHeight]->GetBlockTime();
+        }
+        decoded.nBlock = nHeight;
+        decoded.nPosition = nPosition;
+        decoded.sender = sender;
+        decoded.reference = reference;
+        decoded.payload = CreatePayload_SimpleSend(COUNOS_PROPERTY_MSC, 100);
+        decoded.nEncodingClass = COUNOS_CLASS_C;
+
+        const uint256& txid = m_coinbase_txns[nHeight - 1]->GetHash();
+        LOCK(cs_tally);
+        pDbTransaction->RecordDecodedTransaction(txid, decoded);
+        return txid;
+    }
+
+    void WaitForSync(BaseIndex& index)
+    {
+        constexpr int64_t timeout_ms = 10 * 1000;
+        int64_t time_start = GetTimeMillis();
+        while (!index.BlockUntilSyncedToCurrentChain()) {
+            BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+            UninterruptibleSleep(std::chrono::milliseconds{100});
+        }
+    }
+
+    void StopScheduler()
+    {
+        // index job may be scheduled, so stop scheduler before destructing
+        m_node.scheduler->stop();
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+    }
+};
+
+std::vector<int> FindHeights(const CCounosAddressIndex& index, const std::string& address, int nStartHeight = 0,
+                             uint32_t nStartPosition = 0, int nEndHeight = 999999999, size_t nMaxEntries = 100)
+{
+    std::vector<CCounosAddressIndexEntry> entries;
+    BOOST_CHECK(index.FindTransactions(address, nStartHeight, nStartPosition, nEndHeight, nMaxEntries, entries));
+    std::vector<int> heights;
+    for (const CCounosAddressIndexEntry& entry : entries) {
+        heights.push_back(entry.nHeight);
+    }
+    return heights;
+}
+
+UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+{
+    JSONRPCRequest request;
+    request.strMethod = strMethod;
+    request.params = params;
+    request.fHelp = false;
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    return tableRPC.execute(request);
+}
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_addressindex_tests, AddressIndexTestingSetup)
+
+BOOST_AUTO_TEST_CASE(addressindex_initial_sync)
+{
+    CCounosAddressIndex index(1 << 20, true);
+
+    const uint256 txid10 = RecordDecoded(10, 256, "Alice", "Bob");
+    const uint256 txid20 = RecordDecoded(20, 1, "Alice");
+    RecordDecoded(30, 1, "Alicf");
+    RecordDecoded(40, 2, "Alice");
+    RecordDecoded(99, 1, "Alice");
+    RecordDecoded(100, 1, "Alice");
+
+    // a transaction, which was decoded in another block, is not indexed
+    const uint256 txid50 = RecordDecoded(50, 1, "Alice");
+    {
+        CDecodedTransactionRecord decoded;
+        LOCK(cs_tally);
+        BOOST_REQUIRE(pDbTransaction->FetchDecodedTransaction(txid50, decoded, false));
+        decoded.blockHash = uint256S("aa");
+        pDbTransaction->RecordDecodedTransaction(txid50, decoded);
+    }
+
+    // Transactions should not be found in the index before it is started.
+    BOOST_CHECK(FindHeights(index, "Alice").empty());
+
+    index.Start();
+    WaitForSync(index);
+
+    // the transactions of an address are ordered by block, and end before the next address
+    BOOST_CHECK(FindHeights(index, "Alice") == std::vector<int>({10, 20, 40, 99, 100}));
+    BOOST_CHECK(FindHeights(index, "Alicf") == std::vector<int>({30}));
+    BOOST_CHECK(FindHeights(index, "Bob") == std::vector<int>({10}));
+    BOOST_CHECK(FindHeights(index, "Carol").empty());
+
+    std::vector<CCounosAddressIndexEntry> entries;
+    BOOST_CHECK(index.FindTransactions("Alice", 0, 0, 20, 100, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    BOOST_CHECK(entries[0].txid == txid10);
+    BOOST_CHECK_EQUAL(entries[0].nPosition, 256U);
+    BOOST_CHECK(entries[1].txid == txid20);
+    BOOST_CHECK_EQUAL(entries[1].nPosition, 1U);
+
+    // the height and position are big-endian, so position 256 sorts after position 2
+    BOOST_CHECK(FindHeights(index, "Alice", 10, 2) == std::vector<int>({10, 20, 40, 99, 100}));
+    BOOST_CHECK(FindHeights(index, "Alice", 10, 257) == std::vector<int>({20, 40, 99, 100}));
+    BOOST_CHECK(FindHeights(index, "Alice", 20, 256) == std::vector<int>({40, 99, 100}));
+
+    // the lookup stops after the end block and the maximum number of entries
+    BOOST_CHECK(FindHeights(index, "Alice", 0, 0, 19) == std::vector<int>({10}));
+    BOOST_CHECK(FindHeights(index, "Alice", 0, 0, 9).empty());
+    BOOST_CHECK(FindHeights(index, "Alice", 0, 0, 999999999, 2) == std::vector<int>({10, 20}));
+    BOOST_CHECK(FindHeights(index, "Alice", 41).size() == 2U);
+
+    // when block 99 is connected again, the entries of the blocks above it are removed
+    CBlock block;
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return ::ChainActive()[99]);
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+    GetMainSignals().BlockConnected(std::make_shared<const CBlock>(block), pindex);
+    SyncWithValidationInterfaceQueue();
+
+    BOOST_CHECK(FindHeights(index, "Alice") == std::vector<int>({10, 20, 40, 99}));
+    BOOST_CHECK(FindHeights(index, "Alice", 99, 0, 100) == std::vector<int>({99}));
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    index.Stop();
+    StopScheduler();
+}
+
+BOOST_AUTO_TEST_CASE(listaddresstransactions_pages)
+{
+    const std::string address = EncodeDestination(PKHash(coinbaseKey.GetPubKey()));
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    const std::string other = EncodeDestination(PKHash(otherKey.GetPubKey()));
+    std::vector<std::string> expected;
+    for (int nHeight = 11; nHeight <= 15; ++nHeight) {
+        expected.push_back(RecordDecoded(nHeight, nHeight - 10, address).GetHex());
+    }
+    RecordDecoded(16, 1, other);
+
+    UniValue params(UniValue::VARR);
+    params.push_back(address);
+    BOOST_CHECK_THROW(CallRPC("counos_listaddresstransactions", params), UniValue);
+
+    g_counos_addressindex = MakeUnique<CCounosAddressIndex>(1 << 20, true);
+    g_counos_addressindex->Start();
+    WaitForSync(*g_counos_addressindex);
+
+    // the pages cover all transactions of the address in order, and the cursor points to the next one
+    std::vector<std::string> paged;
+    std::vector<std::string> cursors;
+    std::string cursor;
+    do {
+        UniValue pageParams(UniValue::VARR);
+        pageParams.push_back(address);
+        pageParams.push_back(NullUniValue);
+        pageParams.push_back(NullUniValue);
+        pageParams.push_back(cursor);
+        pageParams.push_back(2);
+        UniValue page = CallRPC("counos_listaddresstransactions", pageParams);
+        const UniValue& results = find_value(page, "results");
+        BOOST_CHECK(results.size() <= 2U);
+        for (size_t i = 0; i < results.size(); ++i) {
+            paged.push_back(find_value(results[i], "txid").get_str());
+        }
+        cursor = find_value(page, "cursor").get_str();
+        cursors.push_back(cursor);
+    } while (!cursor.empty() && cursors.size() < 10);
+
+    BOOST_CHECK(paged == expected);
+    BOOST_CHECK(cursors == std::vector<std::string>({"13:3", "15:5", ""}));
+
+    // the end block is honored, when the lookup is continued with a cursor
+    UniValue rangeParams(UniValue::VARR);
+    rangeParams.push_back(address);
+    rangeParams.push_back(0);
+    rangeParams.push_back(13);
+    rangeParams.push_back("12:2");
+    rangeParams.push_back(1);
+    UniValue page = CallRPC("counos_listaddresstransactions", rangeParams);
+    BOOST_REQUIRE_EQUAL(find_value(page, "results").size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(find_value(page, "results")[0], "txid").get_str(), expected[1]);
+    BOOST_CHECK_EQUAL(find_value(page, "cursor").get_str(), "13:3");
+    UniValue lastParams(UniValue::VARR);
+    lastParams.push_back(address);
+    lastParams.push_back(0);
+    lastParams.push_back(13);
+    lastParams.push_back("13:3");
+    lastParams.push_back(1);
+    page = CallRPC("counos_listaddresstransactions", lastParams);
+    BOOST_CHECK_EQUAL(find_value(page, "results").size(), 1U);
+    BOOST_CHECK(find_value(page, "cursor").get_str().empty());
+
+    // invalid cursors and limits are rejected
+    for (const char* badCursor : {"13", "13:3:1", "x:1", "-1:0"}) {
+        UniValue badParams(UniValue::VARR);
+        badParams.push_back(address);
+        badParams.push_back(NullUniValue);
+        badParams.push_back(NullUniValue);
+        badParams.push_back(badCursor);
+        BOOST_CHECK_THROW(CallRPC("counos_listaddresstransactions", badParams), UniValue);
+    }
+    for (int badLimit : {0, 1001}) {
+        UniValue badParams(UniValue::VARR);
+        badParams.push_back(address);
+        badParams.push_back(NullUniValue);
+        badParams.push_back(NullUniValue);
+        badParams.push_back("");
+        badParams.push_back(badLimit);
+        BOOST_CHECK_THROW(CallRPC("counos_listaddresstransactions", badParams), UniValue);
+    }
+
+    g_counos_addressindex->Stop();
+    g_counos_addressindex.reset();
+    StopScheduler();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
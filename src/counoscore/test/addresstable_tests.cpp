@@ -0,0 +1,78 @@
+#include <counoscore/addresstable.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/tally.h>
+
+#include <sync.h>
+#include <test/util/setup_common.h>
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_addresstable_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(addresses_are_interned_once)
+{
+    CAddressTable table;
+    BOOST_CHECK_EQUAL(table.size(), 0U);
+
+    AddressId idAlice = table.Intern("1AliceAddress");
+    AddressId idBob = table.Intern("3BobAddress");
+    BOOST_CHECK(idAlice != idBob);
+    BOOST_CHECK_EQUAL(table.Intern("1AliceAddress"), idAlice);
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+
+    BOOST_CHECK_EQUAL(table.GetAddress(idAlice), "1AliceAddress");
+    BOOST_CHECK_EQUAL(table.GetAddress(idBob), "3BobAddress");
+
+    AddressId id = 0;
+    BOOST_CHECK(table.Lookup("3BobAddress", id));
+    BOOST_CHECK_EQUAL(id, idBob);
+    BOOST_CHECK(!table.Lookup("1CarolAddress", id));
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(addresses_survive_rehashing)
+{
+    CAddressTable table;
+    for (int n = 0; n < 10000; ++n) {
+        BOOST_CHECK_EQUAL(table.Intern(std::to_string(n)), static_cast<AddressId>(n));
+    }
+    for (int n = 0; n < 10000; n += 997) {
+        BOOST_CHECK_EQUAL(table.GetAddress(n), std::to_string(n));
+    }
+
+    table.Clear();
+    BOOST_CHECK_EQUAL(table.size(), 0U);
+    BOOST_CHECK_EQUAL(table.Intern("9999"), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(tally_map_is_keyed_by_interned_address)
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+
+    // unknown addresses are not interned by lookups
+    size_t nAddresses = addressTable.size();
+    BOOST_CHECK(getTally("1UnknownTallyAddress") == nullptr);
+    BOOST_CHECK_EQUAL(GetTokenBalance("1UnknownTallyAddress", 3, BALANCE), 0);
+    BOOST_CHECK_EQUAL(addressTable.size(), nAddresses);
+
+    BOOST_CHECK(update_tally_map("1KnownTallyAddress", 3, 100, BALANCE));
+    AddressId id = 0;
+    BOOST_CHECK(addressTable.Lookup("1KnownTallyAddress", id));
+    BOOST_CHECK(getTally(id) != nullptr);
+    BOOST_CHECK(getTally(id) == getTally("1KnownTallyAddress"));
+    BOOST_CHECK_EQUAL(GetTokenBalance("1KnownTallyAddress", 3, BALANCE), 100);
+    BOOST_CHECK_EQUAL(mp_property_holders[3].count(CPropertyHolder(id)), 1U);
+
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+#include <counoscore/dbbase.h>
+#include <counoscore/dbtransaction.h>
+#include <counoscore/dbtxlist.h>
+
+#include <fs.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/** Stores the databases in one database for the duration of a test. */
+struct UnifiedDBTestingSetup : public BasicTestingSetup
+{
+    UnifiedDBTestingSetup()
+    {
+        gArgs.ForceSetArg("-counosunifieddb", "1");
+    }
+
+    ~UnifiedDBTestingSetup()
+    {
+        gArgs.ForceSetArg("-counosunifieddb", "0");
+    }
+};
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_dbbase_tests, UnifiedDBTestingSetup)
+
+BOOST_AUTO_TEST_CASE(unified_columns_are_separated)
+{
+    const uint256 txid = uint256S("01");
+    {
+        std::unique_ptr<CMPTxList> txlist{new CMPTxList(GetDataDir() / "MP_txlist", true)};
+        std::unique_ptr<CCounosTransactionDB> txdb{new CCounosTransactionDB(GetDataDir() / "Counos_TXDB", true)};
+        BOOST_CHECK(fs::exists(GetDataDir() / "COUNOS_db"));
+        BOOST_CHECK(!fs::exists(GetDataDir() / "MP_txlist"));
+
+        txlist->recordTX(txid, true, 100, 0, 1000);
+        txdb->RecordTransaction(txid, 7, 0);
+        BOOST_CHECK(txlist->exists(txid));
+        BOOST_CHECK_EQUAL(txdb->FetchTransactionPosition(txid), 7U);
+
+        // iterating over one column doesn't see the entries of the others
+        BOOST_CHECK_EQUAL(txlist->getMPTransactionCountTotal(), 1);
+
+        // clearing one column leaves the others untouched
+        txdb->Clear();
+        BOOST_CHECK(txlist->exists(txid));
+
+        SyncUnifiedDB();
+    }
+
+    // the entries are still available, once the database is reopened
+    std::unique_ptr<CMPTxList> txlist{new CMPTxList(GetDataDir() / "MP_txlist", false)};
+    BOOST_CHECK(txlist->exists(txid));
+    txlist.reset();
+
+    txlist.reset(new CMPTxList(GetDataDir() / "MP_txlist", true));
+    BOOST_CHECK(!txlist->exists(txid));
+}
+
+BOOST_AUTO_TEST_CASE(switching_layout_discards_the_other_one)
+{
+    const uint256 txid = uint256S("01");
+    {
+        std::unique_ptr<CMPTxList> txlist{new CMPTxList(GetDataDir() / "MP_txlist", false)};
+        txlist->recordTX(txid, true, 100, 0, 1000);
+    }
+
+    gArgs.ForceSetArg("-counosunifieddb", "0");
+    std::unique_ptr<CMPTxList> txlist{new CMPTxList(GetDataDir() / "MP_txlist", false)};
+    BOOST_CHECK(!fs::exists(GetDataDir() / "COUNOS_db"));
+    BOOST_CHECK(!txlist->exists(txid));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+#include <counoscore/dbbase.h>
+#include <counoscore/dbfees.h>
+
+#include <fs.h>
+#include <test/util/setup_common.h>
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_dbfees_tests, BasicTestingSetup)
+
+namespace {
+/** Fee cache, which allows to store raw values. */
+class CTestFeeCache : public CCounosFeeCache
+{
+public:
+    CTestFeeCache(const fs::path& path) : CCounosFeeCache(path, true) {}
+
+    void PutRaw(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+    }
+
+    std::string GetRaw(const std::string& key)
+    {
+        std::string value;
+        pdb->Get(readoptions, key, &value);
+        return value;
+    }
+};
+
+/** Fee history, which allows to store raw values. */
+class CTestFeeHistory : public CCounosFeeHistory
+{
+public:
+    CTestFeeHistory(const fs::path& path) : CCounosFeeHistory(path, true) {}
+
+    void PutRaw(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+    }
+
+    std::string GetRaw(const std::string& key)
+    {
+        std::string value;
+        pdb->Get(readoptions, key, &value);
+        return value;
+    }
+};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(legacy_fee_cache_is_migrated)
+{
+    std::unique_ptr<CTestFeeCache> feeCache{new CTestFeeCache(GetDataDir() / "COUNOS_feecache_test")};
+
+    feeCache->PutRaw("0000000003", "100:5,120:7");
+    feeCache->PutRaw("0000000004", ""); // rolled back cache
+
+    BOOST_CHECK_EQUAL(feeCache->GetCachedAmount(3), 7);
+    BOOST_CHECK_EQUAL(feeCache->GetCachedAmount(4), 0);
+    BOOST_CHECK_EQUAL(feeCache->GetCachedAmount(5), 0);
+
+    std::set<feeCacheItem> items = feeCache->GetCacheHistory(3);
+    BOOST_CHECK_EQUAL(items.size(), 2U);
+    BOOST_CHECK(items.count(std::make_pair(100, int64_t(5))));
+
+    const std::string value = feeCache->GetRaw("0000000003");
+    BOOST_CHECK_EQUAL(value[0], CCounosFeeCacheRecord::VERSION);
+    CCounosFeeCacheRecord record;
+    BOOST_CHECK(DecodeDBRecord(value, record));
+    BOOST_CHECK_EQUAL(record.ToString(), "100:5,120:7");
+}
+
+BOOST_AUTO_TEST_CASE(legacy_fee_history_is_migrated)
+{
+    std::unique_ptr<CTestFeeHistory> feeHistory{new CTestFeeHistory(GetDataDir() / "COUNOS_feehistory_test")};
+
+    feeHistory->PutRaw("1", "100:3:12:Alice=5,Bob=7");
+    std::set<feeHistoryItem> recipients;
+    recipients.insert(std::make_pair("Carol", 9));
+    feeHistory->RecordFeeDistribution(4, 110, 9, recipients);
+    BOOST_CHECK_EQUAL(feeHistory->CountRecords(), 2);
+
+    uint32_t propertyId = 0;
+    int block = 0;
+    int64_t total = 0;
+    BOOST_CHECK(feeHistory->GetDistributionData(1, &propertyId, &block, &total));
+    BOOST_CHECK_EQUAL(propertyId, 3U);
+    BOOST_CHECK_EQUAL(block, 100);
+    BOOST_CHECK_EQUAL(total, 12);
+    BOOST_CHECK_EQUAL(feeHistory->GetRaw("1")[0], CCounosFeeHistoryRecord::VERSION);
+
+    recipients = feeHistory->GetFeeDistribution(1);
+    BOOST_CHECK_EQUAL(recipients.size(), 2U);
+    BOOST_CHECK(recipients.count(std::make_pair(std::string("Bob"), int64_t(7))));
+
+    BOOST_CHECK(feeHistory->GetDistributionData(2, &propertyId, &block, &total));
+    BOOST_CHECK_EQUAL(propertyId, 4U);
+    BOOST_CHECK_EQUAL(block, 110);
+    BOOST_CHECK_EQUAL(feeHistory->GetDistributionsForProperty(4).size(), 1U);
+    BOOST_CHECK(!feeHistory->GetDistributionData(3, &propertyId, &block, &total));
+
+    feeHistory->RollBackHistory(105);
+    BOOST_CHECK_EQUAL(feeHistory->CountRecords(), 1);
+    BOOST_CHECK(feeHistory->GetDistributionsForProperty(4).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_dbspinfo_tests, BasicTestingSetup)
+
+static CMPSPInfo::Entry CreateEntry(const std::string& name, const uint256& block)
+{
+    CMPSPInfo::Entry info;
+    info.issuer = "Alice";
+    info.name = name;
+    info.prop_type = MSC_PROPERTY_TYPE_DIVISIBLE;
+    info.num_tokens = 1000;
+    info.fixed = true;
+    info.txid = uint256S("01");
+    info.creation_block = block;
+    info.update_block = block;
+    return info;
+}
+
+BOOST_AUTO_TEST_CASE(cached_entries_follow_updates)
+{
+    std::unique_ptr<CMPSPInfo> db{new CMPSPInfo(GetDataDir() / "COUNOS_spinfo_cache", true)};
+    const uint256 blockCreated = uint256S("aa");
+    const uint256 blockUpdated = uint256S("bb");
+
+    uint32_t propertyId = db->putSP(COUNOS_PROPERTY_MSC, CreateEntry("First", blockCreated));
+    BOOST_CHECK_EQUAL(3U, propertyId);
+
+    CMPSPInfo::Entry info;
+    BOOST_CHECK(db->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL("First", info.name);
+
+    CMPSPInfo::Summary summary;
+    BOOST_CHECK(db->getSPSummary(propertyId, summary));
+    BOOST_CHECK_EQUAL("Alice", summary.issuer);
+    BOOST_CHECK_EQUAL("First", summary.name);
+    BOOST_CHECK_EQUAL(1000, summary.num_tokens);
+    BOOST_CHECK(summary.ecosystem == COUNOS_PROPERTY_MSC);
+    BOOST_CHECK(summary.divisible);
+    BOOST_CHECK(summary.fixed);
+    BOOST_CHECK(!summary.manual);
+    BOOST_CHECK(!summary.unique);
+
+    // updates replace the cached entry
+    info.name = "Second";
+    info.issuer = "Bob";
+    info.update_block = blockUpdated;
+    BOOST_CHECK(db->updateSP(propertyId, info));
+    BOOST_CHECK(db->getSPSummary(propertyId, summary));
+    BOOST_CHECK_EQUAL("Bob", summary.issuer);
+    BOOST_CHECK_EQUAL("Second", summary.name);
+
+    // rolling back the update restores the previous entry
+    BOOST_CHECK_EQUAL(1, db->popBlock(blockUpdated));
+    BOOST_CHECK(db->getSP(propertyId, info));
+    BOOST_CHECK_EQUAL("Alice", info.issuer);
+    BOOST_CHECK_EQUAL("First", info.name);
+
+    // rolling back the creation removes the entry
+    BOOST_CHECK_EQUAL(0, db->popBlock(blockCreated));
+    BOOST_CHECK(!db->getSP(propertyId, info));
+    BOOST_CHECK(!db->getSPSummary(propertyId, summary));
+
+    db->init();
+    CMPSPInfo::Entry unique = CreateEntry("Unique", blockCreated);
+    unique.unique = true;
+    BOOST_CHECK_EQUAL(propertyId, db->putSP(COUNOS_PROPERTY_MSC, unique));
+    BOOST_CHECK(db->getSPSummary(propertyId, summary));
+    BOOST_CHECK(summary.unique);
+
+    db->Clear();
+    BOOST_CHECK(!db->getSPSummary(propertyId, summary));
+}
+
+BOOST_AUTO_TEST_CASE(implied_entries)
+{
+    std::unique_ptr<CMPSPInfo> db{new CMPSPInfo(GetDataDir() / "COUNOS_spinfo_implied", true)};
+
+    CMPSPInfo::Summary summary;
+    BOOST_CHECK(db->getSPSummary(COUNOS_PROPERTY_MSC, summary));
+    BOOST_CHECK(summary.divisible);
+    BOOST_CHECK(summary.ecosystem == COUNOS_PROPERTY_MSC);
+    BOOST_CHECK(db->getSPSummary(COUNOS_PROPERTY_TMSC, summary));
+    BOOST_CHECK(summary.ecosystem == COUNOS_PROPERTY_TMSC);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+#include <counoscore/dbtransaction.h>
+
+#include <arith_uint256.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_dbtransaction_tests, BasicTestingSetup)
+
+static CDecodedTransactionRecord CreateDecoded(const uint256& blockHash, int nBlock)
+{
+    CDecodedTransactionRecord decoded;
+    decoded.blockHash = blockHash;
+    decoded.nBlock = nBlock;
+    decoded.nBlockTime = 1500000000;
+    decoded.nPosition = 7;
+    decoded.nProcessingResult = -51;
+    decoded.sender = "Alice";
+    decoded.reference = "Bob";
+    decoded.payload.assign(16, 0x01);
+    decoded.nEncodingClass = 3;
+    decoded.nFee = 1000;
+    decoded.stmAddresses[1] = "Carol";
+    return decoded;
+}
+
+BOOST_AUTO_TEST_CASE(decoded_transactions_roundtrip)
+{
+    std::unique_ptr<CCounosTransactionDB> db{new CCounosTransactionDB(GetDataDir() / "Counos_TXDB_decoded", true)};
+    const uint256 txid = uint256S("01");
+    const uint256 blockHash = uint256S("aa");
+
+    CDecodedTransactionRecord decoded;
+    BOOST_CHECK(!db->FetchDecodedTransaction(txid, decoded));
+
+    // decoded transactions don't interfere with the regular records
+    db->RecordTransaction(txid, 7, -51);
+    db->RecordDecodedTransaction(txid, CreateDecoded(blockHash, 100));
+    BOOST_CHECK_EQUAL(db->FetchTransactionPosition(txid), 7U);
+
+    // the first lookup reads the database, the second one is served from memory
+    for (int n = 0; n < 2; ++n) {
+        BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+        BOOST_CHECK(decoded.blockHash == blockHash);
+        BOOST_CHECK_EQUAL(decoded.nBlock, 100);
+        BOOST_CHECK_EQUAL(decoded.nBlockTime, 1500000000);
+        BOOST_CHECK_EQUAL(decoded.nPosition, 7U);
+        BOOST_CHECK_EQUAL(decoded.nProcessingResult, -51);
+        BOOST_CHECK_EQUAL(decoded.sender, "Alice");
+        BOOST_CHECK_EQUAL(decoded.reference, "Bob");
+        BOOST_CHECK_EQUAL(decoded.payload.size(), 16U);
+        BOOST_CHECK_EQUAL(decoded.nEncodingClass, 3);
+        BOOST_CHECK_EQUAL(decoded.nFee, 1000U);
+        BOOST_CHECK_EQUAL(decoded.stmAddresses.size(), 1U);
+        BOOST_CHECK_EQUAL(decoded.stmAddresses[1], "Carol");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decoded_transactions_are_replaced_and_erased)
+{
+    std::unique_ptr<CCounosTransactionDB> db{new CCounosTransactionDB(GetDataDir() / "Counos_TXDB_reorg", true)};
+    const uint256 txid = uint256S("01");
+
+    CDecodedTransactionRecord decoded;
+    db->RecordDecodedTransaction(txid, CreateDecoded(uint256S("aa"), 100));
+    BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+
+    // confirmed again in another block, the entry in memory is replaced
+    db->RecordDecodedTransaction(txid, CreateDecoded(uint256S("bb"), 101));
+    BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+    BOOST_CHECK(decoded.blockHash == uint256S("bb"));
+    BOOST_CHECK_EQUAL(decoded.nBlock, 101);
+
+    db->EraseDecodedTransaction(txid);
+    BOOST_CHECK(!db->FetchDecodedTransaction(txid, decoded));
+}
+
+BOOST_AUTO_TEST_CASE(decoded_transactions_are_cleared)
+{
+    std::unique_ptr<CCounosTransactionDB> db{new CCounosTransactionDB(GetDataDir() / "Counos_TXDB_clear", true)};
+    const uint256 txid = uint256S("01");
+
+    CDecodedTransactionRecord decoded;
+    db->RecordDecodedTransaction(txid, CreateDecoded(uint256S("aa"), 100));
+    BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+
+    // the entry in memory is dropped with the database
+    db->Clear();
+    BOOST_CHECK(!db->FetchDecodedTransaction(txid, decoded));
+}
+
+BOOST_AUTO_TEST_CASE(decoded_cache_is_bounded)
+{
+    std::unique_ptr<CCounosTransactionDB> db{new CCounosTransactionDB(GetDataDir() / "Counos_TXDB_bounded", true)};
+    db->SetDecodedCacheSize(2);
+
+    CDecodedTransactionRecord decoded;
+    for (int n = 1; n <= 5; ++n) {
+        const uint256 txid = ArithToUint256(arith_uint256(n));
+        db->RecordDecodedTransaction(txid, CreateDecoded(uint256S("aa"), n));
+        BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+    }
+
+    // evicted transactions are still available from the database
+    for (int n = 1; n <= 5; ++n) {
+        const uint256 txid = ArithToUint256(arith_uint256(n));
+        BOOST_CHECK(db->FetchDecodedTransaction(txid, decoded));
+        BOOST_CHECK_EQUAL(decoded.nBlock, n);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
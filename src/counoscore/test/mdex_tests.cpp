@@ -0,0 +1,225 @@
+#include <counoscore/addresstable.h>
+#include <counoscore/consensushash.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/dbtxlist.h>
+#include <counoscore/mdex.h>
+#include <counoscore/sp.h>
+#include <counoscore/tally.h>
+
+#include <arith_uint256.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <limits>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+namespace {
+/** Provides the databases needed to match and cancel orders. */
+struct MetaDExTestingSetup : public BasicTestingSetup
+{
+    CMPSPInfo* pDbSpInfoOwned;
+    CMPTradeList* pDbTradeListOwned;
+    CMPTxList* pDbTransactionListOwned;
+
+    MetaDExTestingSetup() : pDbSpInfoOwned(nullptr), pDbTradeListOwned(nullptr), pDbTransactionListOwned(nullptr)
+    {
+        if (!pDbSpInfo) pDbSpInfo = pDbSpInfoOwned = new CMPSPInfo(GetDataDir() / "COUNOS_spinfo", true);
+        if (!pDbTradeList) pDbTradeList = pDbTradeListOwned = new CMPTradeList(GetDataDir() / "COUNOS_tradelist", true);
+        if (!pDbTransactionList) pDbTransactionList = pDbTransactionListOwned = new CMPTxList(GetDataDir() / "COUNOS_txlist", true);
+        ClearState();
+    }
+
+    ~MetaDExTestingSetup()
+    {
+        ClearState();
+        if (pDbSpInfoOwned) { delete pDbSpInfoOwned; pDbSpInfo = nullptr; }
+        if (pDbTradeListOwned) { delete pDbTradeListOwned; pDbTradeList = nullptr; }
+        if (pDbTransactionListOwned) { delete pDbTransactionListOwned; pDbTransactionList = nullptr; }
+    }
+
+    void ClearState()
+    {
+        LOCK(cs_tally);
+        mp_tally_map.clear();
+        mp_property_holders.clear();
+        mp_property_totals.clear();
+        MetaDEx_CLEAR();
+        addressTable.Clear();
+        for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+            ClearStateHash(static_cast<StateHashPart>(part));
+        }
+    }
+};
+
+uint256 TxidFromNumber(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+//! Funds the address and places an order, which is expected to rest in the order book
+void AddOrder(const std::string& address, uint32_t property, int64_t amount, uint32_t desired, int64_t amountDesired, uint64_t n)
+{
+    BOOST_CHECK(update_tally_map(address, property, amount, BALANCE));
+    BOOST_CHECK_EQUAL(MetaDEx_ADD(address, property, amount, 100, desired, amountDesired, TxidFromNumber(n), n), 0);
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(n)));
+}
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_mdex_tests, MetaDExTestingSetup)
+
+BOOST_AUTO_TEST_CASE(orders_are_found_by_txid)
+{
+    LOCK(cs_tally);
+
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Alice", 100, 3, 100, 1, 200, TxidFromNumber(1), 1, 1)));
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Alice", 100, 3, 100, 4, 300, TxidFromNumber(2), 2, 1)));
+    BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Bob", 100, 1, 50, 3, 10, TxidFromNumber(3), 3, 1)));
+    // the same block and position can't be inserted twice
+    BOOST_CHECK(!MetaDEx_INSERT(CMPMetaDEx("Bob", 100, 1, 50, 3, 10, TxidFromNumber(4), 3, 1)));
+
+    BOOST_CHECK_EQUAL(metadex.size(), 3U);
+    BOOST_CHECK(get_Prices(3, 1) != nullptr);
+    BOOST_CHECK(get_Prices(3, 4) != nullptr);
+    BOOST_CHECK(get_Prices(1, 4) == nullptr);
+
+    const CMPMetaDEx* trade = MetaDEx_RetrieveTrade(TxidFromNumber(2));
+    BOOST_REQUIRE(trade != nullptr);
+    BOOST_CHECK_EQUAL(trade->getAddr(), "Alice");
+    BOOST_CHECK_EQUAL(trade->getDesProperty(), 4U);
+    BOOST_CHECK(MetaDEx_RetrieveTrade(TxidFromNumber(4)) == nullptr);
+
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(3)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(3), 1));
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(3), 3));
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(5)));
+
+    MetaDEx_CLEAR();
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(1)));
+    BOOST_CHECK(MetaDEx_RetrieveTrade(TxidFromNumber(1)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(matching_stops_at_first_non_crossing_price)
+{
+    LOCK(cs_tally);
+
+    AddOrder("Alice", 3, 100, 1, 100, 1); // price 1
+    AddOrder("Carol", 3, 100, 1, 300, 2); // price 3
+    AddOrder("Dave", 3, 100, 4, 100, 3);  // price 1, but for another property
+
+    // Bob pays up to 1.5 per token, so only Alice's offer crosses
+    BOOST_CHECK(update_tally_map("Bob", 1, 150, BALANCE));
+    BOOST_CHECK_EQUAL(MetaDEx_ADD("Bob", 1, 150, 101, 3, 100, TxidFromNumber(4), 1), 0);
+
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(1)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(2)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(3)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(4)));
+    // the filled price level is gone
+    BOOST_CHECK_EQUAL(get_Prices(3, 1)->size(), 1U);
+
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 3, BALANCE), 100);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 1, METADEX_RESERVE), 50);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 1, BALANCE), 100);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Carol", 3, METADEX_RESERVE), 100);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Dave", 3, METADEX_RESERVE), 100);
+
+    const CMPMetaDEx* remainder = MetaDEx_RetrieveTrade(TxidFromNumber(4));
+    BOOST_REQUIRE(remainder != nullptr);
+    BOOST_CHECK_EQUAL(remainder->getAmountRemaining(), 50);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+}
+
+BOOST_AUTO_TEST_CASE(partially_filled_orders_stay_indexed)
+{
+    LOCK(cs_tally);
+
+    AddOrder("Alice", 3, 100, 1, 100, 1);
+
+    BOOST_CHECK(update_tally_map("Bob", 1, 40, BALANCE));
+    BOOST_CHECK_EQUAL(MetaDEx_ADD("Bob", 1, 40, 101, 3, 40, TxidFromNumber(2), 1), 0);
+
+    const CMPMetaDEx* trade = MetaDEx_RetrieveTrade(TxidFromNumber(1));
+    BOOST_REQUIRE(trade != nullptr);
+    BOOST_CHECK_EQUAL(trade->getAmountRemaining(), 60);
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(2)));
+}
+
+BOOST_AUTO_TEST_CASE(cancellations_update_the_index)
+{
+    LOCK(cs_tally);
+
+    // nothing was ever offered for the property
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(TxidFromNumber(9), 102, "Alice", 3, 100, 1, 100), METADEX_ERROR -21);
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_ALL_FOR_PAIR(TxidFromNumber(9), 102, "Alice", 3, 1), METADEX_ERROR -31);
+
+    AddOrder("Alice", 3, 100, 1, 100, 1);
+    AddOrder("Alice", 3, 100, 1, 200, 2);
+    AddOrder("Alice", 3, 100, 4, 100, 3);
+    AddOrder("Alice", 5, 100, 1, 100, 4);
+    AddOrder("Bob", 3, 100, 1, 100, 5);
+
+    // there are offers for the property, but not for the pair
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(TxidFromNumber(9), 102, "Alice", 3, 100, 6, 100), METADEX_ERROR -20);
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_ALL_FOR_PAIR(TxidFromNumber(9), 102, "Alice", 3, 6), METADEX_ERROR -30);
+
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(TxidFromNumber(10), 102, "Alice", 3, 100, 1, 200), 0);
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(1)));
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(2)));
+
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_ALL_FOR_PAIR(TxidFromNumber(11), 102, "Alice", 3, 1), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(1)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(3)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(5)));
+
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_EVERYTHING(TxidFromNumber(12), 102, "Alice", 1), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(3)));
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(4)));
+    BOOST_CHECK(MetaDEx_isOpen(TxidFromNumber(5)));
+
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 3, BALANCE), 300);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 3, METADEX_RESERVE), 0);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 5, BALANCE), 100);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    BOOST_CHECK_EQUAL(MetaDEx_SHUTDOWN(), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(TxidFromNumber(5)));
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 3, BALANCE), 100);
+}
+
+BOOST_AUTO_TEST_CASE(price_comparison_matches_rational)
+{
+    const int64_t max = std::numeric_limits<int64_t>::max();
+
+    BOOST_CHECK(price_t(1, 2) == price_t(2, 4));
+    BOOST_CHECK(price_t(1, 3) < price_t(1, 2));
+    BOOST_CHECK(price_t(max, 1) > price_t(max - 1, 1));
+    BOOST_CHECK(price_t(max - 1, max) < price_t(max, max - 1));
+    BOOST_CHECK(price_t(max, max) == price_t(1, 1));
+    BOOST_CHECK(price_t(0, 5) == price_t());
+    BOOST_CHECK(price_t(-1, 2) < price_t());
+    BOOST_CHECK(price_t(1, -2) == price_t(-1, 2));
+
+    for (int i = 0; i < 10000; ++i) {
+        // small amounts are more likely to be equal
+        const int64_t range = (i % 2) ? 10 : max;
+        const price_t a(InsecureRandRange(range), 1 + InsecureRandRange(range));
+        const price_t b(InsecureRandRange(range), 1 + InsecureRandRange(range));
+        const rational_t ra = a.toRational();
+        const rational_t rb = b.toRational();
+
+        BOOST_CHECK_EQUAL(a == b, ra == rb);
+        BOOST_CHECK_EQUAL(a < b, ra < rb);
+        BOOST_CHECK_EQUAL(a > b, ra > rb);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,12 @@
 #include <counoscore/counoscore.h>
 #include <counoscore/nftdb.h>
 
+#include <map>
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <test/util/setup_common.h>
 
@@ -118,4 +121,94 @@ BOOST_AUTO_TEST_CASE(nftdb_test_sequence)
     BOOST_CHECK_EQUAL("Bob", UITDb->GetNonFungibleTokenValueInRange(50, 2300, 2400));
 }
 
+BOOST_AUTO_TEST_CASE(nftdb_highest_range_end)
+{
+    LOCK(cs_tally);
+    const boost::filesystem::path path = GetDataDir() / "COUNOS_nftdb_highest";
+    {
+        std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, true)};
+        BOOST_CHECK_EQUAL(0, UITDb->GetHighestRangeEnd(50));
+
+        UITDb->CreateNonFungibleTokens(50, 1000, "Alice", "");
+        UITDb->CreateNonFungibleTokens(51, 10, "Alice", "");
+        UITDb->CreateNonFungibleTokens(50, 500, "Bob", "");
+        BOOST_CHECK_EQUAL(1500, UITDb->GetHighestRangeEnd(50));
+        BOOST_CHECK_EQUAL(10, UITDb->GetHighestRangeEnd(51));
+
+        // moving tokens splits and merges ranges, but doesn't change the number of tokens
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1500, 1500, "Bob", "Alice"));
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1001, 1499, "Bob", "Alice"));
+        BOOST_CHECK_EQUAL(1500, UITDb->GetHighestRangeEnd(50));
+    }
+    {
+        // the highest range ends are restored from the database
+        std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, false)};
+        BOOST_CHECK_EQUAL(1500, UITDb->GetHighestRangeEnd(50));
+        BOOST_CHECK_EQUAL(10, UITDb->GetHighestRangeEnd(51));
+
+        std::pair<int64_t, int64_t> range = UITDb->CreateNonFungibleTokens(51, 5, "Bob", "");
+        BOOST_CHECK_EQUAL(11, range.first);
+        BOOST_CHECK_EQUAL(15, UITDb->GetHighestRangeEnd(51));
+
+        UITDb->Clear();
+        BOOST_CHECK_EQUAL(0, UITDb->GetHighestRangeEnd(50));
+        BOOST_CHECK_EQUAL(0, UITDb->GetHighestRangeEnd(51));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(nftdb_owned_ranges)
+{
+    const boost::filesystem::path path = GetDataDir() / "COUNOS_nftdb_owned";
+    {
+        std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, true)};
+        UITDb->CreateNonFungibleTokens(60, 100, "Alice", "");
+        UITDb->CreateNonFungibleTokens(61, 10, "Bob", "");
+
+        // split the range of Alice into three
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(60, 40, 59, "Alice", "Bob"));
+        BOOST_CHECK(!UITDb->MoveNonFungibleTokens(60, 30, 45, "Alice", "Bob"));
+        BOOST_CHECK_EQUAL("Bob", UITDb->GetNonFungibleTokenValue(60, 40, NonFungibleStorage::RangeIndex));
+        BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValue(60, 60, NonFungibleStorage::RangeIndex));
+        BOOST_CHECK_EQUAL("", UITDb->GetNonFungibleTokenValue(60, 101, NonFungibleStorage::RangeIndex));
+        BOOST_CHECK_EQUAL("Bob", UITDb->GetNonFungibleTokenValueInRange(60, 45, 59));
+        BOOST_CHECK_EQUAL("", UITDb->GetNonFungibleTokenValueInRange(60, 45, 60));
+
+        std::map<uint32_t, std::vector<std::pair<int64_t, int64_t>>> owned = UITDb->GetAddressNonFungibleTokens(60, "Alice");
+        BOOST_CHECK_EQUAL(1U, owned.size());
+        BOOST_CHECK_EQUAL(2U, owned[60].size());
+        BOOST_CHECK(owned[60][0] == std::make_pair(int64_t{1}, int64_t{39}));
+        BOOST_CHECK(owned[60][1] == std::make_pair(int64_t{60}, int64_t{100}));
+
+        // merge the ranges of Bob with the adjacent tokens on both sides
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(60, 39, 39, "Alice", "Bob"));
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(60, 60, 60, "Alice", "Bob"));
+        BOOST_CHECK(UITDb->GetRange(60, 50, NonFungibleStorage::RangeIndex) == std::make_pair(int64_t{39}, int64_t{60}));
+
+        owned = UITDb->GetAddressNonFungibleTokens(0, "Bob");
+        BOOST_CHECK_EQUAL(2U, owned.size());
+        BOOST_CHECK_EQUAL(1U, owned[60].size());
+        BOOST_CHECK(owned[60][0] == std::make_pair(int64_t{39}, int64_t{60}));
+        BOOST_CHECK_EQUAL(1U, owned[61].size());
+        BOOST_CHECK(owned[61][0] == std::make_pair(int64_t{1}, int64_t{10}));
+    }
+    {
+        // the owned ranges are loaded from the database again
+        std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, false)};
+        std::vector<std::pair<std::string, std::pair<int64_t, int64_t>>> ranges = UITDb->GetNonFungibleTokenRanges(60);
+        BOOST_CHECK_EQUAL(3U, ranges.size());
+        BOOST_CHECK(ranges[0] == std::make_pair(std::string("Alice"), std::make_pair(int64_t{1}, int64_t{38})));
+        BOOST_CHECK(ranges[1] == std::make_pair(std::string("Bob"), std::make_pair(int64_t{39}, int64_t{60})));
+        BOOST_CHECK(ranges[2] == std::make_pair(std::string("Alice"), std::make_pair(int64_t{61}, int64_t{100})));
+
+        BOOST_CHECK(UITDb->MoveNonFungibleTokens(60, 39, 60, "Bob", "Alice"));
+        BOOST_CHECK_EQUAL(1U, UITDb->GetNonFungibleTokenRanges(60).size());
+        BOOST_CHECK(UITDb->GetAddressNonFungibleTokens(60, "Bob").empty());
+        BOOST_CHECK_EQUAL(1U, UITDb->GetAddressNonFungibleTokens(0, "Bob").size());
+
+        UITDb->Clear();
+        BOOST_CHECK(UITDb->GetAddressNonFungibleTokens(0, "Alice").empty());
+        BOOST_CHECK(UITDb->GetNonFungibleTokenRanges(60).empty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
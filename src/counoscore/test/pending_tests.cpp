@@ -0,0 +1,105 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/pending.h>
+#include <counoscore/tally.h>
+
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <uint256.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <stdint.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_pending_tests, TestingSetup)
+
+static const uint32_t PENDING_PROPERTY = 3;
+
+static CTransactionRef CreateTransaction(uint32_t nLockTime)
+{
+    CMutableTransaction mutableTx;
+    mutableTx.vin.resize(1);
+    mutableTx.vin[0].scriptSig = CScript() << OP_11;
+    mutableTx.vout.resize(1);
+    mutableTx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    mutableTx.vout[0].nValue = 10 * COIN;
+    mutableTx.nLockTime = nLockTime;
+    return MakeTransactionRef(mutableTx);
+}
+
+static void AddToMempool(const CTransactionRef& tx)
+{
+    LOCK2(cs_main, mempool.cs);
+    mempool.addUnchecked(TestMemPoolEntryHelper().FromTx(tx));
+}
+
+static bool IsPending(const uint256& txid)
+{
+    LOCK(cs_pending);
+    return my_pending.count(txid) > 0;
+}
+
+static void ClearTallies()
+{
+    LOCK2(cs_tally, cs_pending);
+    my_pending.clear();
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    addressTable.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(pending_check_keeps_mempool_transactions)
+{
+    CTransactionRef txInMempool = CreateTransaction(1);
+    CTransactionRef txDropped = CreateTransaction(2);
+    AddToMempool(txInMempool);
+
+    BOOST_CHECK(update_tally_map("Alice", PENDING_PROPERTY, 100, BALANCE));
+    PendingAdd(txInMempool->GetHash(), "Alice", 0, PENDING_PROPERTY, 30);
+    PendingAdd(txDropped->GetHash(), "Alice", 0, PENDING_PROPERTY, 20);
+    BOOST_CHECK_EQUAL(-50, GetTokenBalance("Alice", PENDING_PROPERTY, PENDING));
+
+    {
+        LOCK(cs_tally);
+        PendingCheck();
+    }
+    BOOST_CHECK(IsPending(txInMempool->GetHash()));
+    BOOST_CHECK(!IsPending(txDropped->GetHash()));
+    BOOST_CHECK_EQUAL(-30, GetTokenBalance("Alice", PENDING_PROPERTY, PENDING));
+
+    ClearTallies();
+}
+
+BOOST_AUTO_TEST_CASE(removed_transactions_are_no_longer_pending)
+{
+    PendingRegisterNotifications();
+
+    CTransactionRef tx = CreateTransaction(3);
+    AddToMempool(tx);
+
+    BOOST_CHECK(update_tally_map("Bob", PENDING_PROPERTY, 100, BALANCE));
+    PendingAdd(tx->GetHash(), "Bob", 0, PENDING_PROPERTY, 40);
+    BOOST_CHECK_EQUAL(-40, GetTokenBalance("Bob", PENDING_PROPERTY, PENDING));
+
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*tx, MemPoolRemovalReason::EXPIRY);
+    }
+    SyncWithValidationInterfaceQueue();
+
+    BOOST_CHECK(!IsPending(tx->GetHash()));
+    BOOST_CHECK_EQUAL(0, GetTokenBalance("Bob", PENDING_PROPERTY, PENDING));
+
+    PendingUnregisterNotifications();
+    ClearTallies();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/persistence.h>
+#include <counoscore/tally.h>
+
+#include <fs.h>
+#include <hash.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_persistence_tests, BasicTestingSetup)
+
+//! File type of the balances, as used by RestoreInMemoryState()
+static const int FILETYPE_BALANCES = 0;
+
+/** Writes a state file with the given lines, which is terminated by their hash. */
+static std::string WriteStateFile(const std::string& name, const std::vector<std::string>& lines, bool fCorruptHash)
+{
+    const fs::path path = GetDataDir() / name;
+    std::ofstream file(path.string().c_str());
+
+    CHash256 hasher;
+    for (std::vector<std::string>::const_iterator it = lines.begin(); it != lines.end(); ++it) {
+        hasher.Write((const unsigned char*)it->c_str(), it->length());
+        file << *it << "\r\n";
+    }
+
+    uint256 hash;
+    hasher.Finalize(hash.begin());
+    if (fCorruptHash) *hash.begin() ^= 0x01;
+    file << "!" << hash.ToString() << std::endl;
+
+    return path.string();
+}
+
+BOOST_AUTO_TEST_CASE(balances_are_restored)
+{
+    std::vector<std::string> lines;
+    lines.push_back("Alice=3:100,0,0,40;31:-0,0,0,0;");
+    lines.push_back("Bob=3:50,1,2,3;2147483651:9223372036854775807,0,0,0;");
+    const std::string filename = WriteStateFile("balances-restore.dat", lines, false);
+
+    LOCK(cs_tally);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(filename, FILETYPE_BALANCES, true), 0);
+
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 3, BALANCE), 100);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Alice", 3, METADEX_RESERVE), 40);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 3, SELLOFFER_RESERVE), 1);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 3, ACCEPT_RESERVE), 2);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 3, METADEX_RESERVE), 3);
+    BOOST_CHECK_EQUAL(GetTokenBalance("Bob", 2147483651U, BALANCE), 9223372036854775807LL);
+
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 196);
+    BOOST_CHECK_EQUAL(mp_property_holders[3].size(), 2U);
+    BOOST_CHECK(mp_property_holders.find(31) == mp_property_holders.end());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_files_are_rejected)
+{
+    std::vector<std::string> lines;
+    lines.push_back("Alice=3:100,0,0,0;");
+
+    LOCK(cs_tally);
+    const std::string corrupted = WriteStateFile("balances-corrupted.dat", lines, true);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(corrupted, FILETYPE_BALANCES, true), -1);
+
+    lines.push_back("Bob=3:100,0,0;");
+    const std::string truncated = WriteStateFile("balances-truncated.dat", lines, false);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(truncated, FILETYPE_BALANCES, true), -1);
+
+    lines.back() = "Bob=3:9223372036854775808,0,0,0;";
+    const std::string overflow = WriteStateFile("balances-overflow.dat", lines, false);
+    BOOST_CHECK_EQUAL(RestoreInMemoryState(overflow, FILETYPE_BALANCES, true), -1);
+
+    BOOST_CHECK_EQUAL(RestoreInMemoryState((GetDataDir() / "missing.dat").string(), FILETYPE_BALANCES, true), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
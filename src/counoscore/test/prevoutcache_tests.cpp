@@ -0,0 +1,70 @@
+#include <counoscore/prevoutcache.h>
+
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_prevoutcache_tests, BasicTestingSetup)
+
+static Coin MakeCoin(CAmount nValue, int nHeight)
+{
+    return Coin(CTxOut(nValue, CScript()), nHeight, false);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_are_evicted)
+{
+    CPrevoutCache cache(2);
+    const COutPoint outA(uint256S("01"), 0);
+    const COutPoint outB(uint256S("01"), 1);
+    const COutPoint outC(uint256S("02"), 0);
+
+    cache.Add(outA, MakeCoin(100, 10));
+    cache.Add(outB, MakeCoin(200, 10));
+
+    Coin coin;
+    BOOST_CHECK(cache.Get(outA, coin));
+    BOOST_CHECK_EQUAL(coin.out.nValue, 100);
+
+    // B is the least recently used entry now
+    cache.Add(outC, MakeCoin(300, 11));
+    BOOST_CHECK_EQUAL(cache.GetSize(), 2U);
+    BOOST_CHECK(!cache.Get(outB, coin));
+    BOOST_CHECK(cache.Get(outA, coin));
+    BOOST_CHECK(cache.Get(outC, coin));
+    BOOST_CHECK_EQUAL(coin.out.nValue, 300);
+    BOOST_CHECK_EQUAL(cache.GetHits(), 3U);
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 1U);
+
+    cache.SetMaxSize(1);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 1U);
+    BOOST_CHECK(cache.Get(outC, coin));
+    BOOST_CHECK(!cache.Get(outA, coin));
+}
+
+BOOST_AUTO_TEST_CASE(disconnected_outputs_are_removed)
+{
+    CPrevoutCache cache(100);
+    const COutPoint outA(uint256S("01"), 0);
+    const COutPoint outB(uint256S("02"), 0);
+    const COutPoint outC(uint256S("03"), 0);
+
+    cache.Add(outA, MakeCoin(100, 10));
+    cache.Add(outB, MakeCoin(200, 11));
+    cache.Add(outC, MakeCoin(300, 12));
+
+    cache.RemoveAbove(11);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 1U);
+
+    Coin coin;
+    BOOST_CHECK(cache.Get(outA, coin));
+    BOOST_CHECK(!cache.Get(outB, coin));
+    BOOST_CHECK(!cache.Get(outC, coin));
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.GetSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
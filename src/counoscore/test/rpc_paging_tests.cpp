@@ -0,0 +1,254 @@
+#include <counoscore/addresstable.h>
+#include <counoscore/consensushash.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/dbtxlist.h>
+#include <counoscore/mdex.h>
+#include <counoscore/sp.h>
+#include <counoscore/tally.h>
+
+#include <arith_uint256.h>
+#include <rpc/server.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <univalue.h>
+#include <util/system.h>
+
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+namespace {
+/** Provides a property database of its own, the databases to look up the order status, and clears the state touched by the tests. */
+struct PagingTestingSetup : public TestingSetup
+{
+    CMPSPInfo* pDbSpInfoSaved;
+    CMPTradeList* pDbTradeListOwned;
+    CMPTxList* pDbTransactionListOwned;
+
+    PagingTestingSetup() : pDbSpInfoSaved(pDbSpInfo), pDbTradeListOwned(nullptr), pDbTransactionListOwned(nullptr)
+    {
+        pDbSpInfo = new CMPSPInfo(GetDataDir() / "COUNOS_spinfo_paging", true);
+        if (!pDbTradeList) pDbTradeList = pDbTradeListOwned = new CMPTradeList(GetDataDir() / "COUNOS_tradelist_paging", true);
+        if (!pDbTransactionList) pDbTransactionList = pDbTransactionListOwned = new CMPTxList(GetDataDir() / "COUNOS_txlist_paging", true);
+        ClearState();
+    }
+
+    ~PagingTestingSetup()
+    {
+        ClearState();
+        delete pDbSpInfo;
+        pDbSpInfo = pDbSpInfoSaved;
+        if (pDbTradeListOwned) { delete pDbTradeListOwned; pDbTradeList = nullptr; }
+        if (pDbTransactionListOwned) { delete pDbTransactionListOwned; pDbTransactionList = nullptr; }
+    }
+
+    void ClearState()
+    {
+        LOCK(cs_tally);
+        mp_tally_map.clear();
+        mp_property_holders.clear();
+        mp_property_totals.clear();
+        MetaDEx_CLEAR();
+        addressTable.Clear();
+        for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+            ClearStateHash(static_cast<StateHashPart>(part));
+        }
+    }
+};
+
+UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+{
+    JSONRPCRequest request;
+    request.strMethod = strMethod;
+    request.params = params;
+    request.fHelp = false;
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    return tableRPC.execute(request);
+}
+
+UniValue Params(const UniValue& first, const std::string& cursor, int limit)
+{
+    UniValue params(UniValue::VARR);
+    params.push_back(first);
+    params.push_back(cursor);
+    params.push_back(limit);
+    return params;
+}
+
+CMPSPInfo::Entry CreateEntry(const std::string& name)
+{
+    CMPSPInfo::Entry info;
+    info.issuer = "Alice";
+    info.name = name;
+    info.prop_type = MSC_PROPERTY_TYPE_INDIVISIBLE;
+    info.num_tokens = 1000;
+    info.fixed = true;
+    info.txid = uint256S("01");
+    return info;
+}
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_rpc_paging_tests, PagingTestingSetup)
+
+BOOST_AUTO_TEST_CASE(listproperties_pages)
+{
+    std::vector<uint32_t> expected = {COUNOS_PROPERTY_MSC, COUNOS_PROPERTY_TMSC};
+    for (int n = 0; n < 3; ++n) {
+        expected.push_back(pDbSpInfo->putSP(COUNOS_PROPERTY_MSC, CreateEntry("Main")));
+        expected.push_back(pDbSpInfo->putSP(COUNOS_PROPERTY_TMSC, CreateEntry("Test")));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    UniValue all = CallRPC("counos_listproperties", UniValue(UniValue::VARR));
+    BOOST_REQUIRE_EQUAL(all.size(), expected.size());
+
+    // the pages cover all properties in order, across both ecosystems
+    std::vector<uint32_t> paged;
+    std::string cursor;
+    int nPages = 0;
+    do {
+        UniValue params(UniValue::VARR);
+        params.push_back(cursor);
+        params.push_back(3);
+        UniValue page = CallRPC("counos_listproperties", params);
+        const UniValue& results = find_value(page, "results");
+        BOOST_CHECK(results.size() <= 3U);
+        for (size_t i = 0; i < results.size(); ++i) {
+            paged.push_back(find_value(results[i], "propertyid").get_int64());
+        }
+        cursor = find_value(page, "cursor").get_str();
+        ++nPages;
+    } while (!cursor.empty() && nPages < 10);
+
+    BOOST_CHECK(paged == expected);
+    BOOST_CHECK_EQUAL(nPages, 3);
+
+    UniValue params(UniValue::VARR);
+    params.push_back("x");
+    BOOST_CHECK_THROW(CallRPC("counos_listproperties", params), UniValue);
+    params = UniValue(UniValue::VARR);
+    params.push_back("");
+    params.push_back(-1);
+    BOOST_CHECK_THROW(CallRPC("counos_listproperties", params), UniValue);
+}
+
+BOOST_AUTO_TEST_CASE(getallbalancesforid_pages)
+{
+    {
+        LOCK(cs_tally);
+        BOOST_CHECK(update_tally_map("Eve", COUNOS_PROPERTY_MSC, 5, BALANCE));
+        BOOST_CHECK(update_tally_map("Bob", COUNOS_PROPERTY_MSC, 2, BALANCE));
+        BOOST_CHECK(update_tally_map("Dave", COUNOS_PROPERTY_MSC, 4, BALANCE));
+        BOOST_CHECK(update_tally_map("Alice", COUNOS_PROPERTY_MSC, 1, BALANCE));
+        BOOST_CHECK(update_tally_map("Carol", COUNOS_PROPERTY_MSC, 3, METADEX_RESERVE));
+        BOOST_CHECK(update_tally_map("Frank", COUNOS_PROPERTY_TMSC, 6, BALANCE));
+    }
+
+    UniValue params(UniValue::VARR);
+    params.push_back((int64_t) COUNOS_PROPERTY_MSC);
+    UniValue all = CallRPC("counos_getallbalancesforid", params);
+    BOOST_REQUIRE_EQUAL(all.size(), 5U);
+
+    // the balances are ordered by address, and reserved amounts are included
+    UniValue page = CallRPC("counos_getallbalancesforid", Params((int64_t) COUNOS_PROPERTY_MSC, "", 2));
+    UniValue results = find_value(page, "results");
+    BOOST_REQUIRE_EQUAL(results.size(), 2U);
+    BOOST_CHECK_EQUAL(find_value(results[0], "address").get_str(), "Alice");
+    BOOST_CHECK_EQUAL(find_value(results[1], "address").get_str(), "Bob");
+    BOOST_CHECK_EQUAL(find_value(page, "cursor").get_str(), "Carol");
+
+    page = CallRPC("counos_getallbalancesforid", Params((int64_t) COUNOS_PROPERTY_MSC, "Carol", 2));
+    results = find_value(page, "results");
+    BOOST_REQUIRE_EQUAL(results.size(), 2U);
+    BOOST_CHECK_EQUAL(find_value(results[0], "address").get_str(), "Carol");
+    BOOST_CHECK_EQUAL(find_value(results[0], "reserved").get_str(), "0.00000003");
+    BOOST_CHECK_EQUAL(find_value(results[1], "address").get_str(), "Dave");
+    BOOST_CHECK_EQUAL(find_value(page, "cursor").get_str(), "Eve");
+
+    page = CallRPC("counos_getallbalancesforid", Params((int64_t) COUNOS_PROPERTY_MSC, "Eve", 2));
+    results = find_value(page, "results");
+    BOOST_REQUIRE_EQUAL(results.size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(results[0], "address").get_str(), "Eve");
+    BOOST_CHECK_EQUAL(find_value(results[0], "balance").get_str(), "0.00000005");
+    BOOST_CHECK(find_value(page, "cursor").get_str().empty());
+
+    // the cursor doesn't need to be a holder
+    page = CallRPC("counos_getallbalancesforid", Params((int64_t) COUNOS_PROPERTY_MSC, "Bz", 10));
+    results = find_value(page, "results");
+    BOOST_REQUIRE_EQUAL(results.size(), 3U);
+    BOOST_CHECK_EQUAL(find_value(results[0], "address").get_str(), "Carol");
+    BOOST_CHECK(find_value(page, "cursor").get_str().empty());
+
+    // holders, whose balance is gone, are no longer listed
+    {
+        LOCK(cs_tally);
+        BOOST_CHECK(update_tally_map("Bob", COUNOS_PROPERTY_MSC, -2, BALANCE));
+    }
+    page = CallRPC("counos_getallbalancesforid", Params((int64_t) COUNOS_PROPERTY_MSC, "", 2));
+    results = find_value(page, "results");
+    BOOST_REQUIRE_EQUAL(results.size(), 2U);
+    BOOST_CHECK_EQUAL(find_value(results[1], "address").get_str(), "Carol");
+}
+
+BOOST_AUTO_TEST_CASE(getorderbook_pages)
+{
+    const uint32_t propertyId = pDbSpInfo->putSP(COUNOS_PROPERTY_MSC, CreateEntry("Token"));
+    {
+        LOCK(cs_tally);
+        // five orders at two prices, placed in the genesis block, the only block of the chain
+        BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Alice", 0, propertyId, 10, COUNOS_PROPERTY_MSC, 20, ArithToUint256(arith_uint256(1)), 1, 1)));
+        BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Bob", 0, propertyId, 10, COUNOS_PROPERTY_MSC, 20, ArithToUint256(arith_uint256(2)), 2, 1)));
+        BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Carol", 0, propertyId, 10, COUNOS_PROPERTY_MSC, 20, ArithToUint256(arith_uint256(3)), 3, 1)));
+        BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Dave", 0, propertyId, 10, COUNOS_PROPERTY_MSC, 30, ArithToUint256(arith_uint256(4)), 4, 1)));
+        BOOST_CHECK(MetaDEx_INSERT(CMPMetaDEx("Eve", 0, propertyId, 10, COUNOS_PROPERTY_MSC, 30, ArithToUint256(arith_uint256(5)), 5, 1)));
+    }
+
+    UniValue params(UniValue::VARR);
+    params.push_back((int64_t) propertyId);
+    UniValue all = CallRPC("counos_getorderbook", params);
+    BOOST_REQUIRE_EQUAL(all.size(), 5U);
+
+    // the pages return the orders in the order of the full order book
+    for (int limit = 1; limit <= 6; ++limit) {
+        std::vector<std::string> paged;
+        std::string cursor;
+        int nPages = 0;
+        do {
+            UniValue pageParams(UniValue::VARR);
+            pageParams.push_back((int64_t) propertyId);
+            pageParams.push_back(NullUniValue);
+            pageParams.push_back(cursor);
+            pageParams.push_back(limit);
+            UniValue page = CallRPC("counos_getorderbook", pageParams);
+            const UniValue& results = find_value(page, "results");
+            BOOST_CHECK(results.size() <= (size_t) limit);
+            for (size_t i = 0; i < results.size(); ++i) {
+                paged.push_back(find_value(results[i], "txid").get_str());
+            }
+            cursor = find_value(page, "cursor").get_str();
+            ++nPages;
+        } while (!cursor.empty() && nPages < 10);
+
+        BOOST_REQUIRE_EQUAL(paged.size(), all.size());
+        for (size_t i = 0; i < paged.size(); ++i) {
+            BOOST_CHECK_EQUAL(paged[i], find_value(all[i], "txid").get_str());
+        }
+        BOOST_CHECK_EQUAL(nPages, (5 + limit - 1) / limit);
+    }
+
+    UniValue badParams(UniValue::VARR);
+    badParams.push_back((int64_t) propertyId);
+    badParams.push_back(NullUniValue);
+    badParams.push_back("1:2:3");
+    BOOST_CHECK_THROW(CallRPC("counos_getorderbook", badParams), UniValue);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
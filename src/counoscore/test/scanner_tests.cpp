@@ -0,0 +1,92 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/scanner.h>
+
+#include <chain.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_scanner_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(blocks_are_returned_in_order)
+{
+    int nTip = 0;
+    {
+        LOCK(cs_main);
+        nTip = ::ChainActive().Height();
+    }
+    const int nLastBlock = nTip + 2 * MAX_SCAN_BLOCKS_AHEAD;
+    CBlockPrefetcher prefetcher(0, nLastBlock, 3, false);
+
+    for (int nBlock = 0; nBlock <= nTip; ++nBlock) {
+        std::shared_ptr<CPrefetchedBlock> pBlock = prefetcher.GetBlock(nBlock);
+        BOOST_REQUIRE(pBlock->pBlockIndex != nullptr);
+        BOOST_CHECK_EQUAL(pBlock->pBlockIndex->nHeight, nBlock);
+        BOOST_CHECK(!pBlock->fSkipped);
+        BOOST_CHECK(pBlock->fRead);
+        BOOST_CHECK(pBlock->block.GetHash() == pBlock->pBlockIndex->GetBlockHash());
+        BOOST_CHECK_EQUAL(pBlock->vMayHaveMarker.size(), pBlock->block.vtx.size());
+    }
+
+    // blocks above the tip are not part of the chain
+    for (int nBlock = nTip + 1; nBlock <= nLastBlock; ++nBlock) {
+        std::shared_ptr<CPrefetchedBlock> pBlock = prefetcher.GetBlock(nBlock);
+        BOOST_CHECK(pBlock->pBlockIndex == nullptr);
+        BOOST_CHECK(!pBlock->fRead);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stop_before_all_blocks_are_read)
+{
+    CBlockPrefetcher prefetcher(0, 10 * MAX_SCAN_BLOCKS_AHEAD, 2, false);
+    std::shared_ptr<CPrefetchedBlock> pBlock = prefetcher.GetBlock(0);
+    BOOST_CHECK(pBlock->fRead);
+    prefetcher.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(flagged_transactions_match_serial_check)
+{
+    CBlock block;
+    for (size_t n = 0; n < 4 * MIN_FLAG_TXS_PER_THREAD + 3; ++n) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = n;
+        mtx.vout.resize(1);
+        mtx.vout[0].nValue = n;
+        block.vtx.push_back(MakeTransactionRef(mtx));
+    }
+
+    std::vector<bool> vExpected;
+    for (const CTransactionRef& tx : block.vtx) {
+        vExpected.push_back(MayHaveMarker(*tx, 0));
+    }
+
+    // without workers, the calling thread checks all ranges
+    for (int nThreads = 0; nThreads <= 8; ++nThreads) {
+        BOOST_CHECK(FlagMarkerTransactions(block, 0, nThreads) == vExpected);
+    }
+
+    BOOST_CHECK(FlagMarkerTransactions(CBlock(), 0, 4).empty());
+
+    StartFlagWorkers(3);
+    for (int nThreads = 0; nThreads <= 8; ++nThreads) {
+        for (int i = 0; i < 16; ++i) {
+            BOOST_CHECK(FlagMarkerTransactions(block, 0, nThreads) == vExpected);
+        }
+    }
+    BOOST_CHECK(FlagMarkerTransactions(CBlock(), 0, 4).empty());
+    StopFlagWorkers();
+
+    // flagging still works after the workers were stopped
+    BOOST_CHECK(FlagMarkerTransactions(block, 0, 4) == vExpected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
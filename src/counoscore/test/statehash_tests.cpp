@@ -0,0 +1,127 @@
+#include <counoscore/consensushash.h>
+#include <counoscore/counoscore.h>
+#include <counoscore/mdex.h>
+#include <counoscore/sp.h>
+#include <counoscore/tally.h>
+#include <crypto/muhash.h>
+
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <stdint.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_statehash_tests, BasicTestingSetup)
+
+static void ClearState()
+{
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+    MetaDEx_CLEAR();
+    my_crowds.clear();
+    for (int part = 0; part < STATEHASH_PART_COUNT; ++part) {
+        ClearStateHash(static_cast<StateHashPart>(part));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(statehash_follows_tally_updates)
+{
+    LOCK(cs_tally);
+    ClearState();
+
+    uint256 emptyHash = GetStateHash();
+    BOOST_CHECK(emptyHash == GetStateHashFromScratch());
+
+    BOOST_CHECK(update_tally_map("Alice", 3, 100, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, 50, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 4, 7, SELLOFFER_RESERVE));
+    BOOST_CHECK(GetStateHash() != emptyHash);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    // Pending amounts are not part of the state
+    uint256 beforePending = GetStateHash();
+    BOOST_CHECK(update_tally_map("Carol", 3, 10, PENDING));
+    BOOST_CHECK(GetStateHash() == beforePending);
+
+    // The hash doesn't depend on the order of updates
+    BOOST_CHECK(update_tally_map("Alice", 3, -100, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, -50, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, 50, BALANCE));
+    BOOST_CHECK(update_tally_map("Alice", 3, 100, BALANCE));
+    BOOST_CHECK(GetStateHash() == beforePending);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    // Removing everything returns to the empty state
+    BOOST_CHECK(update_tally_map("Alice", 3, -100, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, -50, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 4, -7, SELLOFFER_RESERVE));
+    BOOST_CHECK(GetStateHash() == emptyHash);
+
+    ClearState();
+}
+
+BOOST_AUTO_TEST_CASE(statehash_follows_crowdsales)
+{
+    LOCK(cs_tally);
+    ClearState();
+
+    uint256 emptyHash = GetStateHash();
+
+    CMPCrowd& crowd = my_crowds.insert(std::make_pair("Alice", CMPCrowd(3, 100, 1, 1700000000, 10, 5, 0, 0))).first->second;
+    UpdateStateHash(crowd, "Alice", true);
+    BOOST_CHECK(GetStateHash() != emptyHash);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    // Participation changes the created tokens, which are part of the record
+    uint256 beforeParticipation = GetStateHash();
+    UpdateStateHash(crowd, "Alice", false);
+    crowd.incTokensUserCreated(200);
+    crowd.incTokensIssuerCreated(10);
+    UpdateStateHash(crowd, "Alice", true);
+    BOOST_CHECK(GetStateHash() != beforeParticipation);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    // Closing the crowdsale returns to the empty state
+    UpdateStateHash(crowd, "Alice", false);
+    my_crowds.erase("Alice");
+    BOOST_CHECK(GetStateHash() == emptyHash);
+    BOOST_CHECK(GetStateHash() == GetStateHashFromScratch());
+
+    ClearState();
+}
+
+BOOST_AUTO_TEST_CASE(muhash_remove_is_deferred)
+{
+    const unsigned char a[] = {'a'};
+    const unsigned char b[] = {'b'};
+
+    MuHash3072 hashEmpty;
+    uint256 empty;
+    hashEmpty.Finalize(empty);
+
+    // removed elements are collected, and only divided out when finalizing
+    MuHash3072 hash;
+    hash.Insert(Span<const unsigned char>(a, 1));
+    hash.Insert(Span<const unsigned char>(b, 1));
+    hash.Remove(Span<const unsigned char>(a, 1));
+
+    MuHash3072 hashB;
+    hashB.Insert(Span<const unsigned char>(b, 1));
+    uint256 resultB;
+    hashB.Finalize(resultB);
+    uint256 result;
+    hash.Finalize(result);
+    BOOST_CHECK(result == resultB);
+
+    // finalizing keeps the value, so updates can continue afterwards
+    hash.Remove(Span<const unsigned char>(b, 1));
+    hash.Finalize(result);
+    BOOST_CHECK(result == empty);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#include <counoscore/dbspinfo.h>
+#include <counoscore/dbstolist.h>
+#include <counoscore/sp.h>
+
+#include <fs.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using mastercore::pDbSpInfo;
+
+namespace {
+/** Provides the property database, which is used to format amounts. */
+struct STOListTestingSetup : public BasicTestingSetup
+{
+    CMPSPInfo* pDbSpInfoOwned;
+
+    STOListTestingSetup() : pDbSpInfoOwned(nullptr)
+    {
+        if (!pDbSpInfo) pDbSpInfo = pDbSpInfoOwned = new CMPSPInfo(GetDataDir() / "MP_spinfo_test", true);
+    }
+
+    ~STOListTestingSetup()
+    {
+        if (pDbSpInfoOwned) { delete pDbSpInfoOwned; pDbSpInfo = nullptr; }
+    }
+};
+
+/** STO list, which allows to store raw values. */
+class CTestSTOList : public CMPSTOList
+{
+public:
+    CTestSTOList(const fs::path& path, bool fWipe) : CMPSTOList(path, fWipe) {}
+
+    void PutRaw(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+    }
+
+    void DeleteRaw(const std::string& key)
+    {
+        pdb->Delete(writeoptions, key);
+    }
+
+    std::string GetRaw(const std::string& key)
+    {
+        std::string value;
+        pdb->Get(readoptions, key, &value);
+        return value;
+    }
+};
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_stolist_tests, STOListTestingSetup)
+
+BOOST_AUTO_TEST_CASE(recipients_of_transaction)
+{
+    std::unique_ptr<CMPSTOList> stoDb{new CMPSTOList(GetDataDir() / "MP_stolist_test", true)};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+
+    stoDb->recordSTOReceive("Alice", txid1, 100, 3, 50);
+    stoDb->recordSTOReceive("Bob", txid1, 100, 3, 25);
+    stoDb->recordSTOReceive("Alice", txid2, 200, 3, 10);
+
+    std::vector<std::string> addresses;
+    stoDb->getRecipientAddresses(txid1, addresses);
+    BOOST_CHECK_EQUAL(addresses.size(), 2U);
+    if (addresses.size() == 2) {
+        BOOST_CHECK_EQUAL(addresses[0], "Alice");
+        BOOST_CHECK_EQUAL(addresses[1], "Bob");
+    }
+
+    // the index entries aren't mistaken for recipients
+    UniValue recipients(UniValue::VARR);
+    uint64_t total = 0;
+    uint64_t numRecipients = 0;
+    stoDb->getRecipients(txid1, "*", &recipients, &total, &numRecipients);
+    BOOST_CHECK_EQUAL(numRecipients, 2U);
+    BOOST_CHECK_EQUAL(total, 75U);
+
+    // receipts and their index entries are removed together
+    stoDb->deleteAboveBlock(200);
+    addresses.clear();
+    stoDb->getRecipientAddresses(txid2, addresses);
+    BOOST_CHECK(addresses.empty());
+    addresses.clear();
+    stoDb->getRecipientAddresses(txid1, addresses);
+    BOOST_CHECK_EQUAL(addresses.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(legacy_records_are_migrated)
+{
+    const fs::path path = GetDataDir() / "MP_stolist_test";
+    std::unique_ptr<CTestSTOList> stoDb{new CTestSTOList(path, true)};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    stoDb->PutRaw("Alice", strprintf("%s:100:3:50,%s:200:3:10,", txid1.ToString(), txid2.ToString()));
+    stoDb->PutRaw("Bob", strprintf("%s:100:3:25,", txid1.ToString()));
+    stoDb->PutRaw("Carol", ""); // all receipts were removed by a reorg
+
+    // the index of databases without it is built from the legacy records
+    stoDb->DeleteRaw("stoindexversion");
+    stoDb.reset();
+    stoDb.reset(new CTestSTOList(path, false));
+
+    std::vector<std::string> addresses;
+    stoDb->getRecipientAddresses(txid1, addresses);
+    BOOST_CHECK_EQUAL(addresses.size(), 2U);
+
+    // point lookups rewrite the records in the binary format
+    UniValue recipients(UniValue::VARR);
+    uint64_t total = 0;
+    uint64_t numRecipients = 0;
+    stoDb->getRecipients(txid1, "*", &recipients, &total, &numRecipients);
+    BOOST_CHECK_EQUAL(numRecipients, 2U);
+    BOOST_CHECK_EQUAL(total, 75U);
+    BOOST_CHECK_EQUAL(stoDb->GetRaw("Alice")[0], CMPSTOListRecord::VERSION);
+
+    CMPSTOListRecord record;
+    const std::string value = stoDb->GetRaw("Alice");
+    BOOST_CHECK(DecodeDBRecord(value, record));
+    BOOST_CHECK_EQUAL(record.receipts.size(), 2U);
+    BOOST_CHECK_EQUAL(record.ToString(), strprintf("%s:100:3:50,%s:200:3:10,", txid1.ToString(), txid2.ToString()));
+
+    // receipts of emptied legacy records are removed like any other
+    stoDb->recordSTOReceive("Carol", txid2, 200, 3, 5);
+    stoDb->deleteAboveBlock(200);
+    BOOST_CHECK(DecodeDBRecord(stoDb->GetRaw("Carol"), record));
+    BOOST_CHECK(record.receipts.empty());
+    BOOST_CHECK(DecodeDBRecord(stoDb->GetRaw("Alice"), record));
+    BOOST_CHECK_EQUAL(record.receipts.size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
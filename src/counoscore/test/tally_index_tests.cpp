@@ -0,0 +1,70 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/tally.h>
+
+#include <sync.h>
+#include <test/util/setup_common.h>
+
+#include <stdint.h>
+#include <string>
+#include <set>
+#include <unordered_map>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_tally_index_tests, BasicTestingSetup)
+
+static size_t CountHolders(uint32_t propertyId)
+{
+    std::unordered_map<uint32_t, PropertyHolderSet>::const_iterator it = mp_property_holders.find(propertyId);
+    if (it == mp_property_holders.end()) return 0;
+    return it->second.size();
+}
+
+BOOST_AUTO_TEST_CASE(holder_index_follows_tally_updates)
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+
+    BOOST_CHECK(update_tally_map("Alice", 3, 100, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 3, 50, BALANCE));
+    BOOST_CHECK(update_tally_map("Bob", 4, 7, BALANCE));
+    BOOST_CHECK_EQUAL(CountHolders(3), 2U);
+    BOOST_CHECK_EQUAL(CountHolders(4), 1U);
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 150);
+
+    // Reserving tokens doesn't change the holders or total
+    BOOST_CHECK(update_tally_map("Alice", 3, -40, BALANCE));
+    BOOST_CHECK(update_tally_map("Alice", 3, 40, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(CountHolders(3), 2U);
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 150);
+
+    // Pending amounts are not held
+    BOOST_CHECK(update_tally_map("Carol", 3, -10, PENDING));
+    BOOST_CHECK(update_tally_map("Dave", 3, 10, PENDING));
+    BOOST_CHECK_EQUAL(CountHolders(3), 2U);
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 150);
+
+    // Failed updates leave the index untouched
+    BOOST_CHECK(!update_tally_map("Bob", 3, -51, BALANCE));
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 150);
+
+    // Holders are removed, once their balance reaches zero
+    BOOST_CHECK(update_tally_map("Bob", 3, -50, BALANCE));
+    BOOST_CHECK(update_tally_map("Alice", 3, -60, BALANCE));
+    BOOST_CHECK_EQUAL(CountHolders(3), 1U);
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 40);
+    BOOST_CHECK(update_tally_map("Alice", 3, -40, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(CountHolders(3), 0U);
+    BOOST_CHECK_EQUAL(mp_property_totals[3], 0);
+    BOOST_CHECK_EQUAL(CountHolders(4), 1U);
+
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    mp_property_totals.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <test/util/setup_common.h>
 
 #include <stdint.h>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -318,5 +319,44 @@ BOOST_AUTO_TEST_CASE(tally_overflow)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(3), int64_t(9223372036854775807LL));
 }
 
+BOOST_AUTO_TEST_CASE(tally_const_iteration)
+{
+    CMPTally tally;
+    BOOST_CHECK(tally.begin() == tally.end());
+    BOOST_CHECK_EQUAL(tally.size(), 0U);
+
+    // more entries than stored inline, inserted out of order
+    BOOST_CHECK(tally.updateMoney(7, 70, BALANCE));
+    BOOST_CHECK(tally.updateMoney(2, 20, BALANCE));
+    BOOST_CHECK(tally.updateMoney(31, 310, SELLOFFER_RESERVE));
+    BOOST_CHECK(tally.updateMoney(1, 10, METADEX_RESERVE));
+    BOOST_CHECK(tally.updateMoney(2147483651U, 5, PENDING));
+    BOOST_CHECK(tally.updateMoney(4, 40, ACCEPT_RESERVE));
+    BOOST_CHECK_EQUAL(tally.size(), 6U);
+
+    // the internal iterator is not affected by the const iteration
+    BOOST_CHECK_EQUAL(tally.init(), 1U);
+    BOOST_CHECK_EQUAL(tally.next(), 1U);
+
+    std::vector<uint32_t> vPropertyIds;
+    const CMPTally& constTally = tally;
+    for (CMPTally::const_iterator it = constTally.begin(); it != constTally.end(); ++it) {
+        vPropertyIds.push_back(it->propertyId);
+        for (int ttype = 0; ttype < TALLY_TYPE_COUNT; ++ttype) {
+            BOOST_CHECK_EQUAL(it->balance[ttype], tally.getMoney(it->propertyId, static_cast<TallyType>(ttype)));
+        }
+    }
+    BOOST_CHECK_EQUAL(vPropertyIds.size(), 6U);
+    BOOST_CHECK_EQUAL(vPropertyIds[0], 1U);
+    BOOST_CHECK_EQUAL(vPropertyIds[1], 2U);
+    BOOST_CHECK_EQUAL(vPropertyIds[2], 4U);
+    BOOST_CHECK_EQUAL(vPropertyIds[3], 7U);
+    BOOST_CHECK_EQUAL(vPropertyIds[4], 31U);
+    BOOST_CHECK_EQUAL(vPropertyIds[5], 2147483651U);
+
+    BOOST_CHECK_EQUAL(tally.next(), 2U);
+    BOOST_CHECK_EQUAL(tally.next(), 4U);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,202 @@
+#include <counoscore/counoscore.h>
+#include <counoscore/dbspinfo.h>
+#include <counoscore/dbtradelist.h>
+#include <counoscore/sp.h>
+
+#include <fs.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_tradelist_tests, TestingSetup)
+
+namespace {
+/** Trade list, which allows to store raw values. */
+class CTestTradeList : public CMPTradeList
+{
+public:
+    CTestTradeList(const fs::path& path, bool fWipe) : CMPTradeList(path, fWipe) {}
+
+    void PutRaw(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+    }
+
+    void DeleteRaw(const std::string& key)
+    {
+        pdb->Delete(writeoptions, key);
+    }
+
+    std::string GetRaw(const std::string& key)
+    {
+        std::string value;
+        pdb->Get(readoptions, key, &value);
+        return value;
+    }
+};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(trades_for_address)
+{
+    std::unique_ptr<CMPTradeList> tradeDb{new CMPTradeList(GetDataDir() / "MP_tradelist_test", true)};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    const uint256 txid3 = uint256S("03");
+    const uint256 txid4 = uint256S("04");
+
+    // recorded out of order
+    tradeDb->recordNewTrade(txid3, "Alice", 1, 3, 200, 1);
+    tradeDb->recordNewTrade(txid1, "Alice", 1, 3, 100, 5);
+    tradeDb->recordNewTrade(txid2, "Alice", 4, 1, 200, 0);
+    tradeDb->recordNewTrade(txid4, "Bob", 1, 3, 150, 2);
+    BOOST_CHECK_EQUAL(tradeDb->getMPTradeCountTotal(), 4);
+
+    std::vector<uint256> trades;
+    tradeDb->getTradesForAddress("Alice", trades);
+    BOOST_CHECK_EQUAL(trades.size(), 3U);
+    if (trades.size() == 3) {
+        BOOST_CHECK(trades[0] == txid1);
+        BOOST_CHECK(trades[1] == txid2);
+        BOOST_CHECK(trades[2] == txid3);
+    }
+
+    trades.clear();
+    tradeDb->getTradesForAddress("Alice", trades, 3);
+    BOOST_CHECK_EQUAL(trades.size(), 2U);
+
+    // an address, which is a prefix of another one, doesn't match
+    trades.clear();
+    tradeDb->getTradesForAddress("Ali", trades);
+    BOOST_CHECK(trades.empty());
+
+    // trades and their index entries are removed together
+    BOOST_CHECK_EQUAL(tradeDb->deleteAboveBlock(200), 4);
+    trades.clear();
+    tradeDb->getTradesForAddress("Alice", trades);
+    BOOST_CHECK_EQUAL(trades.size(), 1U);
+    BOOST_CHECK_EQUAL(tradeDb->getMPTradeCountTotal(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(trade_counterparties)
+{
+    std::unique_ptr<CMPTradeList> tradeDb{new CMPTradeList(GetDataDir() / "MP_tradelist_test", true)};
+
+    const uint256 txidMaker1 = uint256S("01");
+    const uint256 txidMaker2 = uint256S("02");
+    const uint256 txidTaker = uint256S("03");
+    const uint256 txidOther = uint256S("04");
+
+    tradeDb->recordNewTrade(txidMaker1, "Alice", 1, 3, 100, 1);
+    tradeDb->recordNewTrade(txidMaker2, "Bob", 1, 3, 101, 1);
+    tradeDb->recordNewTrade(txidTaker, "Carol", 3, 1, 102, 2);
+    tradeDb->recordMatchedTrade(txidMaker1, txidTaker, "Alice", "Carol", 3, 1, 50, 100, 102, 2, 0);
+    tradeDb->recordMatchedTrade(txidMaker2, txidTaker, "Bob", "Carol", 3, 1, 50, 100, 102, 2, 0);
+
+    // another trade of the pair at an earlier position in the same block
+    tradeDb->recordNewTrade(txidOther, "Dave", 3, 1, 102, 1);
+    tradeDb->recordMatchedTrade(txidMaker1, txidOther, "Alice", "Dave", 3, 1, 10, 20, 102, 1, 0);
+
+    std::set<std::string> addresses;
+    tradeDb->getTradeCounterparties(txidTaker, addresses);
+    BOOST_CHECK_EQUAL(addresses.size(), 2U);
+    BOOST_CHECK(addresses.count("Alice"));
+    BOOST_CHECK(addresses.count("Bob"));
+
+    // orders, which were not matched, when they were added, have no counterparties
+    addresses.clear();
+    tradeDb->getTradeCounterparties(txidMaker2, addresses);
+    BOOST_CHECK(addresses.empty());
+
+    addresses.clear();
+    tradeDb->getTradeCounterparties(uint256S("05"), addresses);
+    BOOST_CHECK(addresses.empty());
+}
+
+BOOST_AUTO_TEST_CASE(legacy_records_are_migrated)
+{
+    const fs::path path = GetDataDir() / "MP_tradelist_test";
+    std::unique_ptr<CTestTradeList> tradeDb{new CTestTradeList(path, true)};
+
+    const uint256 txidMaker = uint256S("01");
+    const uint256 txidTaker = uint256S("03");
+    const std::string matchKey = txidMaker.ToString() + "+" + txidTaker.ToString();
+    tradeDb->PutRaw(txidMaker.ToString(), "Alice:1:3:100:5");
+    tradeDb->PutRaw(txidTaker.ToString(), "Carol:3:1:102:2");
+    tradeDb->PutRaw(matchKey, "Alice:Carol:3:1:50:100:102:0");
+
+    // the indexes of databases without them are built from the legacy records
+    tradeDb->DeleteRaw("tradeindexversion");
+    tradeDb.reset();
+    tradeDb.reset(new CTestTradeList(path, false));
+
+    std::vector<uint256> trades;
+    tradeDb->getTradesForAddress("Alice", trades);
+    BOOST_CHECK_EQUAL(trades.size(), 1U);
+    if (trades.size() == 1) BOOST_CHECK(trades[0] == txidMaker);
+
+    // point lookups rewrite the records in the binary format
+    std::set<std::string> addresses;
+    tradeDb->getTradeCounterparties(txidTaker, addresses);
+    BOOST_CHECK_EQUAL(addresses.size(), 1U);
+    BOOST_CHECK(addresses.count("Alice"));
+    BOOST_CHECK_EQUAL(tradeDb->GetRaw(txidTaker.ToString())[0], CMPTradeRecord::VERSION);
+    BOOST_CHECK_EQUAL(tradeDb->GetRaw(matchKey)[0], CMPTradeMatchRecord::VERSION);
+    BOOST_CHECK_EQUAL(tradeDb->GetRaw(txidMaker.ToString()), "Alice:1:3:100:5");
+
+    CMPTradeMatchRecord match;
+    const std::string value = tradeDb->GetRaw(matchKey);
+    BOOST_CHECK(DecodeDBRecord(value, match));
+    BOOST_CHECK_EQUAL(match.ToString(), "Alice:Carol:3:1:50:100:102:0");
+
+    // legacy and binary records are removed alike
+    BOOST_CHECK_EQUAL(tradeDb->deleteAboveBlock(100), 6);
+    BOOST_CHECK_EQUAL(tradeDb->getMPTradeCountTotal(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(trades_for_pair)
+{
+    pDbSpInfo = new CMPSPInfo(GetDataDir() / "MP_spinfo_test", true);
+    std::unique_ptr<CMPTradeList> tradeDb{new CMPTradeList(GetDataDir() / "MP_tradelist_test", true)};
+
+    for (int n = 1; n <= 3; ++n) {
+        const uint256 txidNew = uint256S(strprintf("%d", 10 + n));
+        tradeDb->recordMatchedTrade(uint256S("01"), txidNew, "Alice", "Bob", 2, 1, 100 * n, 50 * n, 100 + n, 1, 0);
+    }
+    tradeDb->recordMatchedTrade(uint256S("02"), uint256S("20"), "Alice", "Carol", 1, 3, 100, 50, 102, 1, 0);
+
+    UniValue response(UniValue::VARR);
+    tradeDb->getTradesForPair(1, 2, response, 2);
+    BOOST_CHECK_EQUAL(response.size(), 2U);
+    if (response.size() == 2) {
+        BOOST_CHECK_EQUAL(response[0]["block"].get_int(), 102);
+        BOOST_CHECK_EQUAL(response[1]["block"].get_int(), 103);
+        BOOST_CHECK_EQUAL(response[1]["selleraddress"].get_str(), "Alice");
+        BOOST_CHECK_EQUAL(response[1]["matchingaddress"].get_str(), "Bob");
+    }
+
+    UniValue inverse(UniValue::VARR);
+    tradeDb->getTradesForPair(2, 1, inverse, 10);
+    BOOST_CHECK_EQUAL(inverse.size(), 3U);
+    if (inverse.size() == 3) {
+        BOOST_CHECK_EQUAL(inverse[0]["block"].get_int(), 101);
+        BOOST_CHECK_EQUAL(inverse[0]["selleraddress"].get_str(), "Bob");
+    }
+
+    tradeDb.reset();
+    delete pDbSpInfo;
+    pDbSpInfo = nullptr;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
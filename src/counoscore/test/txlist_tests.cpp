@@ -0,0 +1,203 @@
+#include <counoscore/dbbase.h>
+#include <counoscore/dbtxlist.h>
+
+#include <fs.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <leveldb/slice.h>
+
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(counoscore_txlist_tests, BasicTestingSetup)
+
+namespace {
+/** Transaction list, which allows to store raw values. */
+class CTestTxList : public CMPTxList
+{
+public:
+    CTestTxList(const fs::path& path, bool fWipe = true) : CMPTxList(path, fWipe) {}
+
+    void PutRaw(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+    }
+
+    void DeleteRaw(const std::string& key)
+    {
+        pdb->Delete(writeoptions, key);
+    }
+
+    std::string GetRaw(const std::string& key)
+    {
+        std::string value;
+        pdb->Get(readoptions, key, &value);
+        return value;
+    }
+};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(txs_in_block_range)
+{
+    std::unique_ptr<CMPTxList> txDb{new CMPTxList(GetDataDir() / "MP_txlist_test", true)};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    const uint256 txid3 = uint256S("03");
+    const uint256 txid4 = uint256S("04");
+
+    txDb->recordTX(txid3, true, 300, 0, 0);
+    txDb->recordTX(txid1, true, 100, 0, 0);
+    txDb->recordTX(txid2, false, 200, 0, 0);
+    txDb->recordPaymentTX(txid4, true, 256, 1, 3, 50, "Alice", "Bob");
+    txDb->recordPaymentTX(txid4, true, 256, 2, 3, 70, "Alice", "Carol");
+
+    std::set<uint256> txs;
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(100, 300, txs), 4);
+    BOOST_CHECK_EQUAL(txs.size(), 4U);
+
+    txs.clear();
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(150, 299, txs), 2);
+    BOOST_CHECK(txs.count(txid2));
+    BOOST_CHECK(txs.count(txid4));
+
+    txs.clear();
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(301, 999, txs), 0);
+    BOOST_CHECK_EQUAL(txDb->getMPTransactionCountTotal(), 4);
+    BOOST_CHECK_EQUAL(txDb->getMPTransactionCountBlock(256), 1);
+}
+
+BOOST_AUTO_TEST_CASE(rollback_deletes_sub_records)
+{
+    std::unique_ptr<CMPTxList> txDb{new CMPTxList(GetDataDir() / "MP_txlist_test", true)};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    const uint256 txid3 = uint256S("03");
+
+    txDb->recordTX(txid1, true, 100, 0, 0);
+    txDb->recordTX(txid2, true, 200, 4, 0);
+    txDb->recordSendAllSubRecord(txid2, 1, 3, 100);
+    txDb->recordTX(txid3, true, 201, 256, 0);
+    txDb->RecordNonFungibleGrant(txid3, 1, 10);
+
+    BOOST_CHECK(!txDb->isMPinBlockRange(101, 199, false));
+    BOOST_CHECK(txDb->isMPinBlockRange(150, 250, false));
+
+    uint32_t propertyId = 0;
+    int64_t amount = 0;
+    BOOST_CHECK(txDb->getSendAllDetails(txid2, 1, propertyId, amount));
+
+    BOOST_CHECK(txDb->isMPinBlockRange(150, 999, true));
+    BOOST_CHECK(txDb->exists(txid1));
+    BOOST_CHECK(!txDb->exists(txid2));
+    BOOST_CHECK(!txDb->exists(txid3));
+    BOOST_CHECK(!txDb->getSendAllDetails(txid2, 1, propertyId, amount));
+    BOOST_CHECK_EQUAL(txDb->GetNonFungibleGrant(txid3).second, 0);
+    BOOST_CHECK(!txDb->isMPinBlockRange(150, 999, false));
+
+    std::set<uint256> txs;
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(0, 999, txs), 1);
+}
+
+BOOST_AUTO_TEST_CASE(height_index_is_built_in_place)
+{
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    const uint256 txid3 = uint256S("03");
+    {
+        // a database without the block height index, as written by earlier versions
+        std::unique_ptr<CTestTxList> txDb{new CTestTxList(GetDataDir() / "MP_txlist_test")};
+        txDb->DeleteRaw("txlistindexversion");
+        txDb->PutRaw("dbversion", "8");
+        txDb->PutRaw(txid1.ToString(), "1:100:0:0");
+        txDb->PutRaw(txid2.ToString(), "1:200:99999999:1");
+        txDb->PutRaw(txid2.ToString() + "-1", "1:Alice:Bob:3:100");
+        txDb->PutRaw(txid3.ToString() + "-C", "1:300:99992104:1");
+        txDb->PutRaw(txid3.ToString() + "-C1", "04:3:100");
+
+        std::set<uint256> txs;
+        BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(0, 999, txs), 0);
+    }
+
+    // the index is added, when the database is opened, and the records are kept
+    std::unique_ptr<CMPTxList> txDb{new CMPTxList(GetDataDir() / "MP_txlist_test", false)};
+    BOOST_CHECK_EQUAL(txDb->getDBVersion(), 8);
+
+    std::set<uint256> txs;
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(0, 999, txs), 3);
+    BOOST_CHECK(txs.count(txid1));
+    BOOST_CHECK(txs.count(txid2));
+    BOOST_CHECK(txs.count(txid3));
+
+    txs.clear();
+    BOOST_CHECK_EQUAL(txDb->GetCounosTxsInBlockRange(150, 250, txs), 1);
+    BOOST_CHECK(txs.count(txid2));
+
+    // rolling back removes the indexed cancel with its sub records
+    BOOST_CHECK(txDb->isMPinBlockRange(300, 300, true));
+    BOOST_CHECK(txDb->getKeyValue(txid3.ToString() + "-C1").empty());
+    BOOST_CHECK_EQUAL(txDb->getNumberOfMetaDExCancels(txid3), 0);
+}
+
+BOOST_AUTO_TEST_CASE(binary_records)
+{
+    CMPTxListRecord record(true, 123456, 50, 18446744073709551615ULL);
+    const CDataStream ssValue = EncodeDBRecord(record);
+    BOOST_CHECK_EQUAL(ssValue.size(), 1U + 1U + 4U + 4U + 8U);
+
+    CMPTxListRecord decoded;
+    bool fLegacy = true;
+    BOOST_CHECK(DecodeDBRecord(leveldb::Slice(ssValue.data(), ssValue.size()), decoded, &fLegacy));
+    BOOST_CHECK(!fLegacy);
+    BOOST_CHECK(decoded.fValid);
+    BOOST_CHECK_EQUAL(decoded.nBlock, 123456);
+    BOOST_CHECK_EQUAL(decoded.nType, 50U);
+    BOOST_CHECK_EQUAL(decoded.nValue, 18446744073709551615ULL);
+
+    // sub records and truncated values are not master records
+    BOOST_CHECK(!DecodeDBRecord(leveldb::Slice("3:100"), decoded));
+    BOOST_CHECK(!DecodeDBRecord(leveldb::Slice("1:Alice:Bob:3:100"), decoded));
+    BOOST_CHECK(!DecodeDBRecord(leveldb::Slice(ssValue.data(), ssValue.size() - 1), decoded));
+    BOOST_CHECK(!DecodeDBRecord(leveldb::Slice(""), decoded));
+}
+
+BOOST_AUTO_TEST_CASE(legacy_records_are_migrated)
+{
+    std::unique_ptr<CTestTxList> txDb{new CTestTxList(GetDataDir() / "MP_txlist_test")};
+
+    const uint256 txid1 = uint256S("01");
+    const uint256 txid2 = uint256S("02");
+    txDb->PutRaw(txid1.ToString(), "1:250:50:7");
+    txDb->PutRaw(txid2.ToString(), "0:251:0:0");
+
+    // scans decode legacy records without migrating them
+    BOOST_CHECK_EQUAL(txDb->getMPTransactionCountBlock(250), 1);
+    BOOST_CHECK_EQUAL(txDb->GetRaw(txid1.ToString()), "1:250:50:7");
+
+    int block = 0;
+    unsigned int type = 0;
+    uint64_t nValue = 0;
+    BOOST_CHECK(txDb->getValidMPTX(txid1, &block, &type, &nValue));
+    BOOST_CHECK_EQUAL(block, 250);
+    BOOST_CHECK_EQUAL(type, 50U);
+    BOOST_CHECK_EQUAL(nValue, 7U);
+    BOOST_CHECK(!txDb->getValidMPTX(txid2, &block));
+    BOOST_CHECK_EQUAL(block, 251);
+
+    // point lookups rewrite the records in the binary format
+    const std::string value = txDb->GetRaw(txid1.ToString());
+    BOOST_CHECK_EQUAL(value.size(), 18U);
+    BOOST_CHECK_EQUAL(value[0], CMPTxListRecord::VERSION);
+    BOOST_CHECK(txDb->getValidMPTX(txid1, &block, &type, &nValue));
+    BOOST_CHECK_EQUAL(block, 250);
+    BOOST_CHECK_EQUAL(nValue, 7U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <counoscore/tx.h>
 
 #include <counoscore/activation.h>
+#include <counoscore/consensushash.h>
 #include <counoscore/dbfees.h>
 #include <counoscore/dbspinfo.h>
 #include <counoscore/dbstolist.h>
@@ -1229,8 +1230,10 @@ int CMPTransaction::logicHelper_CrowdsaleParticipation(uint256& blockHash)
     }
 
     // Update the crowdsale object
+    UpdateStateHash(*pcrowdsale, receiver, false);
     pcrowdsale->incTokensUserCreated(tokens.first);
     pcrowdsale->incTokensIssuerCreated(tokens.second);
+    UpdateStateHash(*pcrowdsale, receiver, true);
 
     // Data to pass to txFundraiserData
     int64_t txdata[] = {(int64_t) nValue, blockTime, tokens.first, tokens.second};
@@ -2182,7 +2185,8 @@ int CMPTransaction::logicMath_CreatePropertyVariable(CBlockIndex* pindex)
 
     const uint32_t propertyId = pDbSpInfo->putSP(ecosystem, newSP);
     assert(propertyId > 0);
-    my_crowds.insert(std::make_pair(sender, CMPCrowd(propertyId, nValue, property, deadline, early_bird, percentage, 0, 0)));
+    std::pair<CrowdMap::iterator, bool> inserted = my_crowds.insert(std::make_pair(sender, CMPCrowd(propertyId, nValue, property, deadline, early_bird, percentage, 0, 0)));
+    if (inserted.second) UpdateStateHash(inserted.first->second, sender, true);
 
     PrintToLog("CREATED CROWDSALE id: %d value: %d property: %d\n", propertyId, nValue, property);
 
@@ -2248,6 +2252,7 @@ int CMPTransaction::logicMath_CloseCrowdsale(CBlockIndex* pindex)
     if (missedTokens > 0) {
         assert(update_tally_map(sp.issuer, property, missedTokens, BALANCE));
     }
+    UpdateStateHash(it->second, it->first, false);
     my_crowds.erase(it);
 
     if (msc_debug_sp) PrintToLog("CLOSED CROWDSALE id: %d=%X\n", property, property);
@@ -216,6 +216,7 @@ public:
     std::string getReceiver() const { return receiver; }
     std::string getPayload() const { return HexStr(pkt, pkt + pkt_size); }
     std::string getPayloadData() const { return HexStr(pkt + 4 /* skip version and type */, pkt + pkt_size); }
+    std::vector<unsigned char> getRawPayload() const { return std::vector<unsigned char>(pkt, pkt + pkt_size); }
     uint64_t getAmount() const { return nValue; }
     uint64_t getNewAmount() const { return nNewValue; }
     uint8_t getEcosystem() const { return ecosystem; }
@@ -257,6 +258,9 @@ public:
     /** Return an output address, if it's considered as valid Omni destination. */
     bool getValidStmAddressAt(uint8_t output, std::string& addressOut);
 
+    /** Returns all outputs, which are considered as valid Omni destinations. */
+    const std::map<uint8_t, std::string>& getValidStmAddresses() const { return validOutputAddressesForSTM; }
+
     /** Creates a new CMPTransaction object. */
     CMPTransaction()
     {
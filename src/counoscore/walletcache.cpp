@@ -3,6 +3,10 @@
  *
  * Provides a cache of wallet balances and functionality for determining whether
  * Counos state changes affected anything in the wallet.
+ *
+ * Only addresses, whose balances changed since the last update, are compared
+ * with the cache. The whole state is checked after it was cleared, or when the
+ * wallets report new or removed addresses.
  */
 
 #include <counoscore/walletcache.h>
@@ -19,12 +23,16 @@
 #include <wallet/wallet.h>
 #endif
 
+#include <atomic>
 #include <stdint.h>
 #include <algorithm>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -33,64 +41,216 @@ namespace mastercore
 //! Map of wallet balances
 static std::map<std::string, CMPTally> walletBalancesCache;
 
+//! Spendable wallet addresses with balances, used for the wallet totals
+static std::set<std::string> walletSpendableAddresses;
+
+//! Wallet addresses (including watch only) with balances
+static std::unordered_set<AddressId> setWalletAddressIds;
+
+//! Addresses, which are not in the wallet, and which were added after the last full update
+static std::unordered_set<AddressId> setForeignAddressIds;
+
+//! Number of addresses, which were checked by the last full update
+static size_t nCheckedAddresses = 0;
+
+//! Addresses, whose balances changed since the last update
+static std::unordered_set<AddressId> setDirtyAddresses;
+
+//! Whether all addresses need to be checked by the next update, set initially
+static std::atomic<bool> fAllAddressesDirty{true};
+
+#ifdef ENABLE_WALLET
+//! Wallets, which notify the cache about address changes
+static std::vector<std::weak_ptr<CWallet>> vSubscribedWallets;
+
 /**
- * Updates the cache with the latest state, returning true if changes were made to wallet addresses (including watch only).
+ * Subscribes to address book, watch-only and keypool changes of new wallets.
+ *
+ * The notifications only request a full update, because they are sent while
+ * the wallet is locked. Loading or unloading wallets also requests a full update.
+ */
+static void SubscribeWallets()
+{
+    std::vector<std::weak_ptr<CWallet>> vWallets;
+
+    for (const std::shared_ptr<CWallet>& wallet : GetWallets()) {
+        vWallets.push_back(wallet);
+
+        bool fSubscribed = false;
+        for (std::vector<std::weak_ptr<CWallet>>::const_iterator it = vSubscribedWallets.begin(); it != vSubscribedWallets.end(); ++it) {
+            if (it->lock() == wallet) fSubscribed = true;
+        }
+        if (fSubscribed) continue;
+
+        wallet->NotifyAddressBookChanged.connect([](CWallet* wallet, const CTxDestination& address, const std::string& label, bool isMine, const std::string& purpose, ChangeType status) {
+            if (isMine) fAllAddressesDirty = true;
+        });
+        wallet->NotifyWatchonlyChanged.connect([](bool fHaveWatchOnly) {
+            fAllAddressesDirty = true;
+        });
+        wallet->NotifyCanGetAddressesChanged.connect([]() {
+            fAllAddressesDirty = true;
+        });
+        fAllAddressesDirty = true;
+    }
+
+    if (vWallets.size() != vSubscribedWallets.size()) fAllAddressesDirty = true;
+    vSubscribedWallets.swap(vWallets);
+}
+#endif
+
+/**
+ * Determines whether an address is in the wallet, which is looked up only once per address.
  *
- * Also prepares a list of addresses that were changed (for future usage).
+ * All addresses are checked by a full update, and new addresses afterwards, so
+ * the wallets are only asked about addresses, which weren't seen before.
+ */
+static bool IsWalletAddress(AddressId id, const std::string& address)
+{
+    if (setWalletAddressIds.count(id)) return true;
+    if (id < nCheckedAddresses || setForeignAddressIds.count(id)) return false;
+
+    if (!IsMyAddressAllWallets(address, true)) {
+        setForeignAddressIds.insert(id);
+        return false;
+    }
+
+    setWalletAddressIds.insert(id);
+    // only spendable balances are included in the wallet totals
+    if (IsMyAddressAllWallets(address, false, ISMINE_SPENDABLE) == ISMINE_SPENDABLE) {
+        walletSpendableAddresses.insert(address);
+    }
+    return true;
+}
+
+/**
+ * Compares the balances of a wallet address with the cache, and updates the cache.
+ *
+ * @return True, if the balances changed
+ */
+static bool UpdateAddress(const std::string& address, CMPTally& tally)
+{
+    // init the tally
+    tally.init();
+
+    // check cache for miss on address
+    std::map<std::string, CMPTally>::iterator search_it = walletBalancesCache.find(address);
+    if (search_it == walletBalancesCache.end()) { // cache miss, new address
+        walletBalancesCache.insert(std::make_pair(address,tally));
+        if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s not in cache\n", address);
+        return true;
+    }
+
+    // check cache for miss on balance
+    CMPTally &cacheTally = search_it->second;
+    uint32_t propertyId;
+    while (0 != (propertyId = (tally.next()))) {
+        if (tally.getMoney(propertyId, BALANCE) != cacheTally.getMoney(propertyId, BALANCE) ||
+                tally.getMoney(propertyId, PENDING) != cacheTally.getMoney(propertyId, PENDING) ||
+                tally.getMoney(propertyId, SELLOFFER_RESERVE) != cacheTally.getMoney(propertyId, SELLOFFER_RESERVE) ||
+                tally.getMoney(propertyId, ACCEPT_RESERVE) != cacheTally.getMoney(propertyId, ACCEPT_RESERVE) ||
+                tally.getMoney(propertyId, METADEX_RESERVE) != cacheTally.getMoney(propertyId, METADEX_RESERVE)) { // cache miss, balance
+            walletBalancesCache.erase(search_it);
+            walletBalancesCache.insert(std::make_pair(address,tally));
+            if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s balance for property %d differs\n", address, propertyId);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Updates the cache with the latest state, returning true if changes were made to wallet addresses (including watch only).
  */
 int WalletCacheUpdate()
 {
     if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Update requested\n");
     int numChanges = 0;
-    std::set<std::string> changedAddresses;
 
     LOCK(cs_tally);
 
-    for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-        const std::string& address = my_it->first;
+#ifdef ENABLE_WALLET
+    SubscribeWallets();
+#endif
 
-        // determine if this address is in the wallet
-        int addressIsMine = IsMyAddressAllWallets(address, true);
-        if (!addressIsMine) {
-            if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Ignoring non-wallet address %s\n", address);
-            continue; // ignore this address, not in wallet
-        }
+    if (fAllAddressesDirty.exchange(false)) {
+        if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Checking all %d addresses\n", mp_tally_map.size());
 
-        // obtain & init the tally
-        CMPTally& tally = my_it->second;
-        tally.init();
+        setWalletAddressIds.clear();
+        setForeignAddressIds.clear();
+        walletSpendableAddresses.clear();
+        nCheckedAddresses = 0;
 
-        // check cache for miss on address
-        std::map<std::string, CMPTally>::iterator search_it = walletBalancesCache.find(address);
-        if (search_it == walletBalancesCache.end()) { // cache miss, new address
-            ++numChanges;
-            changedAddresses.insert(address);
-            walletBalancesCache.insert(std::make_pair(address,tally));
-            if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s not in cache\n", address);
-            continue;
-        }
+        // addresses, which are no longer in the state or the wallet, are dropped from the cache
+        std::map<std::string, CMPTally> previousCache;
+        previousCache.swap(walletBalancesCache);
+
+        for (std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+            const std::string& address = addressTable.GetAddress(my_it->first);
+            if (!IsWalletAddress(my_it->first, address)) {
+                if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Ignoring non-wallet address %s\n", address);
+                continue; // ignore this address, not in wallet
+            }
 
-        // check cache for miss on balance - TODO TRY AND OPTIMIZE THIS
-        CMPTally &cacheTally = search_it->second;
-        uint32_t propertyId;
-        while (0 != (propertyId = (tally.next()))) {
-            if (tally.getMoney(propertyId, BALANCE) != cacheTally.getMoney(propertyId, BALANCE) ||
-                    tally.getMoney(propertyId, PENDING) != cacheTally.getMoney(propertyId, PENDING) ||
-                    tally.getMoney(propertyId, SELLOFFER_RESERVE) != cacheTally.getMoney(propertyId, SELLOFFER_RESERVE) ||
-                    tally.getMoney(propertyId, ACCEPT_RESERVE) != cacheTally.getMoney(propertyId, ACCEPT_RESERVE) ||
-                    tally.getMoney(propertyId, METADEX_RESERVE) != cacheTally.getMoney(propertyId, METADEX_RESERVE)) { // cache miss, balance
-                ++numChanges;
-                changedAddresses.insert(address);
-                walletBalancesCache.erase(search_it);
-                walletBalancesCache.insert(std::make_pair(address,tally));
-                if (msc_debug_walletcache) PrintToLog("WALLETCACHE: *CACHE MISS* - %s balance for property %d differs\n", address, propertyId);
-                break;
+            std::map<std::string, CMPTally>::iterator search_it = previousCache.find(address);
+            if (search_it != previousCache.end()) {
+                walletBalancesCache.insert(*search_it);
+                previousCache.erase(search_it);
             }
+            if (UpdateAddress(address, my_it->second)) ++numChanges;
+        }
+        numChanges += previousCache.size();
+
+        // all addresses known so far were checked
+        setForeignAddressIds.clear();
+        nCheckedAddresses = addressTable.size();
+    } else {
+        for (std::unordered_set<AddressId>::const_iterator it = setDirtyAddresses.begin(); it != setDirtyAddresses.end(); ++it) {
+            std::unordered_map<AddressId, CMPTally>::iterator my_it = mp_tally_map.find(*it);
+            if (my_it == mp_tally_map.end()) continue;
+
+            const std::string& address = addressTable.GetAddress(my_it->first);
+            if (!IsWalletAddress(my_it->first, address)) continue;
+            if (UpdateAddress(address, my_it->second)) ++numChanges;
         }
     }
+    setDirtyAddresses.clear();
+
     if (msc_debug_walletcache) PrintToLog("WALLETCACHE: Update finished - there were %d changes\n", numChanges);
     return numChanges;
 }
 
+/**
+ * Marks the balances of an address as changed, so the next update compares them with the cache.
+ *
+ * No addresses are collected, while a full update is pending anyway (e.g. during
+ * the initial scan, or when the cache isn't used at all).
+ */
+void WalletCacheMarkDirty(AddressId id)
+{
+    if (fAllAddressesDirty) return;
+
+    LOCK(cs_tally);
+    setDirtyAddresses.insert(id);
+}
+
+/**
+ * Marks all addresses as changed, e.g. after the state was cleared, so the next update checks the whole state.
+ */
+void WalletCacheMarkAllDirty()
+{
+    LOCK(cs_tally);
+    fAllAddressesDirty = true;
+    setDirtyAddresses.clear();
+}
+
+/**
+ * Returns the spendable wallet addresses with Counos balances, as of the last update.
+ */
+const std::set<std::string>& WalletCacheGetSpendableAddresses()
+{
+    return walletSpendableAddresses;
+}
 
 } // namespace mastercore
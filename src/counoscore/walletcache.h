@@ -3,12 +3,25 @@
 
 class uint256;
 
+#include <counoscore/addresstable.h>
+
+#include <set>
+#include <string>
 #include <vector>
 
 namespace mastercore
 {
 /** Updates the cache and returns whether any wallet addresses were changed */
 int WalletCacheUpdate();
+
+/** Marks the balances of an address as changed, so the next update compares them with the cache */
+void WalletCacheMarkDirty(AddressId id);
+
+/** Marks all addresses as changed, e.g. after the state was cleared, so the next update checks the whole state */
+void WalletCacheMarkAllDirty();
+
+/** Returns the spendable wallet addresses with Counos balances, as of the last update (requires cs_tally) */
+const std::set<std::string>& WalletCacheGetSpendableAddresses();
 }
 
 #endif // COUNOSH_COUNOSCORE_WALLETCACHE_H
@@ -6,7 +6,7 @@
 
 #include <crypto/chacha20.h>
 #include <crypto/common.h>
-#include <hash.h>
+#include <crypto/sha256.h>
 
 #include <cassert>
 #include <cstdio>
@@ -278,9 +278,10 @@ void Num3072::Divide(const Num3072& a)
 
 Num3072 MuHash3072::ToNum3072(Span<const unsigned char> in) {
     Num3072 out{};
-    uint256 hashed_in = (CHashWriter(SER_DISK, 0) << in).GetSHA256();
+    uint256 hashed_in;
+    CSHA256().Write(in.data(), in.size()).Finalize(hashed_in.begin());
     unsigned char tmp[BYTE_SIZE];
-    ChaCha20(hashed_in.data(), hashed_in.size()).Keystream(tmp, BYTE_SIZE);
+    ChaCha20(hashed_in.begin(), hashed_in.size()).Keystream(tmp, BYTE_SIZE);
     for (int i = 0; i < LIMBS; ++i) {
         if (sizeof(limb_t) == 4) {
             out.limbs[i] = ReadLE32(tmp + 4 * i);
@@ -310,7 +311,7 @@ void MuHash3072::Finalize(uint256& out) noexcept
         }
     }
 
-    out = (CHashWriter(SER_DISK, 0) << data).GetSHA256();
+    CSHA256().Write(data, sizeof(data)).Finalize(out.begin());
 }
 
 MuHash3072& MuHash3072::operator*=(const MuHash3072& mul) noexcept
@@ -333,6 +334,7 @@ MuHash3072& MuHash3072::Insert(Span<const unsigned char> in) noexcept {
 }
 
 MuHash3072& MuHash3072::Remove(Span<const unsigned char> in) noexcept {
-    m_numerator.Divide(ToNum3072(in));
+    // the inverse is only calculated once, when the hash is finalized
+    m_denominator.Multiply(ToNum3072(in));
     return *this;
 }
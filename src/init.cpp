@@ -63,6 +63,10 @@
 #include <stdio.h>
 #include <set>
 
+#include <counoscore/addressindex.h>
+#include <counoscore/dbbase.h>
+#include <counoscore/dbtransaction.h>
+#include <counoscore/scanner.h>
 #include <counoscore/version.h>
 
 #ifndef WIN32
@@ -174,6 +178,9 @@ void Interrupt(NodeContext& node)
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_counos_addressindex) {
+        g_counos_addressindex->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
 }
 
@@ -269,6 +276,10 @@ void Shutdown(NodeContext& node)
         g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_counos_addressindex) {
+        g_counos_addressindex->Stop();
+        g_counos_addressindex.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -494,6 +505,12 @@ void SetupServerArgs()
     gArgs.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounostx=<address>", "Enable publish processed Counos transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounosbalance=<address>", "Enable publish Counos balance change in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounostrade=<address>", "Enable publish Counos distributed exchange trade in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounostxhwm=<n>", strprintf("Set publish processed Counos transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounosbalancehwm=<n>", strprintf("Set publish Counos balance change outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubcounostradehwm=<n>", strprintf("Set publish Counos distributed exchange trade outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
@@ -503,6 +520,12 @@ void SetupServerArgs()
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubcounostx=<address>");
+    hidden_args.emplace_back("-zmqpubcounosbalance=<address>");
+    hidden_args.emplace_back("-zmqpubcounostrade=<address>");
+    hidden_args.emplace_back("-zmqpubcounostxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubcounosbalancehwm=<n>");
+    hidden_args.emplace_back("-zmqpubcounostradehwm=<n>");
 #endif
 
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -584,9 +607,16 @@ void SetupServerArgs()
     // TODO: translation
     gArgs.AddArg("-startclean", "Clear all persistence files on startup; triggers reparsing of Counos transactions (default: 0)", false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counostxcache", "The maximum number of transactions in the input transaction cache (default: 500000)", false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosdbcache", strprintf("The size of the block cache shared by the Counos Core databases in MiB (default: %d)", DEFAULT_COUNOS_DB_CACHE), false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosunifieddb", strprintf("Store the Counos Core databases in one database, which is synced to disk once per block (default: %u)", DEFAULT_COUNOS_UNIFIED_DB), false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosaddressindex", strprintf("Maintain an index of the Counos transactions of all addresses, used by the counos_listaddresstransactions rpc call (default: %u)", DEFAULT_COUNOS_ADDRESS_INDEX), false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosrpctxcache", strprintf("The maximum number of decoded transactions kept in memory for RPC lookups (default: %u)", DEFAULT_DECODED_TX_CACHE_SIZE), false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counosprogressfrequency", "Time in seconds after which the initial scanning progress is reported (default: 30)", false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counosseedblockfilter", "Set skipping of blocks without Counos transactions during initial scan (default: 1)", false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosscanthreads", strprintf("Number of threads used to read blocks ahead during initial scan and to classify the transactions of connected blocks (default: %d)", mastercore::DEFAULT_SCAN_THREADS), false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counosskipstoringstate", "Don't store state during initial synchronization until block n (faster, but may have to restart syncing after a shutdown)(default: 770000)", false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counospersisttext", "Also store the state in the legacy text files, in addition to the binary snapshots (default: 0)", false, OptionsCategory::COUNOS);
+    gArgs.AddArg("-counosnftaudit", "Verify the non-fungible token supply against a full scan of the token database after each block (default: 0)", false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counoslogfile", "The path of the log file (default: counoscore.log)", false, OptionsCategory::COUNOS);
     gArgs.AddArg("-counosdebug=<category>", "Enable or disable log categories, can be \"all\" or \"none\"", false, OptionsCategory::COUNOS);
     gArgs.AddArg("-autocommit", "Enable or disable broadcasting of transactions, when creating transactions (default: 1)", false, OptionsCategory::COUNOS);
@@ -1540,6 +1570,8 @@ bool AppInitMain(NodeContext& node)
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t counos_address_index_cache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-counosaddressindex", DEFAULT_COUNOS_ADDRESS_INDEX) ? nMaxCounosAddressIndexCache << 20 : 0);
+    nTotalCache -= counos_address_index_cache;
     int64_t filter_index_cache = 0;
     if (!g_enabled_filter_types.empty()) {
         size_t n_indexes = g_enabled_filter_types.size();
@@ -1557,6 +1589,9 @@ bool AppInitMain(NodeContext& node)
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (gArgs.GetBoolArg("-counosaddressindex", DEFAULT_COUNOS_ADDRESS_INDEX)) {
+        LogPrintf("* Using %.1f MiB for Counos address index database\n", counos_address_index_cache * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
@@ -1811,6 +1846,12 @@ bool AppInitMain(NodeContext& node)
 
     mastercore_init();
 
+    // the Counos address index is built from the Counos Core databases, so it's started once they are loaded
+    if (gArgs.GetBoolArg("-counosaddressindex", DEFAULT_COUNOS_ADDRESS_INDEX)) {
+        g_counos_addressindex = MakeUnique<CCounosAddressIndex>(counos_address_index_cache, false, fReindex);
+        g_counos_addressindex->Start();
+    }
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
@@ -0,0 +1 @@
+#define BUILD_SUFFIX 7f7cec2-dirty
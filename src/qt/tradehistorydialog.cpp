@@ -319,16 +319,12 @@ int TradeHistoryDialog::PopulateTradeHistoryMap()
         uint256 hash = it->second;
 
         // use levelDB to perform a fast check on whether it's a counosh or Counos tx and whether it's a trade
-        std::string tempStrValue;
+        CMPTxListRecord txRecord;
         {
             LOCK(cs_tally);
-            if (!pDbTransactionList->getTX(hash, tempStrValue)) continue;
-        }
-        std::vector<std::string> vstr;
-        boost::split(vstr, tempStrValue, boost::is_any_of(":"), boost::token_compress_on);
-        if (vstr.size() > 2) {
-            if (atoi(vstr[2]) != MSC_TYPE_METADEX_TRADE) continue;
+            if (!pDbTransactionList->getTX(hash, txRecord)) continue;
         }
+        if (txRecord.nType != MSC_TYPE_METADEX_TRADE) continue;
 
         // check historyMap, if this tx exists don't waste resources doing anymore work on it
         TradeHistoryMap::iterator hIter = tradeHistoryMap.find(hash);
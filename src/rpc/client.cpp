@@ -195,16 +195,22 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "counos_getgrants", 0, "propertyid" },
     { "counos_getbalance", 1, "propertyid" },
     { "counos_getproperty", 0, "propertyid" },
+    { "counos_listaddresstransactions", 1, "startblock" },
+    { "counos_listaddresstransactions", 2, "endblock" },
+    { "counos_listaddresstransactions", 4, "limit" },
     { "counos_listtransactions", 1, "count" },
     { "counos_listtransactions", 2, "skip" },
     { "counos_listtransactions", 3, "startblock" },
     { "counos_listtransactions", 4, "endblock" },
     { "counos_getallbalancesforid", 0, "propertyid" },
+    { "counos_getallbalancesforid", 2, "limit" },
+    { "counos_listproperties", 1, "limit" },
     { "counos_listblocktransactions", 0, "index" },
     { "counos_listblockstransactions", 0, "firstblock" },
     { "counos_listblockstransactions", 1, "lastblock" },
     { "counos_getorderbook", 0, "propertyid" },
-    { "counos_getorderbook", 1, "propertyid" },
+    { "counos_getorderbook", 1, "propertyiddesired" },
+    { "counos_getorderbook", 3, "limit" },
     { "counos_getseedblocks", 0, "startblock" },
     { "counos_getseedblocks", 1, "endblock" },
     { "counos_getmetadexhash", 0, "propertyid" },